@@ -1,4 +1,5 @@
 include_directories(${CMAKE_CURRENT_SOURCE_DIR}/includes/private)
+include_directories(${CMAKE_CURRENT_SOURCE_DIR}/includes/private/bench)
 include_directories(${CMAKE_CURRENT_SOURCE_DIR}/includes/private/bus)
 include_directories(${CMAKE_CURRENT_SOURCE_DIR}/includes/private/cdrom)
 include_directories(${CMAKE_CURRENT_SOURCE_DIR}/includes/private/codegen)
@@ -0,0 +1,47 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+
+/*pcem-bench microbenchmarks. Each benchmark runs one emulator hot path in
+  isolation, outside of a running machine.
+
+  init() sets up whatever state the benchmark needs and returns it, or NULL if
+  the benchmark can't run on this host (bench_skip() records why). run() does
+  the given number of iterations and returns the number of operations done, so
+  results can be compared as time per operation whatever an iteration is.
+  close() frees the state. All three are called on the main thread, with the
+  emulator core initialised by bench_core_init().*/
+typedef struct bench_t {
+        const char *name;
+        /*What one operation is, for the report*/
+        const char *unit;
+
+        void *(*init)();
+        uint64_t (*run)(void *p, int iterations);
+        void (*close)(void *p);
+} bench_t;
+
+/*Benchmark suites, each terminated by an entry with a NULL name*/
+extern bench_t bench_cpu[];
+extern bench_t bench_video[];
+extern bench_t bench_sound[];
+extern bench_t bench_disc[];
+
+/*Directory benchmarks may create scratch files in, with trailing separator*/
+extern char bench_tmp_path[512];
+
+/*Set up the emulator core with no frontend, sound going to the null sink. ROMs
+  are searched for in roms_path if not NULL, and pcem.log goes to
+  bench_tmp_path*/
+void bench_core_init(char *roms_path);
+void bench_core_close();
+/*Reset the emulated machine to a bare Pentium with 16MB RAM - no BIOS,
+  chipset or cards. Called by benchmarks that need timers, I/O or memory*/
+void bench_machine_init();
+/*Record why the benchmark being initialised was skipped*/
+void bench_skip(const char *reason);
+/*Build a scratch file name in bench_tmp_path*/
+void bench_tmp_file(char *s, const char *fn, int size);
+
+#endif /* _BENCH_H_ */
@@ -156,6 +156,9 @@ void cpu_RDMSR();
 void cpu_WRMSR();
 
 extern int cpu_use_dynarec;
+/*8088/8086 fast mode - no prefetch queue emulation, cycles are taken from the
+  per-opcode timings plus a fixed cost per bus access*/
+extern int cpu_808x_fast;
 
 extern uint64_t xt_cpu_multi;
 
@@ -0,0 +1,27 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <stdint.h>
+
+/*Sampling guest code profiler. When enabled, a timer samples the current
+  CS:EIP, physical address, CPL and whether a compiled block exists for that
+  address every profiler_interval us of emulated time. Code block invalidations
+  are also counted, to find code that keeps getting recompiled. The histogram is
+  written out in collapsed stack format (as used by flamegraph.pl) when the
+  emulator closes.
+
+  Samples are only ever added from the emulation thread, so the histogram needs
+  no locking. When disabled, the only cost is a test of profiler_enabled on
+  code block invalidation*/
+extern int profiler_enabled;
+extern int profiler_interval;
+extern char profiler_fn[512];
+
+/*Start sampling. Must be called after every timer_reset()*/
+void profiler_init();
+/*Write out the histogram and summary*/
+void profiler_close();
+
+void profiler_block_flushed(uint32_t phys, uint32_t pc);
+
+#endif /* _PROFILER_H_ */
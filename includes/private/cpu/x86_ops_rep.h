@@ -1,5 +1,20 @@
 #ifndef _X86_OPS_REP_H_
 #define _X86_OPS_REP_H_
+
+/*REP INSW/OUTSW can hand a whole run of words to a port block handler when the
+  buffer is directly mapped RAM. The run must not cross a page, or wrap the
+  index register*/
+static inline int rep_block_words(uint32_t addr, uint32_t index, int index_size, uint32_t count) {
+        uint32_t words = (0x1000 - (addr & 0xfff)) >> 1;
+
+        if (index_size == 2 && words > (0x10000 - index) >> 1)
+                words = (0x10000 - index) >> 1;
+        if (words > count)
+                words = count;
+
+        return words;
+}
+
 #define REP_OPS(size, CNT_REG, SRC_REG, DEST_REG)                                                                                \
         static int opREP_INSB_##size(uint32_t fetchdat) {                                                                        \
                 int reads = 0, writes = 0, total_cycles = 0;                                                                     \
@@ -36,25 +51,39 @@
                 int reads = 0, writes = 0, total_cycles = 0;                                                                     \
                                                                                                                                  \
                 if (CNT_REG > 0) {                                                                                               \
-                        uint16_t temp;                                                                                           \
+                        uint32_t addr;                                                                                           \
+                        int words = 0;                                                                                           \
                                                                                                                                  \
                         SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                      \
                         check_io_perm(DX);                                                                                       \
                         check_io_perm(DX + 1);                                                                                   \
-                        temp = inw(DX);                                                                                          \
-                        writememw(es, DEST_REG, temp);                                                                           \
-                        if (cpu_state.abrt)                                                                                      \
-                                return 1;                                                                                        \
+                        addr = es + DEST_REG;                                                                                    \
+                        if (!(cpu_state.flags & D_FLAG) && !(addr & 1) && writelookup2[addr >> 12] != -1) {                      \
+                                words = rep_block_words(addr, DEST_REG, sizeof(DEST_REG), CNT_REG);                              \
+                                words = insw_block(DX, (uint16_t *)(writelookup2[addr >> 12] + addr), words);                    \
+                                DEST_REG += words * 2;                                                                           \
+                                CNT_REG -= words;                                                                                \
+                                cycles -= words * 15;                                                                            \
+                                reads += words;                                                                                  \
+                                writes += words;                                                                                 \
+                                total_cycles += words * 15;                                                                      \
+                        }                                                                                                        \
+                        if (!words) {                                                                                            \
+                                uint16_t temp = inw(DX);                                                                         \
+                                writememw(es, DEST_REG, temp);                                                                   \
+                                if (cpu_state.abrt)                                                                              \
+                                        return 1;                                                                                \
                                                                                                                                  \
-                        if (cpu_state.flags & D_FLAG)                                                                            \
-                                DEST_REG -= 2;                                                                                   \
-                        else                                                                                                     \
-                                DEST_REG += 2;                                                                                   \
-                        CNT_REG--;                                                                                               \
-                        cycles -= 15;                                                                                            \
-                        reads++;                                                                                                 \
-                        writes++;                                                                                                \
-                        total_cycles += 15;                                                                                      \
+                                if (cpu_state.flags & D_FLAG)                                                                    \
+                                        DEST_REG -= 2;                                                                           \
+                                else                                                                                             \
+                                        DEST_REG += 2;                                                                           \
+                                CNT_REG--;                                                                                       \
+                                cycles -= 15;                                                                                    \
+                                reads++;                                                                                         \
+                                writes++;                                                                                        \
+                                total_cycles += 15;                                                                              \
+                        }                                                                                                        \
                 }                                                                                                                \
                 PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);                                                       \
                 if (CNT_REG > 0) {                                                                                               \
@@ -132,23 +161,40 @@
                 int reads = 0, writes = 0, total_cycles = 0;                                                                     \
                                                                                                                                  \
                 if (CNT_REG > 0) {                                                                                               \
-                        uint16_t temp;                                                                                           \
+                        uint32_t addr;                                                                                           \
+                        int words = 0;                                                                                           \
+                                                                                                                                 \
                         SEG_CHECK_READ(cpu_state.ea_seg);                                                                        \
-                        temp = readmemw(cpu_state.ea_seg->base, SRC_REG);                                                        \
-                        if (cpu_state.abrt)                                                                                      \
-                                return 1;                                                                                        \
-                        check_io_perm(DX);                                                                                       \
-                        check_io_perm(DX + 1);                                                                                   \
-                        outw(DX, temp);                                                                                          \
-                        if (cpu_state.flags & D_FLAG)                                                                            \
-                                SRC_REG -= 2;                                                                                    \
-                        else                                                                                                     \
-                                SRC_REG += 2;                                                                                    \
-                        CNT_REG--;                                                                                               \
-                        cycles -= 14;                                                                                            \
-                        reads++;                                                                                                 \
-                        writes++;                                                                                                \
-                        total_cycles += 14;                                                                                      \
+                        addr = cpu_state.ea_seg->base + SRC_REG;                                                                 \
+                        if (!(cpu_state.flags & D_FLAG) && !(addr & 1) && readlookup2[addr >> 12] != -1) {                       \
+                                check_io_perm(DX);                                                                               \
+                                check_io_perm(DX + 1);                                                                           \
+                                words = rep_block_words(addr, SRC_REG, sizeof(SRC_REG), CNT_REG);                                \
+                                words = outsw_block(DX, (uint16_t *)(readlookup2[addr >> 12] + addr), words);                    \
+                                SRC_REG += words * 2;                                                                            \
+                                CNT_REG -= words;                                                                                \
+                                cycles -= words * 14;                                                                            \
+                                reads += words;                                                                                  \
+                                writes += words;                                                                                 \
+                                total_cycles += words * 14;                                                                      \
+                        }                                                                                                        \
+                        if (!words) {                                                                                            \
+                                uint16_t temp = readmemw(cpu_state.ea_seg->base, SRC_REG);                                       \
+                                if (cpu_state.abrt)                                                                              \
+                                        return 1;                                                                                \
+                                check_io_perm(DX);                                                                               \
+                                check_io_perm(DX + 1);                                                                           \
+                                if (cpu_state.flags & D_FLAG)                                                                    \
+                                        SRC_REG -= 2;                                                                            \
+                                else                                                                                             \
+                                        SRC_REG += 2;                                                                            \
+                                outw(DX, temp);                                                                                  \
+                                CNT_REG--;                                                                                       \
+                                cycles -= 14;                                                                                    \
+                                reads++;                                                                                         \
+                                writes++;                                                                                        \
+                                total_cycles += 14;                                                                              \
+                        }                                                                                                        \
                 }                                                                                                                \
                 PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);                                                       \
                 if (CNT_REG > 0) {                                                                                               \
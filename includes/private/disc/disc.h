@@ -34,6 +34,10 @@ void disc_set_drivesel(int drive);
 void disc_set_motor_enable(int motor_enable);
 extern int disc_drivesel;
 
+/*Fast media mode for sector based images. Sector reads and writes complete
+  without waiting for the disc to rotate. Other formats are unaffected*/
+extern int disc_fast;
+
 void fdc_callback();
 int fdc_data(uint8_t dat);
 void fdc_spindown();
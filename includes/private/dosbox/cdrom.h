@@ -33,6 +33,10 @@
 //#include "SDL.h"
 //#include "SDL_thread.h"
 
+extern "C" {
+#include "thread.h"
+}
+
 #include <stdint.h>
 typedef signed int Bits;
 typedef unsigned int Bitu;
@@ -42,6 +46,8 @@ typedef int16_t Bit16s;
 typedef uint16_t Bit16u;
 typedef int32_t Bit32s;
 typedef uint32_t Bit32u;
+typedef int64_t Bit64s;
+typedef uint64_t Bit64u;
 
 typedef size_t PhysPt;
 
@@ -102,21 +108,49 @@ class CDROM_Interface_Image : public CDROM_Interface {
     private:
         class TrackFile {
             public:
-                virtual bool read(Bit8u *buffer, int seek, int count) = 0;
-                virtual int getLength() = 0;
+                virtual bool read(Bit8u *buffer, Bit64s seek, int count) = 0;
+                virtual Bit64s getLength() = 0;
                 virtual ~TrackFile(){};
         };
 
+        /*Image file reader. Reads go through an LRU cache of 64 kB blocks,
+          filled with positional reads (no shared file pointer), so the CD
+          audio thread and the emulation thread can read concurrently.
+          Sequential misses fetch several blocks ahead in one read*/
         class BinaryFile : public TrackFile {
             public:
                 BinaryFile(const char *filename, bool &error);
                 ~BinaryFile();
-                bool read(Bit8u *buffer, int seek, int count);
-                int getLength();
+                bool read(Bit8u *buffer, Bit64s seek, int count);
+                Bit64s getLength();
 
             private:
                 BinaryFile();
-                std::ifstream *file;
+
+                enum { CACHE_BLOCK_SHIFT = 16, CACHE_BLOCK_SIZE = 1 << CACHE_BLOCK_SHIFT, CACHE_BLOCKS = 32, READAHEAD_BLOCKS = 4 };
+
+                struct CacheBlock {
+                        Bit64s block;
+                        Bit32u last_used;
+                        int len;
+                        Bit8u *data;
+                };
+
+                CacheBlock *findBlock(Bit64s block);
+                CacheBlock *fetchBlocks(Bit64s block);
+                bool readFile(Bit8u *buffer, Bit64s seek, int count, int *actual);
+
+#if defined(WIN32)
+                void *handle;
+#else
+                int fd;
+#endif
+                Bit64s length;
+                CacheBlock cache[CACHE_BLOCKS];
+                Bit32u use_counter;
+                Bit64s last_miss;
+                Bit8u *readahead_buf;
+                mutex_t *lock;
         };
 
         struct Track {
@@ -125,7 +159,7 @@ class CDROM_Interface_Image : public CDROM_Interface {
                 int attr;
                 int start;
                 int length;
-                int skip;
+                Bit64s skip;
                 int sectorSize;
                 bool mode2;
                 TrackFile *file;
@@ -51,12 +51,15 @@ uint32_t mmutranslatereal(uint32_t addr, int rw);
 
 void addreadlookup(uint32_t virt, uint32_t phys);
 void addwritelookup(uint32_t virt, uint32_t phys);
+void addwritelookup_ptr(uint32_t virt, uint32_t phys, uint8_t *host);
 
 /*IO*/
 uint8_t inb(uint16_t port);
 void outb(uint16_t port, uint8_t val);
 uint16_t inw(uint16_t port);
 void outw(uint16_t port, uint16_t val);
+int insw_block(uint16_t port, uint16_t *buf, int count);
+int outsw_block(uint16_t port, const uint16_t *buf, int count);
 uint32_t inl(uint16_t port);
 void outl(uint16_t port, uint32_t val);
 
@@ -15,4 +15,12 @@ void io_removehandler(uint16_t base, int size, uint8_t (*inb)(uint16_t addr, voi
                       void (*outb)(uint16_t addr, uint8_t val, void *priv), void (*outw)(uint16_t addr, uint16_t val, void *priv),
                       void (*outl)(uint16_t addr, uint32_t val, void *priv), void *priv);
 
+/*Block transfer handlers for REP INSW/OUTSW. These move up to count words
+  between buf (guest RAM, little endian) and the port, and return the number
+  of words moved. The result must be identical to the same number of
+  inw()/outw() calls. Only one block handler may be installed per port*/
+void io_set_block_handler(uint16_t port, int (*insw)(uint16_t addr, uint16_t *buf, int count, void *priv),
+                          int (*outsw)(uint16_t addr, const uint16_t *buf, int count, void *priv), void *priv);
+void io_remove_block_handler(uint16_t port, void *priv);
+
 #endif /* _IO_H_ */
@@ -0,0 +1,34 @@
+#ifndef _IO_PROFILER_H_
+#define _IO_PROFILER_H_
+
+#include <stdint.h>
+
+struct mem_mapping_t;
+
+/*Device access profiler. When enabled, every port access through inb()/outb()
+  etc and every access that reaches a mem_mapping_t handler is counted and timed
+  with the host performance counter. The report ranks port ranges, memory
+  mappings and devices by host time spent in their handlers, and is written to
+  io_profiler_fn on demand (io_profiler_request_report()) and when the emulator
+  closes. Statistics cover the time since the last hard reset.
+
+  Accesses only happen on the emulation thread, so the tables need no locking.
+  When disabled, the only cost is a test of io_profiler_enabled per access that
+  misses the TLB or goes to a port*/
+extern int io_profiler_enabled;
+extern char io_profiler_fn[512];
+
+/*Clear all statistics. Called on every hard reset, as handler private
+  pointers are stale once the devices have been closed*/
+void io_profiler_reset();
+/*Write out the report, then free the tables*/
+void io_profiler_close();
+/*Ask for a report to be written. Safe to call from any thread; the report is
+  written from the emulation thread by io_profiler_poll()*/
+void io_profiler_request_report();
+void io_profiler_poll();
+
+void io_profiler_port(uint16_t port, void *priv, int write, uint64_t time);
+void io_profiler_mmio(struct mem_mapping_t *mapping, int write, uint64_t time);
+
+#endif /* _IO_PROFILER_H_ */
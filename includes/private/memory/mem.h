@@ -53,6 +53,7 @@ void mem_mapping_set_addr(mem_mapping_t *mapping, uint32_t base, uint32_t size);
 void mem_mapping_set_exec(mem_mapping_t *mapping, uint8_t *exec);
 void mem_mapping_disable(mem_mapping_t *mapping);
 void mem_mapping_enable(mem_mapping_t *mapping);
+mem_mapping_t *mem_get_write_mapping(uint32_t addr);
 
 void mem_set_mem_state(uint32_t base, uint32_t size, int state);
 
@@ -105,6 +106,8 @@ extern mem_mapping_t ram_remapped_mapping;
 extern uint64_t *byte_dirty_mask;
 extern uint64_t *byte_code_present_mask;
 
+extern int mem_huge_pages;
+
 #define PAGE_BYTE_MASK_SHIFT 6
 #define PAGE_BYTE_MASK_OFFSET_MASK 63
 #define PAGE_BYTE_MASK_MASK 63
@@ -210,6 +213,7 @@ void mem_set_704kb();
 void flushmmucache();
 void flushmmucache_nopc();
 void flushmmucache_cr3();
+void mem_flush_write_host_range(uint8_t *base, uint32_t size);
 
 void resetreadlookup();
 
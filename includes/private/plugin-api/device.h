@@ -20,5 +20,7 @@ int device_available(device_t *d);
 void device_speed_changed();
 void device_force_redraw();
 void device_add_status_info(char *s, int max_len);
+/*Find the device owning a handler's private pointer, or NULL*/
+device_t *device_find_for_priv(void *priv);
 
 #endif /* _DEVICE_H_ */
@@ -0,0 +1,69 @@
+#ifndef _SOUND_ASYNC_H_
+#define _SOUND_ASYNC_H_
+#include "sound.h"
+#include "thread.h"
+
+/*Asynchronous sound chip rendering.
+
+  Register writes are recorded on the emulation thread, tagged with the current
+  sample position (sound_pos_global), and placed in a single-producer /
+  single-consumer ring buffer. A worker thread replays the writes into the chip
+  core, rendering all samples up to each write's position first, so the output
+  is sample-identical to rendering inline in the I/O handler.
+
+  Reads (status, timers) must not depend on synthesis state, as they are
+  serviced on the emulation thread without waiting for the worker.
+
+  sound_async_sync() is called from the device's get_buffer handler; it waits
+  for the worker to finish the current block.*/
+
+#define SOUND_ASYNC_SIZE 8192
+#define SOUND_ASYNC_MASK (SOUND_ASYNC_SIZE - 1)
+
+enum {
+        SOUND_ASYNC_WRITE = 0,
+        SOUND_ASYNC_SYNC, /*Render up to pos*/
+        SOUND_ASYNC_END   /*Render up to pos, then start a new block*/
+};
+
+typedef struct sound_async_entry_t {
+        int pos;
+        uint16_t addr;
+        uint8_t val;
+        uint8_t type : 4;
+        uint8_t chan : 4;
+} sound_async_entry_t;
+
+typedef struct sound_async_t {
+        sound_async_entry_t queue[SOUND_ASYNC_SIZE];
+        volatile uint32_t read_idx, write_idx;
+
+        /*Owned by worker thread*/
+        int pos;
+
+        /*Render samples [pos, end) of the current block into the device buffer*/
+        void (*update)(int pos, int end, void *p);
+        /*Apply a register write to the chip core. chan is device defined*/
+        void (*write)(int chan, uint16_t addr, uint8_t val, void *p);
+        void *priv;
+
+        pc_timer_t tick_timer;
+
+        thread_t *thread;
+        event_t *wake_event;
+        event_t *done_event;
+} sound_async_t;
+
+/*Non-zero if sound chips should render on worker threads. Read at device init.
+  Off by default - the OPL emulators in sound_dbopl.cc keep their state in the
+  global opl[] array, so two OPL devices would render into it from two threads*/
+extern int sound_async;
+
+sound_async_t *sound_async_init(void (*update)(int pos, int end, void *p), void (*write)(int chan, uint16_t addr, uint8_t val, void *p),
+                                void *p);
+void sound_async_close(sound_async_t *async);
+
+void sound_async_write(sound_async_t *async, int chan, uint16_t addr, uint8_t val);
+void sound_async_sync(sound_async_t *async);
+
+#endif /* _SOUND_ASYNC_H_ */
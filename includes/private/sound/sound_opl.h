@@ -11,6 +11,9 @@ typedef struct opl_t {
 
         int16_t buffer[MAXSOUNDBUFLEN * 2];
         int pos;
+
+        /*Non-NULL if synthesis runs on a worker thread*/
+        struct sound_async_t *async;
 } opl_t;
 
 uint8_t opl2_read(uint16_t a, void *priv);
@@ -27,6 +30,7 @@ void opl3_poll(opl_t *opl, int16_t *bufl, int16_t *bufr);
 
 void opl2_init(opl_t *opl);
 void opl3_init(opl_t *opl, int opl_emu);
+void opl_close(opl_t *opl);
 
 void opl2_update2(opl_t *opl);
 void opl3_update2(opl_t *opl);
@@ -0,0 +1,48 @@
+#ifndef _SOUND_OUT_H_
+#define _SOUND_OUT_H_
+
+#include <stdio.h>
+
+/*Host audio output.
+
+  The emulation thread pushes mixed blocks into a lock-free single-producer /
+  single-consumer ring with sound_out_write(). A host audio thread (OpenAL, or
+  the null/file sink) pulls frames with sound_out_read(), which resamples
+  slightly faster or slower than 48 kHz to keep the ring fill level at the
+  requested target. This absorbs emulation speed drift without dropouts or
+  latency creep.*/
+
+enum { SOUND_SINK_OPENAL = 0, SOUND_SINK_NULL, SOUND_SINK_FILE };
+
+/*Output sink, read at sound_init()*/
+extern int sound_sink;
+/*WAV file written by SOUND_SINK_FILE*/
+extern char sound_sink_fn[512];
+
+/*Blocks dropped because the ring was full*/
+extern volatile int sound_out_overruns;
+/*Host reads that ran out of buffered frames*/
+extern volatile int sound_out_underruns;
+
+void sound_out_reset();
+
+/*Convert and push len stereo frames. Emulation thread only*/
+void sound_out_write(int32_t *buf, int len);
+/*Pull len resampled stereo frames, aiming for target frames buffered. Host
+  audio thread only. Returns number of frames read from the ring*/
+int sound_out_read(int16_t *buf, int len, int target);
+/*Number of frames currently buffered*/
+int sound_out_fill();
+
+/*Saturate samples 32-bit -> 16-bit*/
+void sound_out_convert(int16_t *dest, const int32_t *src, int samples);
+
+/*Write or rewrite the header of a 48 kHz 16-bit stereo WAV file holding bytes
+  of sample data, leaving the file position at the end*/
+void sound_out_wav_header(FILE *f, uint32_t bytes);
+
+/*Null and WAV file sinks, clocked from the host timer*/
+void sound_out_sink_init();
+void sound_out_sink_close();
+
+#endif /* _SOUND_OUT_H_ */
@@ -0,0 +1,41 @@
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <stdint.h>
+
+/*Performance telemetry. Subsystems register named values with the registry, and
+  while enabled the sampler writes all of them out every telemetry_interval ms of
+  host time, either as JSON lines or CSV, to telemetry_fn. A file name of the
+  form "unix:/path" connects to a Unix domain socket instead; a sample is
+  dropped rather than stalling emulation if the reader falls behind.
+
+  Gauges are reported as their current value. Counters must only ever increase
+  (other than being reset on device init) and are reported as a rate per second.
+  The registry only stores pointers to the values, so updating a counter is a
+  plain increment on whichever thread owns it; the sampler reads values owned by
+  other threads with a single aligned load, and never writes them.
+
+  Registration and sampling are done on the emulation thread.*/
+extern int telemetry_enabled;
+extern int telemetry_interval;
+extern int telemetry_format;
+extern char telemetry_fn[512];
+
+enum { TELEMETRY_FORMAT_JSON = 0, TELEMETRY_FORMAT_CSV };
+
+void telemetry_add_gauge_int(const char *name, volatile int *val);
+void telemetry_add_gauge_float(const char *name, volatile float *val);
+void telemetry_add_gauge_func(const char *name, double (*get)(void *p), void *p);
+void telemetry_add_counter_int(const char *name, volatile int *val);
+void telemetry_add_counter_u64(const char *name, volatile uint64_t *val);
+/*Remove all values registered with the given value pointer or callback
+  parameter. Devices must call this before freeing their state*/
+void telemetry_remove(const void *p);
+
+/*Register the core emulator values. Called once at startup*/
+void telemetry_init();
+/*Called once per runpc() slice. Writes a sample when one is due*/
+void telemetry_poll();
+void telemetry_close();
+
+#endif /* _TELEMETRY_H_ */
@@ -30,6 +30,9 @@ typedef struct pc_timer_t {
   when TSC matches or exceeds this.*/
 extern uint32_t timer_target;
 
+/*Number of timer callbacks run, for telemetry*/
+extern uint64_t timer_callbacks;
+
 /*Enable timer, without updating timestamp*/
 void timer_enable(pc_timer_t *timer);
 /*Disable timer*/
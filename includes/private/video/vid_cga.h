@@ -33,6 +33,8 @@ typedef struct cga_t {
         int revision;
         int composite;
         int snow_enabled;
+
+        int frameskip, frameskip_count;
 } cga_t;
 
 void cga_init(cga_t *cga);
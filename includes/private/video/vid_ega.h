@@ -65,6 +65,8 @@ typedef struct ega_t {
 
         int video_res_x, video_res_y, video_bpp;
         int frames;
+
+        int frameskip, frameskip_count;
 } ega_t;
 
 void *ega_standalone_init();
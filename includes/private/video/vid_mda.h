@@ -22,6 +22,8 @@ typedef struct mda_t {
         int vsynctime, vadj;
 
         uint8_t *vram;
+
+        int frameskip, frameskip_count;
 } mda_t;
 
 void mda_init(mda_t *mda);
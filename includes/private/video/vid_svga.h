@@ -139,6 +139,9 @@ typedef struct svga_t {
         int override;
         void *p;
 
+        /*Set if the current frame isn't being drawn, see video_frameskip()*/
+        int frameskip, frameskip_count;
+
         uint8_t ksc5601_sbyte_mask;
         uint8_t ksc5601_udc_area_msb[2];
         int ksc5601_swap_mode;
@@ -158,8 +161,22 @@ typedef struct svga_t {
 
         int remap_required;
         uint32_t (*remap_func)(struct svga_t *svga, uint32_t in_addr);
+
+        /*Linear framebuffer pages that have been handed to the CPU TLB for direct
+          writes (one bit per 4kB of VRAM). These writes bypass changedvram, so
+          every page in here is marked changed at each vsync*/
+        uint32_t *lfb_tlb_map;
+        uint32_t lfb_tlb_vram_size;
+        int lfb_tlb_active;
+
+        /*Deferred frame composition state, NULL if svga_compose_threads is 0*/
+        struct svga_compose_t *compose;
 } svga_t;
 
+/*If set, linear framebuffer writes in packed-pixel modes are mapped through the
+  CPU TLB and go straight to VRAM*/
+extern int svga_lfb_direct;
+
 extern int svga_init(svga_t *svga, void *p, int memsize, void (*recalctimings_ex)(struct svga_t *svga),
                      uint8_t (*video_in)(uint16_t addr, void *p), void (*video_out)(uint16_t addr, uint8_t val, void *p),
                      void (*hwcursor_draw)(struct svga_t *svga, int displine),
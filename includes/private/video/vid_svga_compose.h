@@ -0,0 +1,103 @@
+#ifndef _VID_SVGA_COMPOSE_H_
+#define _VID_SVGA_COMPOSE_H_
+
+#include "thread.h"
+
+/*Deferred SVGA frame composition.
+
+  svga_poll() normally calls the render function for each displayed line as it
+  is reached. With svga_compose_threads set, lines drawn by the generic
+  svga_render_*() functions are only recorded, along with the display state
+  they are drawn from - render function, start and cursor address, row scan,
+  cursor and blink state, horizontal scroll and width, and palette. At vsync
+  the frame is drawn in one go, split between the worker threads and the
+  emulation thread.
+
+  The emulation thread waits for the workers before it carries on, so VRAM and
+  changedvram can't change under them and no copy of either is needed. As every
+  write since the last composition is still marked in changedvram, no changes
+  are missed. Start address, split screen and palette changes made mid-frame
+  are kept through the recorded line state. The rest of what the renderers read
+  is taken when the lines are drawn, so any lines recorded so far are drawn
+  first whenever it changes - in svga_recalctimings() for address remapping and
+  display masks, and in svga_out() for the clocking mode, character map select,
+  attribute mode control and plane mask registers.
+
+  Lines with the hardware cursor or an overlay on them, and lines drawn by card
+  specific render functions, are still drawn inline*/
+extern int svga_compose_threads;
+
+#define SVGA_COMPOSE_MAX_THREADS 8
+
+/*Lines recorded before they are drawn without waiting for vsync*/
+#define SVGA_COMPOSE_MAX_LINES 2048
+/*Distinct palettes recorded before the same happens*/
+#define SVGA_COMPOSE_MAX_PALETTES 16
+
+/*Fewer lines than this are drawn on the emulation thread alone*/
+#define SVGA_COMPOSE_MIN_SPLIT 32
+
+struct svga_t;
+
+typedef struct svga_compose_line_t {
+        void (*render)(struct svga_t *svga);
+        uint32_t ma, ca;
+        int displine;
+        int sc, con, cursoron, blink;
+        int scrollcache, hdisp;
+        int fullchange;
+        int palette; /*Index into palettes[], -1 if the renderer doesn't use it*/
+} svga_compose_line_t;
+
+typedef struct svga_compose_palette_t {
+        uint32_t pallook[256];
+        uint8_t egapal[16];
+} svga_compose_palette_t;
+
+typedef struct svga_compose_worker_t {
+        struct svga_compose_t *compose;
+
+        /*Copy of the card state that lines are drawn through, so the emulation
+          thread's svga_t isn't written to*/
+        struct svga_t *svga;
+        int start, end;
+        /*Set by the emulation thread when lines are handed over, cleared by the
+          worker once they are drawn. Events can be missed if they are set
+          before the other side waits, so both sides poll this*/
+        int busy;
+
+        thread_t *thread;
+        event_t *wake_event;
+        event_t *done_event;
+} svga_compose_worker_t;
+
+typedef struct svga_compose_t {
+        struct svga_t *svga;
+
+        svga_compose_line_t lines[SVGA_COMPOSE_MAX_LINES];
+        int nr_lines;
+
+        svga_compose_palette_t palettes[SVGA_COMPOSE_MAX_PALETTES];
+        int nr_palettes;
+
+        /*Classification of the last render function seen*/
+        void (*last_render)(struct svga_t *svga);
+        int last_type;
+
+        /*Entry 0 is the emulation thread's share, and has no thread*/
+        svga_compose_worker_t workers[SVGA_COMPOSE_MAX_THREADS + 1];
+        int nr_threads;
+} svga_compose_t;
+
+/*Returns NULL if nr_threads is 0*/
+svga_compose_t *svga_compose_init(struct svga_t *svga, int nr_threads);
+void svga_compose_close(svga_compose_t *compose);
+
+/*Record the line svga_poll() is about to draw. Returns 0 if it has to be drawn
+  inline instead*/
+int svga_compose_line(svga_compose_t *compose);
+/*Draw all recorded lines into buffer32, and update firstline_draw and
+  lastline_draw*/
+void svga_compose_flush(svga_compose_t *compose);
+
+#endif /* _VID_SVGA_COMPOSE_H_ */
@@ -0,0 +1,192 @@
+#ifndef _VID_VOODOO_CODEGEN_CACHE_H_
+#define _VID_VOODOO_CODEGEN_CACHE_H_
+
+/*Cache of generated pixel pipelines. There is one cache per voodoo_t, shared by
+  all of its render threads. Pipelines are found through a hash of the state
+  they were generated for; on a miss the least recently used pipeline that no
+  render thread is currently running is replaced.
+
+  Lookups and replacement are done under cache->lock. A render thread holds a
+  reference to the pipeline it got from voodoo_get_block() until it calls
+  voodoo_put_block() at the end of the triangle, so a pipeline is never
+  regenerated while it is running*/
+
+#define VOODOO_CODEGEN_CACHE_DEFAULT 64
+#define VOODOO_CODEGEN_CACHE_MIN 16
+
+typedef struct voodoo_codegen_key_t {
+        int xdir;
+        uint32_t alphaMode;
+        uint32_t fbzMode;
+        uint32_t fogMode;
+        uint32_t fbzColorPath;
+        uint32_t textureMode[2];
+        uint32_t tLOD[2];
+        uint32_t trexInit1;
+        int is_tiled;
+} voodoo_codegen_key_t;
+
+typedef struct voodoo_codegen_entry_t {
+        voodoo_codegen_key_t key;
+        uint32_t hash;
+        int valid;
+        int next;   /*Next entry in this hash chain, -1 if none*/
+        int in_use; /*Number of render threads running this pipeline*/
+        uint32_t last_used;
+} voodoo_codegen_entry_t;
+
+typedef struct voodoo_codegen_cache_t {
+        uint8_t *code; /*nr_entries * BLOCK_SIZE bytes of executable memory*/
+        size_t code_size;
+        voodoo_codegen_entry_t *entries;
+        int nr_entries;
+        int *hash_table;
+        int hash_mask;
+        uint32_t clock;
+        mutex_t *lock;
+} voodoo_codegen_cache_t;
+
+static inline void voodoo_codegen_get_key(voodoo_codegen_key_t *key, voodoo_t *voodoo, voodoo_params_t *params,
+                                          voodoo_state_t *state) {
+        memset(key, 0, sizeof(voodoo_codegen_key_t));
+        key->xdir = state->xdir;
+        key->alphaMode = params->alphaMode;
+        key->fbzMode = params->fbzMode;
+        key->fogMode = params->fogMode;
+        key->fbzColorPath = params->fbzColorPath;
+        key->trexInit1 = voodoo->trexInit1[0] & (1 << 18);
+        key->textureMode[0] = params->textureMode[0];
+        key->textureMode[1] = params->textureMode[1];
+        key->tLOD[0] = params->tLOD[0] & LOD_MASK;
+        key->tLOD[1] = params->tLOD[1] & LOD_MASK;
+        key->is_tiled = (params->col_tiled || params->aux_tiled) ? 1 : 0;
+}
+
+/*FNV-1a over the key*/
+static inline uint32_t voodoo_codegen_hash(voodoo_codegen_key_t *key) {
+        uint8_t *p = (uint8_t *)key;
+        uint32_t hash = 0x811c9dc5;
+        int c;
+
+        for (c = 0; c < sizeof(voodoo_codegen_key_t); c++)
+                hash = (hash ^ p[c]) * 0x01000193;
+
+        return hash;
+}
+
+static inline int voodoo_codegen_cache_find(voodoo_codegen_cache_t *cache, voodoo_codegen_key_t *key, uint32_t hash) {
+        int entry = cache->hash_table[hash & cache->hash_mask];
+
+        while (entry != -1) {
+                voodoo_codegen_entry_t *e = &cache->entries[entry];
+
+                if (e->hash == hash && !memcmp(&e->key, key, sizeof(voodoo_codegen_key_t)))
+                        return entry;
+
+                entry = e->next;
+        }
+
+        return -1;
+}
+
+/*Pick the entry to generate a new pipeline into and move it to the hash chain
+  for key. Unused entries are taken first, then the least recently used entry
+  that isn't currently running*/
+static inline int voodoo_codegen_cache_replace(voodoo_codegen_cache_t *cache, voodoo_codegen_key_t *key, uint32_t hash) {
+        voodoo_codegen_entry_t *e;
+        uint32_t oldest_age = 0;
+        int victim = -1;
+        int *prev;
+        int c;
+
+        for (c = 0; c < cache->nr_entries; c++) {
+                e = &cache->entries[c];
+
+                if (!e->valid) {
+                        victim = c;
+                        break;
+                }
+                if (!__atomic_load_n(&e->in_use, __ATOMIC_ACQUIRE) && (cache->clock - e->last_used) >= oldest_age) {
+                        oldest_age = cache->clock - e->last_used;
+                        victim = c;
+                }
+        }
+        if (victim == -1)
+                fatal("voodoo_codegen_cache_replace : all %i pipelines in use\n", cache->nr_entries);
+
+        e = &cache->entries[victim];
+        if (e->valid) {
+                prev = &cache->hash_table[e->hash & cache->hash_mask];
+                while (*prev != victim)
+                        prev = &cache->entries[*prev].next;
+                *prev = e->next;
+        }
+
+        e->key = *key;
+        e->hash = hash;
+        e->valid = 1;
+        e->next = cache->hash_table[hash & cache->hash_mask];
+        cache->hash_table[hash & cache->hash_mask] = victim;
+
+        return victim;
+}
+
+static inline uint8_t *voodoo_codegen_cache_acquire(voodoo_codegen_cache_t *cache, int entry) {
+        voodoo_codegen_entry_t *e = &cache->entries[entry];
+
+        e->last_used = ++cache->clock;
+        __atomic_add_fetch(&e->in_use, 1, __ATOMIC_ACQUIRE);
+
+        return &cache->code[entry * BLOCK_SIZE];
+}
+
+static inline void voodoo_put_block(voodoo_t *voodoo, void *code_block) {
+        voodoo_codegen_cache_t *cache = voodoo->codegen_data;
+        int entry = ((uint8_t *)code_block - cache->code) / BLOCK_SIZE;
+
+        __atomic_sub_fetch(&cache->entries[entry].in_use, 1, __ATOMIC_RELEASE);
+}
+
+/*Set up the cache bookkeeping for code, which must already be allocated with
+  room for nr_entries pipelines*/
+static inline voodoo_codegen_cache_t *voodoo_codegen_cache_create(uint8_t *code, size_t code_size, int nr_entries) {
+        voodoo_codegen_cache_t *cache = malloc(sizeof(voodoo_codegen_cache_t));
+        int hash_size = 1;
+        int c;
+
+        memset(cache, 0, sizeof(voodoo_codegen_cache_t));
+        cache->code = code;
+        cache->code_size = code_size;
+        cache->nr_entries = nr_entries;
+        cache->entries = malloc(sizeof(voodoo_codegen_entry_t) * nr_entries);
+        memset(cache->entries, 0, sizeof(voodoo_codegen_entry_t) * nr_entries);
+
+        /*At least two buckets per entry, to keep chains short*/
+        while (hash_size < nr_entries * 2)
+                hash_size <<= 1;
+        cache->hash_table = malloc(sizeof(int) * hash_size);
+        for (c = 0; c < hash_size; c++)
+                cache->hash_table[c] = -1;
+        cache->hash_mask = hash_size - 1;
+
+        cache->lock = thread_create_mutex();
+
+        return cache;
+}
+
+static inline void voodoo_codegen_cache_destroy(voodoo_codegen_cache_t *cache) {
+        thread_destroy_mutex(cache->lock);
+        free(cache->hash_table);
+        free(cache->entries);
+        free(cache);
+}
+
+/*Number of pipelines to cache for this card. Configurations without the option
+  get the default*/
+static inline int voodoo_codegen_cache_entries(voodoo_t *voodoo) {
+        if (voodoo->codegen_cache_size < VOODOO_CODEGEN_CACHE_MIN)
+                return VOODOO_CODEGEN_CACHE_DEFAULT;
+        return voodoo->codegen_cache_size;
+}
+
+#endif /* _VID_VOODOO_CODEGEN_CACHE_H_ */
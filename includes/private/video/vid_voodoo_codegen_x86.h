@@ -20,27 +20,11 @@
 
 #include <xmmintrin.h>
 
-#define BLOCK_NUM 8
-#define BLOCK_MASK (BLOCK_NUM - 1)
 #define BLOCK_SIZE 8192
 
 #define LOD_MASK (LOD_TMIRROR_S | LOD_TMIRROR_T)
 
-typedef struct voodoo_x86_data_t {
-        uint8_t code_block[BLOCK_SIZE];
-        int xdir;
-        uint32_t alphaMode;
-        uint32_t fbzMode;
-        uint32_t fogMode;
-        uint32_t fbzColorPath;
-        uint32_t textureMode[2];
-        uint32_t tLOD[2];
-        uint32_t trexInit1;
-        int is_tiled;
-} voodoo_x86_data_t;
-
-static int last_block[4] = {0, 0};
-static int next_block_to_write[4] = {0, 0};
+#include "vid_voodoo_codegen_cache.h"
 
 #define addbyte(val)                                                                                                             \
         do {                                                                                                                     \
@@ -3107,53 +3091,34 @@ static inline void voodoo_generate(uint8_t *code_block, voodoo_t *voodoo, voodoo
         if (params->textureMode[1] & TEXTUREMODE_TRILINEAR)
                 cs = cs;
 }
-int voodoo_recomp = 0;
-
 static inline void *voodoo_get_block(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int odd_even) {
-        int c;
-        int b = last_block[odd_even];
-        voodoo_x86_data_t *data;
-        voodoo_x86_data_t *codegen_data = voodoo->codegen_data;
-
-        for (c = 0; c < 8; c++) {
-                data = &codegen_data[odd_even + b * 4];
-
-                if (state->xdir == data->xdir && params->alphaMode == data->alphaMode && params->fbzMode == data->fbzMode &&
-                    params->fogMode == data->fogMode && params->fbzColorPath == data->fbzColorPath &&
-                    (voodoo->trexInit1[0] & (1 << 18)) == data->trexInit1 && params->textureMode[0] == data->textureMode[0] &&
-                    params->textureMode[1] == data->textureMode[1] && (params->tLOD[0] & LOD_MASK) == data->tLOD[0] &&
-                    (params->tLOD[1] & LOD_MASK) == data->tLOD[1] &&
-                    ((params->col_tiled || params->aux_tiled) ? 1 : 0) == data->is_tiled) {
-                        last_block[odd_even] = b;
-                        return data->code_block;
-                }
-
-                b = (b + 1) & 7;
-        }
-        voodoo_recomp++;
-        data = &codegen_data[odd_even + next_block_to_write[odd_even] * 4];
-        //        code_block = data->code_block;
-
-        voodoo_generate(data->code_block, voodoo, params, state, depth_op);
-
-        data->xdir = state->xdir;
-        data->alphaMode = params->alphaMode;
-        data->fbzMode = params->fbzMode;
-        data->fogMode = params->fogMode;
-        data->fbzColorPath = params->fbzColorPath;
-        data->trexInit1 = voodoo->trexInit1[0] & (1 << 18);
-        data->textureMode[0] = params->textureMode[0];
-        data->textureMode[1] = params->textureMode[1];
-        data->tLOD[0] = params->tLOD[0] & LOD_MASK;
-        data->tLOD[1] = params->tLOD[1] & LOD_MASK;
-        data->is_tiled = (params->col_tiled || params->aux_tiled) ? 1 : 0;
-
-        next_block_to_write[odd_even] = (next_block_to_write[odd_even] + 1) & 7;
-
-        return data->code_block;
+        voodoo_codegen_cache_t *cache = voodoo->codegen_data;
+        voodoo_codegen_key_t key;
+        uint8_t *code_block;
+        uint32_t hash;
+        int entry;
+
+        voodoo_codegen_get_key(&key, voodoo, params, state);
+        hash = voodoo_codegen_hash(&key);
+
+        thread_lock_mutex(cache->lock);
+        entry = voodoo_codegen_cache_find(cache, &key, hash);
+        if (entry == -1) {
+                voodoo->codegen_misses++;
+                entry = voodoo_codegen_cache_replace(cache, &key, hash);
+                voodoo_generate(&cache->code[entry * BLOCK_SIZE], voodoo, params, state, depth_op);
+        } else
+                voodoo->codegen_hits++;
+        code_block = voodoo_codegen_cache_acquire(cache, entry);
+        thread_unlock_mutex(cache->lock);
+
+        return code_block;
 }
 
 void voodoo_codegen_init(voodoo_t *voodoo) {
+        uint8_t *code;
+        size_t code_size;
+        int nr_entries;
         int c;
 #if defined(__linux__) || defined(__APPLE__)
         void *start;
@@ -3162,12 +3127,14 @@ void voodoo_codegen_init(voodoo_t *voodoo) {
         long pagemask = ~(pagesize - 1);
 #endif
 
+        nr_entries = voodoo_codegen_cache_entries(voodoo);
+        code_size = (size_t)nr_entries * BLOCK_SIZE;
 #if defined WIN32 || defined _WIN32 || defined _WIN32
-        voodoo->codegen_data = VirtualAlloc(NULL, sizeof(voodoo_x86_data_t) * BLOCK_NUM * 4, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+        code = VirtualAlloc(NULL, code_size, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
 #else
-        voodoo->codegen_data = mmap(0, sizeof(voodoo_x86_data_t) * BLOCK_NUM * 4, PROT_READ | PROT_WRITE | PROT_EXEC,
-                                    MAP_ANON | MAP_PRIVATE, 0, 0);
+        code = mmap(0, code_size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_ANON | MAP_PRIVATE, 0, 0);
 #endif
+        voodoo->codegen_data = voodoo_codegen_cache_create(code, code_size, nr_entries);
 
         for (c = 0; c < 256; c++) {
                 int d[4];
@@ -3193,11 +3160,14 @@ void voodoo_codegen_init(voodoo_t *voodoo) {
 }
 
 void voodoo_codegen_close(voodoo_t *voodoo) {
+        voodoo_codegen_cache_t *cache = voodoo->codegen_data;
+
 #if defined WIN32 || defined _WIN32 || defined _WIN32
-        VirtualFree(voodoo->codegen_data, 0, MEM_RELEASE);
+        VirtualFree(cache->code, 0, MEM_RELEASE);
 #else
-        munmap(voodoo->codegen_data, sizeof(voodoo_x86_data_t) * BLOCK_NUM * 4);
+        munmap(cache->code, cache->code_size);
 #endif
+        voodoo_codegen_cache_destroy(cache);
 }
 
 #endif /* _VID_VOODOO_CODEGEN_X86_H_ */
@@ -57,9 +57,24 @@ enum {
         FIFO_WRITEW_FB = (0x02 << 24),
         FIFO_WRITEL_FB = (0x03 << 24),
         FIFO_WRITEL_TEX = (0x04 << 24),
-        FIFO_WRITEL_2DREG = (0x05 << 24)
+        FIFO_WRITEL_2DREG = (0x05 << 24),
+        FIFO_WRITEL_FB_SPAN = (0x06 << 24) /*Value is the index of the span in lfb_spans*/
 };
 
+/*Combined LFB writes. A span covers consecutive 32-bit writes within one 2kB
+  block of the LFB address space, so never crosses a row*/
+#define LFB_SPAN_SIZE 64
+#define LFB_SPAN_MASK (LFB_SPAN_SIZE - 1)
+#define LFB_SPAN_MAX 512
+
+#define LFB_SPAN_FULL ((voodoo->lfb_span_write_idx - voodoo->lfb_span_read_idx) >= LFB_SPAN_SIZE)
+
+typedef struct voodoo_lfb_span_t {
+        uint32_t addr;
+        int count;
+        uint32_t data[LFB_SPAN_MAX];
+} voodoo_lfb_span_t;
+
 #define PARAM_SIZE 1024
 #define PARAM_MASK (PARAM_SIZE - 1)
 #define PARAM_ENTRY_SIZE (1 << 31)
@@ -215,6 +230,8 @@ typedef struct voodoo_t {
         mutex_t *swap_mutex;
         int swap_count;
 
+        struct voodoo_scanout_t *scanout;
+
         int disp_buffer, draw_buffer;
         pc_timer_t timer;
 
@@ -275,6 +292,10 @@ typedef struct voodoo_t {
 
         fifo_entry_t fifo[FIFO_SIZE];
         volatile int fifo_read_idx, fifo_write_idx;
+
+        voodoo_lfb_span_t *lfb_spans;
+        volatile int lfb_span_read_idx, lfb_span_write_idx;
+        int lfb_span_open; /*Span at lfb_span_write_idx is being filled*/
         volatile int cmd_read, cmd_written, cmd_written_fifo;
 
         voodoo_params_t params_buffer[PARAM_SIZE];
@@ -401,6 +422,9 @@ typedef struct voodoo_t {
 
                 int src_bpp;
 
+                /*Source pixels for a row drawn by the blitter fast paths*/
+                uint8_t row_data[8192 * 4];
+
                 int line_pix_pos, line_bit_pos;
                 int line_rep_cnt, line_bit_mask_size;
         } banshee_blt;
@@ -423,10 +447,12 @@ typedef struct voodoo_t {
         rgb_t clutData[33];
         int clutData_dirty;
         rgb_t clutData256[256];
+        int clut_linear; /*clutData256[] maps every value to itself*/
         uint32_t video_16to32[0x10000];
 
         uint8_t dirty_line[2048];
         int dirty_line_low, dirty_line_high;
+        int frameskip, frameskip_count;
 
         int fb_write_buffer, fb_draw_buffer;
         int buffer_cutoff;
@@ -458,6 +484,8 @@ typedef struct voodoo_t {
 
         int use_recompiler;
         void *codegen_data;
+        int codegen_cache_size;
+        int codegen_hits, codegen_misses;
 
         struct voodoo_set_t *set;
 
@@ -474,6 +502,8 @@ typedef struct voodoo_set_t {
         mem_mapping_t snoop_mapping;
 
         int nr_cards;
+
+        struct voodoo_trace_t *trace; /*NULL unless capturing*/
 } voodoo_set_t;
 
 extern rgba8_t rgb332[0x100], ai44[0x100], rgb565[0x10000], argb1555[0x10000], argb4444[0x10000], ai88[0x10000];
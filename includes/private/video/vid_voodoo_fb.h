@@ -4,5 +4,6 @@ uint16_t voodoo_fb_readw(uint32_t addr, void *p);
 uint32_t voodoo_fb_readl(uint32_t addr, void *p);
 void voodoo_fb_writew(uint32_t addr, uint16_t val, void *p);
 void voodoo_fb_writel(uint32_t addr, uint32_t val, void *p);
+void voodoo_fb_writel_span(voodoo_t *voodoo, uint32_t addr, uint32_t *data, int count);
 
 #endif /* _VID_VOODOO_FB_H_ */
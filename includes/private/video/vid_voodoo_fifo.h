@@ -4,6 +4,9 @@ void voodoo_wake_fifo_thread(voodoo_t *voodoo);
 void voodoo_wake_fifo_thread_now(voodoo_t *voodoo);
 void voodoo_wake_timer(void *p);
 void voodoo_queue_command(voodoo_t *voodoo, uint32_t addr_type, uint32_t val);
+void voodoo_queue_lfb_writel(voodoo_t *voodoo, uint32_t addr, uint32_t val);
+/*Queue the LFB writes gathered so far*/
+void voodoo_lfb_span_commit(voodoo_t *voodoo);
 void voodoo_flush(voodoo_t *voodoo);
 void voodoo_wake_fifo_threads(voodoo_set_t *set, voodoo_t *voodoo);
 void voodoo_wait_for_swap_complete(voodoo_t *voodoo);
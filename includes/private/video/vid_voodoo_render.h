@@ -16,37 +16,37 @@ void voodoo_codegen_close(voodoo_t *voodoo);
                         voodoo->fbiZFuncFail++;                                                                                  \
                         goto skip_pixel;                                                                                         \
                 case DEPTHOP_LESSTHAN:                                                                                           \
-                        if (!(comp_depth < old_depth)) {                                                                         \
+                        if (!((comp_depth) < old_depth)) {                                                                       \
                                 voodoo->fbiZFuncFail++;                                                                          \
                                 goto skip_pixel;                                                                                 \
                         }                                                                                                        \
                         break;                                                                                                   \
                 case DEPTHOP_EQUAL:                                                                                              \
-                        if (!(comp_depth == old_depth)) {                                                                        \
+                        if (!((comp_depth) == old_depth)) {                                                                      \
                                 voodoo->fbiZFuncFail++;                                                                          \
                                 goto skip_pixel;                                                                                 \
                         }                                                                                                        \
                         break;                                                                                                   \
                 case DEPTHOP_LESSTHANEQUAL:                                                                                      \
-                        if (!(comp_depth <= old_depth)) {                                                                        \
+                        if (!((comp_depth) <= old_depth)) {                                                                      \
                                 voodoo->fbiZFuncFail++;                                                                          \
                                 goto skip_pixel;                                                                                 \
                         }                                                                                                        \
                         break;                                                                                                   \
                 case DEPTHOP_GREATERTHAN:                                                                                        \
-                        if (!(comp_depth > old_depth)) {                                                                         \
+                        if (!((comp_depth) > old_depth)) {                                                                       \
                                 voodoo->fbiZFuncFail++;                                                                          \
                                 goto skip_pixel;                                                                                 \
                         }                                                                                                        \
                         break;                                                                                                   \
                 case DEPTHOP_NOTEQUAL:                                                                                           \
-                        if (!(comp_depth != old_depth)) {                                                                        \
+                        if (!((comp_depth) != old_depth)) {                                                                      \
                                 voodoo->fbiZFuncFail++;                                                                          \
                                 goto skip_pixel;                                                                                 \
                         }                                                                                                        \
                         break;                                                                                                   \
                 case DEPTHOP_GREATERTHANEQUAL:                                                                                   \
-                        if (!(comp_depth >= old_depth)) {                                                                        \
+                        if (!((comp_depth) >= old_depth)) {                                                                      \
                                 voodoo->fbiZFuncFail++;                                                                          \
                                 goto skip_pixel;                                                                                 \
                         }                                                                                                        \
@@ -272,8 +272,9 @@ void voodoo_render_thread_2(void *param);
 void voodoo_render_thread_3(void *param);
 void voodoo_render_thread_4(void *param);
 void voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params);
+/*Rasterise the lines of a triangle belonging to one render thread*/
+void voodoo_triangle(voodoo_t *voodoo, voodoo_params_t *params, int odd_even);
 
-extern int voodoo_recomp;
 extern int tris;
 
 static inline void voodoo_wake_render_thread(voodoo_t *voodoo) {
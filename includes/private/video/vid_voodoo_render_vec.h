@@ -0,0 +1,564 @@
+#ifndef _VID_VOODOO_RENDER_VEC_H_
+#define _VID_VOODOO_RENDER_VEC_H_
+
+/*Portable vectorised span renderer, used in place of the generic per-pixel
+  loop in voodoo_half_triangle() when the recompiler is disabled or not
+  available for this host.
+
+  Pixels are processed four at a time using the compiler's generic vector
+  extensions, which map onto SSE2, NEON or AltiVec without any intrinsics.
+  Depth, colour combine, alpha test and blending are done on all four lanes
+  at once, with failed pixels masked out. Texture fetches, fog, W depth and
+  the dither tables are still per pixel, reusing the generic code, but only
+  for lanes that are still live. Results match the generic path exactly,
+  including the pixel counters and the texture state left behind for later
+  untextured triangles.
+
+  Texturing, depth testing and blending are fixed at compile time, giving
+  eight specialised span functions; the rest of the pipeline state is checked
+  once per block of four pixels. Tiled buffers and states the generic path
+  treats as fatal are left to the generic path.
+
+  This file is included directly into vid_voodoo_render.c, after the texture
+  fetch functions it uses.*/
+#if defined(__GNUC__) || defined(__clang__)
+#define VOODOO_RENDER_VEC
+
+#define VOODOO_VEC_LANES 4
+
+typedef int32_t voodoo_vec_t __attribute__((vector_size(VOODOO_VEC_LANES * 4)));
+
+typedef void (*voodoo_vec_span_t)(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int x, int x2,
+                                  int real_y, uint16_t *fb_mem, uint16_t *aux_mem);
+
+static const voodoo_vec_t voodoo_vec_lane = {0, 1, 2, 3};
+
+static inline voodoo_vec_t voodoo_vec_set1(int32_t val) {
+        voodoo_vec_t v = {0, 0, 0, 0};
+
+        return v + val;
+}
+
+/*Lanes are selected from a where mask is all ones, b otherwise*/
+static inline voodoo_vec_t voodoo_vec_select(voodoo_vec_t mask, voodoo_vec_t a, voodoo_vec_t b) {
+        return (a & mask) | (b & ~mask);
+}
+
+static inline voodoo_vec_t voodoo_vec_clamp(voodoo_vec_t v, int32_t max) {
+        v &= ~(v < 0);
+        return voodoo_vec_select(v > max, voodoo_vec_set1(max), v);
+}
+
+static inline int voodoo_vec_count(voodoo_vec_t mask) {
+        return -(mask[0] + mask[1] + mask[2] + mask[3]);
+}
+
+/*Depth and alpha test. AFUNC_ and DEPTHOP_ use the same encoding*/
+static inline voodoo_vec_t voodoo_vec_compare(int op, voodoo_vec_t a, voodoo_vec_t b) {
+        switch (op) {
+        case DEPTHOP_NEVER:
+                return voodoo_vec_set1(0);
+        case DEPTHOP_LESSTHAN:
+                return a < b;
+        case DEPTHOP_EQUAL:
+                return a == b;
+        case DEPTHOP_LESSTHANEQUAL:
+                return a <= b;
+        case DEPTHOP_GREATERTHAN:
+                return a > b;
+        case DEPTHOP_NOTEQUAL:
+                return a != b;
+        case DEPTHOP_GREATERTHANEQUAL:
+                return a >= b;
+        default: /*DEPTHOP_ALWAYS*/
+                return voodoo_vec_set1(-1);
+        }
+}
+
+/*Returns the factor ALPHA_BLEND() multiplies a colour by, over 255. Modes that
+  leave the colour alone or zero it are handled by the caller*/
+static inline voodoo_vec_t voodoo_vec_blend_factor(int afunc, voodoo_vec_t src_a, voodoo_vec_t src_c, voodoo_vec_t dest_c,
+                                                   voodoo_vec_t dest_a) {
+        switch (afunc) {
+        case AFUNC_ASRC_ALPHA:
+                return src_a;
+        case AFUNC_A_COLOR:
+                return src_c;
+        case AFUNC_ADST_ALPHA:
+                return dest_a;
+        case AFUNC_AOMSRC_ALPHA:
+                return 255 - src_a;
+        case AFUNC_AOM_COLOR:
+                return 255 - src_c;
+        case AFUNC_AOMDST_ALPHA:
+                return 255 - dest_a;
+        default: /*AFUNC_ASATURATE, destination only*/
+                return voodoo_vec_select(src_a < (1 - dest_a), src_a, 1 - dest_a);
+        }
+}
+
+static inline __attribute__((always_inline)) void voodoo_vec_span(voodoo_t *voodoo, voodoo_params_t *params,
+                                                                  voodoo_state_t *state, int x, int x2, int real_y,
+                                                                  uint16_t *fb_mem, uint16_t *aux_mem, const int textured,
+                                                                  const int depth, const int blend) {
+        const int xdir = state->xdir;
+        int count = (x2 - x) * xdir + 1;
+        voodoo_vec_t lane = voodoo_vec_lane * xdir;
+        voodoo_vec_t ir = state->ir + lane * params->dRdX;
+        voodoo_vec_t ig = state->ig + lane * params->dGdX;
+        voodoo_vec_t ib = state->ib + lane * params->dBdX;
+        voodoo_vec_t ia = state->ia + lane * params->dAdX;
+        voodoo_vec_t z = state->z + lane * params->dZdX;
+        voodoo_vec_t color0_r = voodoo_vec_set1((params->color0 >> 16) & 0xff);
+        voodoo_vec_t color0_g = voodoo_vec_set1((params->color0 >> 8) & 0xff);
+        voodoo_vec_t color0_b = voodoo_vec_set1(params->color0 & 0xff);
+        int64_t tmu0_s = state->tmu0_s, tmu0_t = state->tmu0_t, tmu0_w = state->tmu0_w;
+        int64_t tmu1_s = state->tmu1_s, tmu1_t = state->tmu1_t, tmu1_w = state->tmu1_w;
+        int64_t w = state->w;
+        const int step = VOODOO_VEC_LANES * xdir;
+
+        for (; count > 0; count -= VOODOO_VEC_LANES, x += step) {
+                voodoo_vec_t live = voodoo_vec_lane < count;
+                voodoo_vec_t tex_r, tex_g, tex_b, tex_a;
+                voodoo_vec_t clocal_r, clocal_g, clocal_b, alocal;
+                voodoo_vec_t cother_r, cother_g, cother_b, aother;
+                voodoo_vec_t msel_r, msel_g, msel_b, msel_a;
+                voodoo_vec_t src_r, src_g, src_b, src_a;
+                voodoo_vec_t new_depth, sel;
+                int32_t lane_w_depth[VOODOO_VEC_LANES];
+                int c;
+
+                if ((params->fbzMode & FBZ_W_BUFFER) || (params->fogMode & FOG_ENABLE)) {
+                        for (c = 0; c < VOODOO_VEC_LANES; c++)
+                                lane_w_depth[c] = voodoo_w_depth(w + params->dWdX * xdir * c);
+                }
+
+                if (params->fbzMode & FBZ_W_BUFFER) {
+                        voodoo_vec_t wd = {lane_w_depth[0], lane_w_depth[1], lane_w_depth[2], lane_w_depth[3]};
+                        new_depth = wd;
+                } else
+                        new_depth = voodoo_vec_clamp(z >> 12, 0xffff);
+
+                if (params->fbzMode & FBZ_DEPTH_BIAS)
+                        new_depth = voodoo_vec_clamp(new_depth + (int16_t)params->zaColor, 0xffff);
+
+                if (depth) {
+                        voodoo_vec_t old_depth, pass;
+
+                        for (c = 0; c < VOODOO_VEC_LANES; c++)
+                                old_depth[c] = live[c] ? aux_mem[x + xdir * c] : 0;
+
+                        if (params->fbzMode & FBZ_DEPTH_SOURCE)
+                                pass = voodoo_vec_compare(depth_op, voodoo_vec_set1(params->zaColor & 0xffff), old_depth);
+                        else
+                                pass = voodoo_vec_compare(depth_op, new_depth, old_depth);
+
+                        voodoo->fbiZFuncFail += voodoo_vec_count(live & ~pass);
+                        live &= pass;
+                        if (!voodoo_vec_count(live))
+                                goto next_block;
+                }
+
+                if (textured) {
+                        for (c = 0; c < VOODOO_VEC_LANES; c++) {
+                                if (!live[c])
+                                        continue;
+
+                                state->tmu0_s = tmu0_s + params->tmu[0].dSdX * xdir * c;
+                                state->tmu0_t = tmu0_t + params->tmu[0].dTdX * xdir * c;
+                                state->tmu0_w = tmu0_w + params->tmu[0].dWdX * xdir * c;
+                                state->tmu1_s = tmu1_s + params->tmu[1].dSdX * xdir * c;
+                                state->tmu1_t = tmu1_t + params->tmu[1].dTdX * xdir * c;
+                                state->tmu1_w = tmu1_w + params->tmu[1].dWdX * xdir * c;
+                                state->x = x + xdir * c;
+
+                                if ((params->textureMode[0] & TEXTUREMODE_LOCAL_MASK) == TEXTUREMODE_LOCAL || !voodoo->dual_tmus)
+                                        voodoo_tmu_fetch(voodoo, params, state, 0, state->x);
+                                else if ((params->textureMode[0] & TEXTUREMODE_MASK) == TEXTUREMODE_PASSTHROUGH) {
+                                        voodoo_tmu_fetch(voodoo, params, state, 1, state->x);
+
+                                        state->tex_r[0] = state->tex_r[1];
+                                        state->tex_g[0] = state->tex_g[1];
+                                        state->tex_b[0] = state->tex_b[1];
+                                        state->tex_a[0] = state->tex_a[1];
+                                } else
+                                        voodoo_tmu_fetch_and_blend(voodoo, params, state, state->x);
+
+                                tex_r[c] = state->tex_r[0];
+                                tex_g[c] = state->tex_g[0];
+                                tex_b[c] = state->tex_b[0];
+                                tex_a[c] = state->tex_a[0];
+                        }
+
+                        if (params->fbzMode & FBZ_CHROMAKEY) {
+                                voodoo_vec_t fail = (tex_r == params->chromaKey_r) & (tex_g == params->chromaKey_g) &
+                                                    (tex_b == params->chromaKey_b);
+
+                                voodoo->fbiChromaFail += voodoo_vec_count(live & fail);
+                                live &= ~fail;
+                                if (!voodoo_vec_count(live))
+                                        goto next_block;
+                        }
+                } else {
+                        /*Untextured triangles see whatever the last texel fetched was*/
+                        tex_r = voodoo_vec_set1(state->tex_r[0]);
+                        tex_g = voodoo_vec_set1(state->tex_g[0]);
+                        tex_b = voodoo_vec_set1(state->tex_b[0]);
+                        tex_a = voodoo_vec_set1(state->tex_a[0]);
+                }
+
+                if (cc_localselect_override)
+                        sel = (tex_a & 0x80) != 0;
+                else
+                        sel = voodoo_vec_set1(cc_localselect ? -1 : 0);
+
+                clocal_r = voodoo_vec_select(sel, color0_r, voodoo_vec_clamp(ir >> 12, 0xff));
+                clocal_g = voodoo_vec_select(sel, color0_g, voodoo_vec_clamp(ig >> 12, 0xff));
+                clocal_b = voodoo_vec_select(sel, color0_b, voodoo_vec_clamp(ib >> 12, 0xff));
+
+                switch (_rgb_sel) {
+                case CC_LOCALSELECT_ITER_RGB:
+                        cother_r = voodoo_vec_clamp(ir >> 12, 0xff);
+                        cother_g = voodoo_vec_clamp(ig >> 12, 0xff);
+                        cother_b = voodoo_vec_clamp(ib >> 12, 0xff);
+                        break;
+                case CC_LOCALSELECT_TEX:
+                        cother_r = tex_r;
+                        cother_g = tex_g;
+                        cother_b = tex_b;
+                        break;
+                case CC_LOCALSELECT_COLOR1:
+                        cother_r = voodoo_vec_set1((params->color1 >> 16) & 0xff);
+                        cother_g = voodoo_vec_set1((params->color1 >> 8) & 0xff);
+                        cother_b = voodoo_vec_set1(params->color1 & 0xff);
+                        break;
+                default: /*CC_LOCALSELECT_LFB, always zero here*/
+                        cother_r = cother_g = cother_b = voodoo_vec_set1(0);
+                        break;
+                }
+
+                switch (cca_localselect) {
+                case CCA_LOCALSELECT_ITER_A:
+                        alocal = voodoo_vec_clamp(ia >> 12, 0xff);
+                        break;
+                case CCA_LOCALSELECT_COLOR0:
+                        alocal = voodoo_vec_set1((params->color0 >> 24) & 0xff);
+                        break;
+                default: /*CCA_LOCALSELECT_ITER_Z*/
+                        alocal = voodoo_vec_clamp(z >> 20, 0xff);
+                        break;
+                }
+
+                switch (a_sel) {
+                case A_SEL_ITER_A:
+                        aother = voodoo_vec_clamp(ia >> 12, 0xff);
+                        break;
+                case A_SEL_TEX:
+                        aother = tex_a;
+                        break;
+                default: /*A_SEL_COLOR1*/
+                        aother = voodoo_vec_set1((params->color1 >> 24) & 0xff);
+                        break;
+                }
+
+                if (cc_zero_other)
+                        src_r = src_g = src_b = voodoo_vec_set1(0);
+                else {
+                        src_r = cother_r;
+                        src_g = cother_g;
+                        src_b = cother_b;
+                }
+
+                if (cca_zero_other)
+                        src_a = voodoo_vec_set1(0);
+                else
+                        src_a = aother;
+
+                if (cc_sub_clocal) {
+                        src_r -= clocal_r;
+                        src_g -= clocal_g;
+                        src_b -= clocal_b;
+                }
+
+                if (cca_sub_clocal)
+                        src_a -= alocal;
+
+                switch (cc_mselect) {
+                case CC_MSELECT_ZERO:
+                        msel_r = msel_g = msel_b = voodoo_vec_set1(0);
+                        break;
+                case CC_MSELECT_CLOCAL:
+                        msel_r = clocal_r;
+                        msel_g = clocal_g;
+                        msel_b = clocal_b;
+                        break;
+                case CC_MSELECT_AOTHER:
+                        msel_r = msel_g = msel_b = aother;
+                        break;
+                case CC_MSELECT_ALOCAL:
+                        msel_r = msel_g = msel_b = alocal;
+                        break;
+                case CC_MSELECT_TEX:
+                        msel_r = msel_g = msel_b = tex_a;
+                        break;
+                default: /*CC_MSELECT_TEXRGB*/
+                        msel_r = tex_r;
+                        msel_g = tex_g;
+                        msel_b = tex_b;
+                        break;
+                }
+
+                switch (cca_mselect) {
+                case CCA_MSELECT_ZERO:
+                        msel_a = voodoo_vec_set1(0);
+                        break;
+                case CCA_MSELECT_ALOCAL:
+                case CCA_MSELECT_ALOCAL2:
+                        msel_a = alocal;
+                        break;
+                case CCA_MSELECT_AOTHER:
+                        msel_a = aother;
+                        break;
+                default: /*CCA_MSELECT_TEX*/
+                        msel_a = tex_a;
+                        break;
+                }
+
+                if (!cc_reverse_blend) {
+                        msel_r ^= 0xff;
+                        msel_g ^= 0xff;
+                        msel_b ^= 0xff;
+                }
+                if (!cca_reverse_blend)
+                        msel_a ^= 0xff;
+
+                src_r = (src_r * (msel_r + 1)) >> 8;
+                src_g = (src_g * (msel_g + 1)) >> 8;
+                src_b = (src_b * (msel_b + 1)) >> 8;
+                src_a = (src_a * (msel_a + 1)) >> 8;
+
+                if (cc_add == CC_ADD_CLOCAL) {
+                        src_r += clocal_r;
+                        src_g += clocal_g;
+                        src_b += clocal_b;
+                } else if (cc_add == CC_ADD_ALOCAL) {
+                        src_r += alocal;
+                        src_g += alocal;
+                        src_b += alocal;
+                }
+
+                if (cca_add)
+                        src_a += alocal;
+
+                src_r = voodoo_vec_clamp(src_r, 0xff);
+                src_g = voodoo_vec_clamp(src_g, 0xff);
+                src_b = voodoo_vec_clamp(src_b, 0xff);
+                src_a = voodoo_vec_clamp(src_a, 0xff);
+
+                if (cc_invert_output) {
+                        src_r ^= 0xff;
+                        src_g ^= 0xff;
+                        src_b ^= 0xff;
+                }
+                if (cca_invert_output)
+                        src_a ^= 0xff;
+
+                if (params->fogMode & FOG_ENABLE) {
+                        for (c = 0; c < VOODOO_VEC_LANES; c++) {
+                                int r = src_r[c], g = src_g[c], b = src_b[c];
+
+                                if (live[c]) {
+                                        int32_t w_depth = lane_w_depth[c];
+                                        int64_t lane_w = w + params->dWdX * xdir * c;
+
+                                        APPLY_FOG(r, g, b, z[c], ia[c], lane_w);
+                                }
+                                src_r[c] = r;
+                                src_g[c] = g;
+                                src_b[c] = b;
+                        }
+                }
+
+                if (params->alphaMode & 1) {
+                        voodoo_vec_t pass = voodoo_vec_compare(alpha_func, src_a, voodoo_vec_set1(a_ref));
+
+                        voodoo->fbiAFuncFail += voodoo_vec_count(live & ~pass);
+                        live &= pass;
+                        if (!voodoo_vec_count(live))
+                                goto next_block;
+                }
+
+                if (blend) {
+                        voodoo_vec_t dest_r, dest_g, dest_b, dest_a = voodoo_vec_set1(0xff);
+                        voodoo_vec_t newdest_r, newdest_g, newdest_b;
+
+                        for (c = 0; c < VOODOO_VEC_LANES; c++) {
+                                uint16_t dat = live[c] ? fb_mem[x + xdir * c] : 0;
+
+                                dest_r[c] = (dat >> 8) & 0xf8;
+                                dest_g[c] = (dat >> 3) & 0xfc;
+                                dest_b[c] = (dat << 3) & 0xf8;
+                        }
+                        dest_r |= (dest_r >> 5);
+                        dest_g |= (dest_g >> 6);
+                        dest_b |= (dest_b >> 5);
+
+                        if (dithersub && voodoo->dithersub_enabled) {
+                                for (c = 0; c < VOODOO_VEC_LANES; c++) {
+                                        int px = x + xdir * c;
+
+                                        if (dither2x2) {
+                                                dest_r[c] = dithersub_rb2x2[dest_r[c]][real_y & 1][px & 1];
+                                                dest_g[c] = dithersub_g2x2[dest_g[c]][real_y & 1][px & 1];
+                                                dest_b[c] = dithersub_rb2x2[dest_b[c]][real_y & 1][px & 1];
+                                        } else {
+                                                dest_r[c] = dithersub_rb[dest_r[c]][real_y & 3][px & 3];
+                                                dest_g[c] = dithersub_g[dest_g[c]][real_y & 3][px & 3];
+                                                dest_b[c] = dithersub_rb[dest_b[c]][real_y & 3][px & 3];
+                                        }
+                                }
+                        }
+
+                        switch (dest_afunc) {
+                        case AFUNC_AONE:
+                                newdest_r = dest_r;
+                                newdest_g = dest_g;
+                                newdest_b = dest_b;
+                                break;
+                        case AFUNC_ASRC_ALPHA:
+                        case AFUNC_A_COLOR:
+                        case AFUNC_ADST_ALPHA:
+                        case AFUNC_AOMSRC_ALPHA:
+                        case AFUNC_AOM_COLOR:
+                        case AFUNC_AOMDST_ALPHA:
+                        case AFUNC_ASATURATE:
+                                newdest_r = (dest_r * voodoo_vec_blend_factor(dest_afunc, src_a, src_r, dest_r, dest_a)) / 255;
+                                newdest_g = (dest_g * voodoo_vec_blend_factor(dest_afunc, src_a, src_g, dest_g, dest_a)) / 255;
+                                newdest_b = (dest_b * voodoo_vec_blend_factor(dest_afunc, src_a, src_b, dest_b, dest_a)) / 255;
+                                break;
+                        default:
+                                newdest_r = newdest_g = newdest_b = voodoo_vec_set1(0);
+                                break;
+                        }
+
+                        switch (src_afunc) {
+                        case AFUNC_AZERO:
+                                src_r = src_g = src_b = voodoo_vec_set1(0);
+                                break;
+                        case AFUNC_ASRC_ALPHA:
+                        case AFUNC_A_COLOR:
+                        case AFUNC_ADST_ALPHA:
+                        case AFUNC_AOMSRC_ALPHA:
+                        case AFUNC_AOM_COLOR:
+                        case AFUNC_AOMDST_ALPHA:
+                                /*The colour factors for the source are the destination colour*/
+                                src_r = (src_r * voodoo_vec_blend_factor(src_afunc, src_a, dest_r, dest_r, dest_a)) / 255;
+                                src_g = (src_g * voodoo_vec_blend_factor(src_afunc, src_a, dest_g, dest_g, dest_a)) / 255;
+                                src_b = (src_b * voodoo_vec_blend_factor(src_afunc, src_a, dest_b, dest_b, dest_a)) / 255;
+                                break;
+                        default:
+                                break;
+                        }
+
+                        src_r = voodoo_vec_clamp(src_r + newdest_r, 0xff);
+                        src_g = voodoo_vec_clamp(src_g + newdest_g, 0xff);
+                        src_b = voodoo_vec_clamp(src_b + newdest_b, 0xff);
+                }
+
+                if (dither) {
+                        for (c = 0; c < VOODOO_VEC_LANES; c++) {
+                                int px = x + xdir * c;
+
+                                if (dither2x2) {
+                                        src_r[c] = dither_rb2x2[src_r[c]][real_y & 1][px & 1];
+                                        src_g[c] = dither_g2x2[src_g[c]][real_y & 1][px & 1];
+                                        src_b[c] = dither_rb2x2[src_b[c]][real_y & 1][px & 1];
+                                } else {
+                                        src_r[c] = dither_rb[src_r[c]][real_y & 3][px & 3];
+                                        src_g[c] = dither_g[src_g[c]][real_y & 3][px & 3];
+                                        src_b[c] = dither_rb[src_b[c]][real_y & 3][px & 3];
+                                }
+                        }
+                } else {
+                        src_r >>= 3;
+                        src_g >>= 2;
+                        src_b >>= 3;
+                }
+
+                if (params->fbzMode & FBZ_RGB_WMASK) {
+                        voodoo_vec_t col = src_b | (src_g << 5) | (src_r << 11);
+
+                        for (c = 0; c < VOODOO_VEC_LANES; c++) {
+                                if (live[c])
+                                        fb_mem[x + xdir * c] = col[c];
+                        }
+                }
+                if (depth && (params->fbzMode & FBZ_DEPTH_WMASK)) {
+                        for (c = 0; c < VOODOO_VEC_LANES; c++) {
+                                if (live[c])
+                                        aux_mem[x + xdir * c] = new_depth[c];
+                        }
+                }
+
+                voodoo->fbiPixelsOut += voodoo_vec_count(live);
+
+        next_block:
+                ir += params->dRdX * step;
+                ig += params->dGdX * step;
+                ib += params->dBdX * step;
+                ia += params->dAdX * step;
+                z += params->dZdX * step;
+                tmu0_s += params->tmu[0].dSdX * step;
+                tmu0_t += params->tmu[0].dTdX * step;
+                tmu0_w += params->tmu[0].dWdX * step;
+                tmu1_s += params->tmu[1].dSdX * step;
+                tmu1_t += params->tmu[1].dTdX * step;
+                tmu1_w += params->tmu[1].dWdX * step;
+                w += params->dWdX * step;
+        }
+}
+
+#define VOODOO_VEC_SPAN(name, textured, depth, blend)                                                                        \
+        static void name(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int x, int x2, int real_y,       \
+                         uint16_t *fb_mem, uint16_t *aux_mem) {                                                                \
+                voodoo_vec_span(voodoo, params, state, x, x2, real_y, fb_mem, aux_mem, textured, depth, blend);                \
+        }
+
+VOODOO_VEC_SPAN(voodoo_vec_span_flat, 0, 0, 0)
+VOODOO_VEC_SPAN(voodoo_vec_span_flat_blend, 0, 0, 1)
+VOODOO_VEC_SPAN(voodoo_vec_span_flat_depth, 0, 1, 0)
+VOODOO_VEC_SPAN(voodoo_vec_span_flat_depth_blend, 0, 1, 1)
+VOODOO_VEC_SPAN(voodoo_vec_span_tex, 1, 0, 0)
+VOODOO_VEC_SPAN(voodoo_vec_span_tex_blend, 1, 0, 1)
+VOODOO_VEC_SPAN(voodoo_vec_span_tex_depth, 1, 1, 0)
+VOODOO_VEC_SPAN(voodoo_vec_span_tex_depth_blend, 1, 1, 1)
+
+/*Indexed by (textured << 2) | (depth << 1) | blend*/
+static const voodoo_vec_span_t voodoo_vec_spans[8] = {
+        voodoo_vec_span_flat, voodoo_vec_span_flat_blend, voodoo_vec_span_flat_depth, voodoo_vec_span_flat_depth_blend,
+        voodoo_vec_span_tex,  voodoo_vec_span_tex_blend,  voodoo_vec_span_tex_depth,  voodoo_vec_span_tex_depth_blend};
+
+/*Returns the span function for the current state, or NULL if the triangle has
+  to go through the generic path*/
+static voodoo_vec_span_t voodoo_vec_get_span(voodoo_t *voodoo, voodoo_params_t *params) {
+        int textured = (params->fbzColorPath & FBZCP_TEXTURE_ENABLED) ? 1 : 0;
+        int depth = (params->fbzMode & FBZ_DEPTH_ENABLE) ? 1 : 0;
+        int blend = (params->alphaMode & (1 << 4)) ? 1 : 0;
+
+        if (params->col_tiled || params->aux_tiled || voodoo->params.col_tiled || voodoo->params.aux_tiled)
+                return NULL;
+        /*TMU config readback overwrites the texture colour on every pixel*/
+        if (voodoo->trexInit1[0] & (1 << 18))
+                return NULL;
+        if (cca_localselect > CCA_LOCALSELECT_ITER_Z || a_sel > A_SEL_COLOR1 || cc_mselect > CC_MSELECT_TEXRGB ||
+            cca_mselect > CCA_MSELECT_TEX || cc_add > CC_ADD_ALOCAL)
+                return NULL;
+        if (blend && src_afunc == AFUNC_ACOLORBEFOREFOG)
+                return NULL;
+
+        return voodoo_vec_spans[(textured << 2) | (depth << 1) | blend];
+}
+
+#endif
+
+#endif /* _VID_VOODOO_RENDER_VEC_H_ */
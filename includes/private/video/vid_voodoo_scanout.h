@@ -0,0 +1,70 @@
+#ifndef _VID_VOODOO_SCANOUT_H_
+#define _VID_VOODOO_SCANOUT_H_
+
+/*Voodoo scanout worker.
+
+  voodoo_callback() still runs once per scanline on the emulation thread and
+  owns retrace timing, buffer swaps and the dirty line bookkeeping. For each
+  line it would have drawn it now only queues the line here; a worker thread
+  does the 16bpp to 32bpp conversion, and the screen filter if enabled, into
+  buffer32. The queue is drained with voodoo_scanout_sync() before the frame is
+  blitted, and before anything the conversion reads (CLUT, filter tables) is
+  changed.
+
+  The filter and conversion loops use SSE2, or AVX2 when the build targets it.
+  The filters are computed directly rather than through thefilter[][], giving
+  the same results as the tables*/
+
+/*Enough for every line of a frame*/
+#define VOODOO_SCANOUT_SIZE 2048
+#define VOODOO_SCANOUT_MASK (VOODOO_SCANOUT_SIZE - 1)
+
+/*Lines queued before the worker is woken*/
+#define VOODOO_SCANOUT_BATCH 32
+
+#define VOODOO_SCANOUT_MAX_WIDTH 4096
+
+enum {
+        VOODOO_SCANOUT_FILTER_NONE = 0,
+        VOODOO_SCANOUT_FILTER_V1,
+        VOODOO_SCANOUT_FILTER_V2
+};
+
+typedef struct voodoo_scanout_line_t {
+        uint32_t *dest;
+        uint16_t *src;
+        uint32_t *video_16to32; /*Of the card the line is read from*/
+        int width;
+        int line;
+        int filter;
+} voodoo_scanout_line_t;
+
+typedef struct voodoo_scanout_t {
+        voodoo_scanout_line_t queue[VOODOO_SCANOUT_SIZE];
+        volatile uint32_t read_idx, write_idx;
+        int batch;
+
+        struct voodoo_t *voodoo;
+
+        /*Filter working space, one plane per channel in blue, green, red order.
+          Owned by the worker*/
+        uint16_t fil[3][VOODOO_SCANOUT_MAX_WIDTH + 1];
+        uint16_t fil3[3][VOODOO_SCANOUT_MAX_WIDTH + 1];
+
+        thread_t *thread;
+        event_t *wake_event;
+        event_t *done_event;
+} voodoo_scanout_t;
+
+voodoo_scanout_t *voodoo_scanout_init(struct voodoo_t *voodoo);
+void voodoo_scanout_close(voodoo_scanout_t *scanout);
+
+/*Queue conversion of one line of draw_voodoo's front buffer to buffer32 line*/
+void voodoo_scanout_line(struct voodoo_t *voodoo, struct voodoo_t *draw_voodoo, int draw_line, int line);
+/*Wait for all queued lines to be converted*/
+void voodoo_scanout_sync(struct voodoo_t *voodoo);
+/*As voodoo_scanout_sync(), for every card that may have queued lines from this
+  card's framebuffer - both cards of an SLI pair*/
+void voodoo_scanout_sync_set(struct voodoo_t *voodoo);
+
+#endif /* _VID_VOODOO_SCANOUT_H_ */
@@ -0,0 +1,84 @@
+#ifndef _VID_VOODOO_TRACE_H_
+#define _VID_VOODOO_TRACE_H_
+
+#include <stdint.h>
+
+/*Voodoo command stream capture.
+
+  While voodoo_trace_enabled is set, a Voodoo Graphics or Voodoo 2 records every
+  write the CPU makes to its memory space - registers, CMDFIFO, texture and LFB
+  writes - to voodoo_trace_fn, from device init until the device is closed.
+  Everything that reaches voodoo_queue_command() or the CMDFIFO starts as one of
+  these writes, so the trace holds the whole command stream while staying
+  independent of the FIFO layout. Changes to the PCI initEnable register are
+  recorded as well, as they gate some register writes.
+
+  Each MMIO swapbufferCMD write ends a frame. Every voodoo_trace_checksum_interval
+  frames the capture waits for both FIFOs and the render threads to go idle and
+  records a checksum of each card's framebuffer memory, which pcem-voodoo-replay
+  checks at the same point of the stream. Pending swaps are done without waiting
+  for vsync when this happens, so that the state is the same in both.
+
+  The file starts with a voodoo_trace_header_t, followed by records of two or
+  more little endian 32-bit words. The first word holds the record type in bits
+  28-31, the card in bit 27 and, for writes, the address within the card's 16MB
+  window in bits 0-23; the second word is the value. A WRITEL_BURST record is
+  instead followed by a count and that many values, written to consecutive
+  addresses. Only the emulation thread writes to the trace.*/
+extern int voodoo_trace_enabled;
+extern char voodoo_trace_fn[512];
+extern int voodoo_trace_checksum_interval;
+
+#define VOODOO_TRACE_MAGIC "PCEMVTRC"
+#define VOODOO_TRACE_VERSION 1
+
+#define VOODOO_TRACE_BILINEAR (1 << 0)
+#define VOODOO_TRACE_DITHERSUB (1 << 1)
+
+typedef struct voodoo_trace_header_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t type;
+        uint32_t nr_cards;
+        uint32_t fb_size;      /*MB*/
+        uint32_t texture_size; /*MB*/
+        uint32_t flags;
+} voodoo_trace_header_t;
+
+enum {
+        VOODOO_TRACE_WRITEL = 0,
+        VOODOO_TRACE_WRITEL_BURST,
+        VOODOO_TRACE_WRITEW,
+        VOODOO_TRACE_INIT_ENABLE,
+        VOODOO_TRACE_FRAME,   /*Value is the frame number*/
+        VOODOO_TRACE_CHECKSUM /*Value is voodoo_trace_checksum() of the card*/
+};
+
+#define VOODOO_TRACE_TYPE_SHIFT 28
+#define VOODOO_TRACE_CARD (1 << 27)
+#define VOODOO_TRACE_ADDR_MASK 0xffffff
+
+/*Longest run of consecutive writes stored as one WRITEL_BURST record*/
+#define VOODOO_TRACE_BURST_MAX 256
+
+struct voodoo_t;
+struct voodoo_set_t;
+
+typedef struct voodoo_trace_t voodoo_trace_t;
+
+/*Open voodoo_trace_fn and write the header. Returns NULL if capture is off or
+  the file can't be created*/
+voodoo_trace_t *voodoo_trace_open(struct voodoo_set_t *set);
+void voodoo_trace_close(voodoo_trace_t *trace);
+
+void voodoo_trace_writel(struct voodoo_t *voodoo, uint32_t addr, uint32_t val);
+void voodoo_trace_writew(struct voodoo_t *voodoo, uint32_t addr, uint16_t val);
+void voodoo_trace_init_enable(struct voodoo_t *voodoo);
+
+/*Wait until everything written to the card so far has been drawn. Swaps still
+  waiting for vsync are done immediately*/
+void voodoo_trace_sync(struct voodoo_t *voodoo);
+/*Checksum of the card's framebuffer memory. The card must be idle*/
+uint32_t voodoo_trace_checksum(struct voodoo_t *voodoo);
+
+#endif /* _VID_VOODOO_TRACE_H_ */
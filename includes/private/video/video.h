@@ -77,6 +77,24 @@ extern int vid_resize;
 
 void video_wait_for_blit();
 void video_wait_for_buffer();
+/*Called by the frontend once it has finished reading buffer32*/
+void video_blit_complete();
+
+/*Frame skip. While the host is falling behind, display devices skip drawing
+  up to video_frameskip_max frames in a row into buffer32. CRTC timing, status
+  bits and retrace interrupts still run for every frame, and anything changed
+  during a skipped frame is drawn in the next frame that isn't skipped*/
+extern int video_frameskip_max;
+/*Frames skipped so far*/
+extern volatile int video_frames_skipped;
+
+/*How many ms the emulation is running behind the host clock. Called by the
+  frontend before each emulation slice*/
+void video_frameskip_update(int lag);
+/*Call at vsync with the device's count of frames skipped in a row. Returns 1
+  if the next frame should not be drawn. Skipped frames still count towards
+  video_refresh_rate*/
+int video_frameskip(int *count);
 
 typedef enum {
         FONT_MDA,      /* MDA 8x14 */
@@ -0,0 +1,61 @@
+#ifndef _VIDEO_CAPTURE_H_
+#define _VIDEO_CAPTURE_H_
+
+#include <stdint.h>
+
+/*Video and audio capture.
+
+  While capture_enabled is set, every frame handed to video_blit_memtoscreen()
+  is copied out of buffer32 by the blit thread into a ring of capture_buffers
+  frames, and every block from the sound mixer is copied into an audio ring.
+  An encoder thread empties both rings to files named after capture_fn :
+
+  - capture_fn.raw - frames as 32-bit BGRX pixels, one after another, or
+    capture_fn.y4m - YUV 4:4:4 at a constant capture_fps, repeating or
+    dropping frames to follow their timestamps. A new file (capture_fn_1.y4m,
+    ...) is started whenever the frame size changes, or
+    capture_fn_000000.png ... - one uncompressed PNG per frame
+  - capture_fn.csv - for each captured frame, its number, timestamp, size and
+    the number of frames dropped so far
+  - capture_fn.wav - 48 kHz 16-bit stereo mixer output
+
+  Timestamps are in microseconds of emulated time, counted in 48 kHz sound
+  ticks from the start of the capture, so they stay in step with the audio
+  whatever the emulation speed. Capture starts at the first mixer block after
+  it is enabled, and works without a frontend attached.
+
+  Neither the emulation thread nor the blit thread ever waits for the encoder.
+  When a ring is full the frame or audio block is dropped and counted in
+  capture_dropped_frames or capture_dropped_audio. With capture_changed_only
+  set, frames where no lines were redrawn are skipped rather than captured.*/
+extern int capture_enabled;
+extern int capture_format;
+extern char capture_fn[512];
+extern int capture_changed_only;
+extern int capture_buffers;
+extern int capture_fps;
+
+enum { CAPTURE_FORMAT_RAW = 0, CAPTURE_FORMAT_Y4M, CAPTURE_FORMAT_PNG };
+
+#define CAPTURE_MAX_BUFFERS 64
+
+/*Set while a capture is running. Written by the emulation thread only*/
+extern volatile int capture_active;
+
+/*Frames dropped because the frame ring was full*/
+extern volatile int capture_dropped_frames;
+/*Stereo audio frames dropped because the audio ring was full*/
+extern volatile int capture_dropped_audio;
+
+/*Queue len stereo frames of mixer output, starting the capture first if it
+  has been enabled. Emulation thread only*/
+void capture_audio(int32_t *buf, int len);
+/*Current capture timestamp. Emulation thread only*/
+uint64_t capture_time();
+/*Queue a copy of the w x h frame at x,y in buffer32. changed is clear if no
+  lines were redrawn since the last frame. Blit thread only*/
+void capture_video_frame(int x, int y, int w, int h, int changed, uint64_t time);
+/*Stop the capture, writing out everything queued so far*/
+void capture_close();
+
+#endif /* _VIDEO_CAPTURE_H_ */
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "config.h"
+#include "paths.h"
+#include "bench.h"
+
+/*pcem-bench - microbenchmarks for emulator hot paths.
+
+  Every benchmark is run for at least --time ms per repeat, with the iteration
+  count found by doubling from one, and the fastest of --repeat runs is
+  reported. Output is one JSON object per line per benchmark :
+
+  {"schema":1,"version":"...","suite":"cpu","benchmark":"timer_process",
+   "unit":"callback","status":"ok","iterations":N,"repeats":N,"ops":N,
+   "ns_per_op":X,"ns_per_op_median":X,"ops_per_sec":X}
+
+  Skipped benchmarks have "status":"skipped" and a "reason" instead of the
+  timings. Fields are only ever added to this format; a change to an existing
+  field bumps "schema".*/
+
+#define BENCH_SCHEMA 1
+#define BENCH_MAX_REPEAT 32
+
+static const char *bench_skip_reason;
+
+typedef struct bench_suite_t {
+        const char *name;
+        bench_t *benches;
+} bench_suite_t;
+
+static bench_suite_t bench_suites[] = {
+        {"cpu", bench_cpu}, {"video", bench_video}, {"sound", bench_sound}, {"disc", bench_disc}, {NULL, NULL}};
+
+void bench_skip(const char *reason) { bench_skip_reason = reason; }
+
+static int bench_double_compare(const void *a, const void *b) {
+        double da = *(const double *)a;
+        double db = *(const double *)b;
+
+        return (da > db) - (da < db);
+}
+
+static int bench_match(const char *filter, const char *suite, const char *name) {
+        char full[256];
+
+        if (!filter)
+                return 1;
+        snprintf(full, sizeof(full), "%s/%s", suite, name);
+        return strstr(full, filter) != NULL;
+}
+
+static void bench_run(FILE *f, const char *suite, bench_t *bench, int min_time_ms, int repeats) {
+        double ns_per_op[BENCH_MAX_REPEAT];
+        uint64_t min_time = (timer_freq * (uint64_t)min_time_ms) / 1000;
+        uint64_t ops = 0;
+        int iterations = 1;
+        void *p;
+        int c;
+
+        bench_skip_reason = NULL;
+        p = bench->init();
+        if (!p) {
+                fprintf(f,
+                        "{\"schema\":%i,\"version\":\"%s\",\"suite\":\"%s\",\"benchmark\":\"%s\",\"unit\":\"%s\",\"status\":"
+                        "\"skipped\",\"reason\":\"%s\"}\n",
+                        BENCH_SCHEMA, PCEM_VERSION_STRING, suite, bench->name, bench->unit,
+                        bench_skip_reason ? bench_skip_reason : "init failed");
+                fflush(f);
+                return;
+        }
+
+        /*Find an iteration count that runs for at least the minimum time. This
+          also warms up caches and any lazily built state*/
+        while (1) {
+                uint64_t start = timer_read();
+
+                ops = bench->run(p, iterations);
+                if ((timer_read() - start) >= min_time || iterations >= (1 << 30))
+                        break;
+                iterations *= 2;
+        }
+
+        for (c = 0; c < repeats; c++) {
+                uint64_t start = timer_read();
+                uint64_t elapsed;
+
+                ops = bench->run(p, iterations);
+                elapsed = timer_read() - start;
+                ns_per_op[c] = ((double)elapsed * 1000000000.0 / (double)timer_freq) / (double)(ops ? ops : 1);
+        }
+
+        bench->close(p);
+
+        qsort(ns_per_op, repeats, sizeof(double), bench_double_compare);
+
+        fprintf(f,
+                "{\"schema\":%i,\"version\":\"%s\",\"suite\":\"%s\",\"benchmark\":\"%s\",\"unit\":\"%s\",\"status\":\"ok\","
+                "\"iterations\":%i,\"repeats\":%i,\"ops\":%llu,\"ns_per_op\":%.3f,\"ns_per_op_median\":%.3f,"
+                "\"ops_per_sec\":%.1f}\n",
+                BENCH_SCHEMA, PCEM_VERSION_STRING, suite, bench->name, bench->unit, iterations, repeats,
+                (unsigned long long)ops, ns_per_op[0], ns_per_op[repeats / 2],
+                ns_per_op[0] ? 1000000000.0 / ns_per_op[0] : 0.0);
+        fflush(f);
+}
+
+static void bench_usage() {
+        printf("pcem-bench command line options :\n\n");
+        printf("--list             - list benchmarks and exit\n");
+        printf("--filter text      - only run benchmarks whose suite/name contains text\n");
+        printf("--time ms          - minimum time per repeat (default 200)\n");
+        printf("--repeat n         - number of timed repeats, best is reported (default 5)\n");
+        printf("--output file      - write results to file rather than stdout. Recommended\n");
+        printf("                     for non-release builds, which also log to stdout\n");
+        printf("--roms path        - ROM search path, for benchmarks that need ROM images\n");
+        printf("--tmpdir path      - directory for scratch files and pcem.log (default .)\n");
+}
+
+int main(int argc, char **argv) {
+        const char *filter = NULL;
+        const char *output = NULL;
+        char *roms_path = NULL;
+        int min_time_ms = 200;
+        int repeats = 5;
+        int list = 0;
+        FILE *f = stdout;
+        int c, d;
+
+        for (c = 1; c < argc; c++) {
+                if (!strcasecmp(argv[c], "--help")) {
+                        bench_usage();
+                        return 0;
+                } else if (!strcasecmp(argv[c], "--list")) {
+                        list = 1;
+                } else if ((c + 1) == argc) {
+                        bench_usage();
+                        return 1;
+                } else if (!strcasecmp(argv[c], "--filter")) {
+                        filter = argv[++c];
+                } else if (!strcasecmp(argv[c], "--time")) {
+                        min_time_ms = atoi(argv[++c]);
+                } else if (!strcasecmp(argv[c], "--repeat")) {
+                        repeats = atoi(argv[++c]);
+                } else if (!strcasecmp(argv[c], "--output")) {
+                        output = argv[++c];
+                } else if (!strcasecmp(argv[c], "--roms")) {
+                        roms_path = argv[++c];
+                } else if (!strcasecmp(argv[c], "--tmpdir")) {
+                        safe_strncpy(bench_tmp_path, argv[++c], sizeof(bench_tmp_path) - 1);
+                        put_backslash(bench_tmp_path);
+                } else {
+                        bench_usage();
+                        return 1;
+                }
+        }
+
+        if (list) {
+                for (c = 0; bench_suites[c].name; c++) {
+                        for (d = 0; bench_suites[c].benches[d].name; d++) {
+                                if (bench_match(filter, bench_suites[c].name, bench_suites[c].benches[d].name))
+                                        printf("%s/%s\n", bench_suites[c].name, bench_suites[c].benches[d].name);
+                        }
+                }
+                return 0;
+        }
+
+        if (repeats < 1)
+                repeats = 1;
+        if (repeats > BENCH_MAX_REPEAT)
+                repeats = BENCH_MAX_REPEAT;
+        if (min_time_ms < 1)
+                min_time_ms = 1;
+
+        if (output) {
+                f = fopen(output, "wt");
+                if (!f) {
+                        printf("pcem-bench : can't open %s\n", output);
+                        return 1;
+                }
+        }
+
+        bench_core_init(roms_path);
+
+        for (c = 0; bench_suites[c].name; c++) {
+                for (d = 0; bench_suites[c].benches[d].name; d++) {
+                        if (bench_match(filter, bench_suites[c].name, bench_suites[c].benches[d].name))
+                                bench_run(f, bench_suites[c].name, &bench_suites[c].benches[d], min_time_ms, repeats);
+                }
+        }
+
+        bench_core_close();
+
+        if (f != stdout)
+                fclose(f);
+
+        return 0;
+}
@@ -0,0 +1,40 @@
+set(PCEM_PRIVATE_API ${PCEM_PRIVATE_API}
+        ${CMAKE_SOURCE_DIR}/includes/private/bench/bench.h
+        )
+
+set(PCEM_BENCH_SRC
+        bench/bench.c
+        bench/bench_cpu.c
+        bench/bench_disc.c
+        bench/bench_sound.c
+        bench/bench_video.c
+        )
+
+set(PCEM_VOODOO_REPLAY_SRC
+        bench/voodoo_replay.c
+        )
+
+# The emulator core without the wx-ui frontend. bench_host.c stands in for the
+# frontend functions the core calls; the thread wrappers are used as they are.
+# It is built once and linked into both tools.
+set(PCEM_BENCH_CORE_SRC ${PCEM_SRC})
+list(FILTER PCEM_BENCH_CORE_SRC EXCLUDE REGEX "(^|/)wx-ui/")
+set(PCEM_BENCH_CORE_SRC ${PCEM_BENCH_CORE_SRC}
+        wx-ui/wx-thread.c
+        bench/bench_host.c
+        bench/bench_machine.c
+        )
+
+add_library(pcem-bench-core OBJECT ${PCEM_BENCH_CORE_SRC} ${PCEM_PRIVATE_API} ${PCEM_EMBEDDED_PLUGIN_API})
+target_compile_definitions(pcem-bench-core PUBLIC ${PCEM_DEFINES})
+target_compile_options(pcem-bench-core PUBLIC $<$<COMPILE_LANGUAGE:CXX>:-fcommon> $<$<COMPILE_LANGUAGE:C>:-fcommon>)
+
+add_executable(pcem-bench $<TARGET_OBJECTS:pcem-bench-core> ${PCEM_BENCH_SRC})
+target_compile_definitions(pcem-bench PUBLIC ${PCEM_DEFINES})
+target_compile_options(pcem-bench PUBLIC $<$<COMPILE_LANGUAGE:CXX>:-fcommon> $<$<COMPILE_LANGUAGE:C>:-fcommon>)
+target_link_libraries(pcem-bench ${PCEM_LIBRARIES})
+
+add_executable(pcem-voodoo-replay $<TARGET_OBJECTS:pcem-bench-core> ${PCEM_VOODOO_REPLAY_SRC})
+target_compile_definitions(pcem-voodoo-replay PUBLIC ${PCEM_DEFINES})
+target_compile_options(pcem-voodoo-replay PUBLIC $<$<COMPILE_LANGUAGE:CXX>:-fcommon> $<$<COMPILE_LANGUAGE:C>:-fcommon>)
+target_link_libraries(pcem-voodoo-replay ${PCEM_LIBRARIES})
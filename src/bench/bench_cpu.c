@@ -0,0 +1,390 @@
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "cpu.h"
+#include "codegen.h"
+#include "mem.h"
+#include "timer.h"
+#include "x86.h"
+#include "386_common.h"
+#include "bench.h"
+
+/*CPU, memory and timer hot paths. All of these run on the bare machine set up
+  by bench_machine_init()*/
+
+#define BENCH_TIMERS 64
+
+typedef struct bench_timer_t {
+        pc_timer_t timer;
+        uint64_t period;
+} bench_timer_t;
+
+static void bench_timer_callback(void *p) {
+        bench_timer_t *timer = p;
+
+        timer_advance_u64(&timer->timer, timer->period);
+}
+
+static void *bench_timer_init() {
+        bench_timer_t *timers = malloc(sizeof(bench_timer_t) * BENCH_TIMERS);
+        int c;
+
+        bench_machine_init();
+        /*Only the benchmark's own timers should be in the list*/
+        timer_reset();
+
+        for (c = 0; c < BENCH_TIMERS; c++) {
+                /*Periods of 1-64us, spread so that timers regularly overtake each
+                  other in the list*/
+                timers[c].period = TIMER_USEC * (1 + ((c * 37) & 63));
+                timer_add(&timers[c].timer, bench_timer_callback, &timers[c], 0);
+        }
+
+        return timers;
+}
+
+static void bench_timer_close(void *p) {
+        bench_timer_t *timers = p;
+        int c;
+
+        for (c = 0; c < BENCH_TIMERS; c++)
+                timer_disable(&timers[c].timer);
+        free(timers);
+}
+
+/*Re-arming timers - each timer_set_delay_u64() unlinks the timer and does a
+  sorted insert into the active list*/
+static uint64_t bench_timer_insert_run(void *p, int iterations) {
+        bench_timer_t *timers = p;
+        int c, d;
+
+        for (c = 0; c < iterations; c++) {
+                for (d = 0; d < BENCH_TIMERS; d++)
+                        timer_set_delay_u64(&timers[d].timer, timers[(c + d) & (BENCH_TIMERS - 1)].period);
+        }
+
+        return (uint64_t)iterations * BENCH_TIMERS;
+}
+
+/*Periodic timers driven the way the CPU loop drives them, by advancing the TSC
+  to timer_target and calling timer_process(). One operation is one callback*/
+static uint64_t bench_timer_process_run(void *p, int iterations) {
+        bench_timer_t *timers = p;
+        uint64_t start_callbacks;
+        int c;
+
+        for (c = 0; c < BENCH_TIMERS; c++) {
+                if (!timers[c].timer.enabled)
+                        timer_set_delay_u64(&timers[c].timer, timers[c].period);
+        }
+
+        start_callbacks = timer_callbacks;
+        for (c = 0; c < iterations; c++) {
+                tsc += (uint32_t)(timer_target - (uint32_t)tsc);
+                timer_process();
+        }
+
+        return timer_callbacks - start_callbacks;
+}
+
+/*Guest memory accesses through the same macros the interpreter uses. The hit
+  case stays within a 64kB working set, so every access after the first per page
+  is satisfied from readlookup2/writelookup2. The miss case strides over more
+  pages than the TLB holds, so every access goes through readmemll()/
+  writememll() and refills an entry*/
+#define BENCH_MEM_BASE 0x100000
+#define BENCH_MEM_HIT_SIZE (64 * 1024)
+#define BENCH_MEM_MISS_PAGES 1024
+#define BENCH_MEM_ACCESSES 4096
+
+static void *bench_mem_init() {
+        bench_machine_init();
+        cr0 = 0;
+        flushmmucache();
+
+        return ram;
+}
+
+static void bench_mem_close(void *p) {}
+
+static uint64_t bench_mem_readl_hit_run(void *p, int iterations) {
+        volatile uint32_t sum = 0;
+        int c, d;
+
+        for (c = 0; c < iterations; c++) {
+                for (d = 0; d < BENCH_MEM_ACCESSES; d++)
+                        sum += readmeml(BENCH_MEM_BASE, (d * 16) & (BENCH_MEM_HIT_SIZE - 1));
+        }
+
+        return (uint64_t)iterations * BENCH_MEM_ACCESSES;
+}
+
+static uint64_t bench_mem_writel_hit_run(void *p, int iterations) {
+        int c, d;
+
+        for (c = 0; c < iterations; c++) {
+                for (d = 0; d < BENCH_MEM_ACCESSES; d++) {
+                        writememl(BENCH_MEM_BASE, (d * 16) & (BENCH_MEM_HIT_SIZE - 1), d);
+                }
+        }
+
+        return (uint64_t)iterations * BENCH_MEM_ACCESSES;
+}
+
+static uint64_t bench_mem_readl_miss_run(void *p, int iterations) {
+        volatile uint32_t sum = 0;
+        int c, d;
+
+        for (c = 0; c < iterations; c++) {
+                for (d = 0; d < BENCH_MEM_ACCESSES; d++)
+                        sum += readmeml(BENCH_MEM_BASE, (d % BENCH_MEM_MISS_PAGES) << 12);
+        }
+
+        return (uint64_t)iterations * BENCH_MEM_ACCESSES;
+}
+
+static uint64_t bench_mem_writel_miss_run(void *p, int iterations) {
+        int c, d;
+
+        for (c = 0; c < iterations; c++) {
+                for (d = 0; d < BENCH_MEM_ACCESSES; d++) {
+                        writememl(BENCH_MEM_BASE, (d % BENCH_MEM_MISS_PAGES) << 12, d);
+                }
+        }
+
+        return (uint64_t)iterations * BENCH_MEM_ACCESSES;
+}
+
+/*Moving a mapping, as PCI BAR and chipset shadow writes do. Each move is two
+  mem_mapping_recalc() calls, over the old and new ranges*/
+typedef struct bench_mapping_t {
+        mem_mapping_t mapping;
+        uint8_t *mem;
+} bench_mapping_t;
+
+static uint8_t bench_mapping_read(uint32_t addr, void *p) {
+        bench_mapping_t *bench = p;
+
+        return bench->mem[addr & 0x1ffff];
+}
+
+static void bench_mapping_write(uint32_t addr, uint8_t val, void *p) {
+        bench_mapping_t *bench = p;
+
+        bench->mem[addr & 0x1ffff] = val;
+}
+
+static void *bench_mapping_init() {
+        bench_mapping_t *bench = malloc(sizeof(bench_mapping_t));
+
+        bench_machine_init();
+
+        bench->mem = malloc(0x20000);
+        memset(bench->mem, 0, 0x20000);
+        mem_mapping_add(&bench->mapping, 0xe0000000, 0x20000, bench_mapping_read, NULL, NULL, bench_mapping_write, NULL, NULL,
+                        NULL, MEM_MAPPING_EXTERNAL, bench);
+
+        return bench;
+}
+
+static void bench_mapping_close(void *p) {
+        bench_mapping_t *bench = p;
+
+        mem_mapping_remove(&bench->mapping);
+        free(bench->mem);
+        free(bench);
+}
+
+static uint64_t bench_mapping_set_addr_run(void *p, int iterations) {
+        bench_mapping_t *bench = p;
+        int c;
+
+        for (c = 0; c < iterations; c++)
+                mem_mapping_set_addr(&bench->mapping, (c & 1) ? 0xe0000000 : 0xe0100000, 0x20000);
+
+        return iterations;
+}
+
+/*Dynarec. The guest code is a real mode loop over 256 copies of a 14
+  instruction body, each ending in a JMP so that every copy is its own block :
+
+        add eax,0x12345678 / add ax,bx / mov cx,ax / shl cx,1 / mov bx,[0x100]
+        xor bx,cx / mov [0x104],bx / imul eax,ebx / inc di / and cx,di
+        push ax / pop dx / add di,dx / jmp $+3
+
+  followed by DEC SI / JNZ to the start / HLT. SI holds the number of passes*/
+#define BENCH_CODE_BASE 0x10000
+#define BENCH_CODE_BLOCKS 256
+#define BENCH_CODE_BODY_INS 14
+
+static const uint8_t bench_code_body[] = {0x66, 0x05, 0x78, 0x56, 0x34, 0x12, 0x01, 0xd8, 0x89, 0xc1, 0xd1, 0xe1,
+                                          0x8b, 0x1e, 0x00, 0x01, 0x31, 0xcb, 0x89, 0x1e, 0x04, 0x01, 0x66, 0x0f,
+                                          0xaf, 0xc3, 0x47, 0x21, 0xf9, 0x50, 0x5a, 0x01, 0xd7, 0xe9, 0x00, 0x00};
+
+static uint32_t bench_code_hlt;
+
+static void *bench_dynarec_init() {
+        uint32_t addr = 0;
+        int16_t rel;
+        int c;
+
+        bench_machine_init();
+        cr0 = 0;
+        cpu_use_dynarec = 1;
+
+        for (c = 0; c < BENCH_CODE_BLOCKS; c++) {
+                memcpy(&ram[BENCH_CODE_BASE + addr], bench_code_body, sizeof(bench_code_body));
+                addr += sizeof(bench_code_body);
+        }
+        ram[BENCH_CODE_BASE + addr++] = 0x4e; /*DEC SI*/
+        rel = -(int16_t)(addr + 4);
+        ram[BENCH_CODE_BASE + addr++] = 0x0f; /*JNZ start*/
+        ram[BENCH_CODE_BASE + addr++] = 0x85;
+        ram[BENCH_CODE_BASE + addr++] = rel & 0xff;
+        ram[BENCH_CODE_BASE + addr++] = rel >> 8;
+        bench_code_hlt = addr;
+        ram[BENCH_CODE_BASE + addr] = 0xf4; /*HLT*/
+
+        codegen_reset();
+        flushmmucache();
+
+        return ram;
+}
+
+static void bench_dynarec_close(void *p) { codegen_reset(); }
+
+static void bench_code_run(int passes, void (*exec)(int cycs)) {
+        int cycles_to_run = cpu_get_speed() / 100;
+
+        /*SI is only 16 bits, so long runs are split*/
+        while (passes) {
+                int chunk = (passes > 0xffff) ? 0xffff : passes;
+
+                loadcs(BENCH_CODE_BASE >> 4);
+                loadseg(0x2000, &cpu_state.seg_ds);
+                loadseg(0x3000, &cpu_state.seg_ss);
+                ESP = 0xfffe;
+                cpu_state.pc = 0;
+                cpu_state.regs[6].l = chunk; /*SI*/
+
+                while (cpu_state.pc != bench_code_hlt)
+                        exec(cycles_to_run);
+
+                passes -= chunk;
+        }
+}
+
+/*Block compilation. Blocks are only recompiled the second time they are run,
+  so each iteration throws away all blocks and runs the loop twice. The
+  interpreted first pass is included in the time; one operation is one
+  compiled block*/
+static uint64_t bench_dynarec_compile_run(void *p, int iterations) {
+        int start_blocks;
+        uint64_t blocks = 0;
+        int c;
+
+        for (c = 0; c < iterations; c++) {
+                codegen_reset();
+                start_blocks = cpu_new_blocks;
+                bench_code_run(2, exec386_dynarec);
+                blocks += cpu_new_blocks - start_blocks;
+        }
+
+        return blocks;
+}
+
+/*Execution of already compiled blocks. One operation is one guest instruction*/
+static uint64_t bench_dynarec_exec_run(void *p, int iterations) {
+        bench_code_run(iterations, exec386_dynarec);
+
+        return (uint64_t)iterations * (BENCH_CODE_BLOCKS * BENCH_CODE_BODY_INS + 2);
+}
+
+/*The same loop on the 386/486 interpreter, as used with the dynarec disabled.
+  One operation is one guest instruction*/
+static void *bench_interp_init() {
+        void *p = bench_dynarec_init();
+
+        cpu_use_dynarec = 0;
+
+        return p;
+}
+
+static uint64_t bench_interp_exec_run(void *p, int iterations) {
+        bench_code_run(iterations, exec386);
+
+        return (uint64_t)iterations * (BENCH_CODE_BLOCKS * BENCH_CODE_BODY_INS + 2);
+}
+
+/*8088 core. The loop body above uses 386 instructions, so this runs an 8086
+  equivalent that loops forever :
+
+        add ax,0x1234 / add ax,bx / mov cx,ax / shl cx,1 / mov bx,[0x100]
+        xor bx,cx / mov [0x104],bx / adc ax,cx / inc di / and cx,di
+        push ax / pop dx / add di,dx / jmp $+2
+
+  One operation is one guest instruction*/
+static const uint8_t bench_code_808x_body[] = {0x05, 0x34, 0x12, 0x01, 0xd8, 0x89, 0xc1, 0xd1, 0xe1, 0x8b,
+                                               0x1e, 0x00, 0x01, 0x31, 0xcb, 0x89, 0x1e, 0x04, 0x01, 0x11,
+                                               0xc8, 0x47, 0x21, 0xf9, 0x50, 0x5a, 0x01, 0xd7, 0xeb, 0x00};
+
+static void *bench_808x_init_common(int fast) {
+        uint32_t addr = 0;
+        int16_t rel;
+        int c;
+
+        bench_machine_init();
+        cr0 = 0;
+        is8086 = 0;
+        cpu_808x_fast = fast;
+
+        for (c = 0; c < BENCH_CODE_BLOCKS; c++) {
+                memcpy(&ram[BENCH_CODE_BASE + addr], bench_code_808x_body, sizeof(bench_code_808x_body));
+                addr += sizeof(bench_code_808x_body);
+        }
+        rel = -(int16_t)(addr + 3);
+        ram[BENCH_CODE_BASE + addr++] = 0xe9; /*JMP start*/
+        ram[BENCH_CODE_BASE + addr++] = rel & 0xff;
+        ram[BENCH_CODE_BASE + addr++] = rel >> 8;
+
+        /*The prefetch queue was emptied by the reset in bench_machine_init(),
+          so execution can start anywhere*/
+        loadcs(BENCH_CODE_BASE >> 4);
+        loadseg(0x2000, &cpu_state.seg_ds);
+        loadseg(0x3000, &cpu_state.seg_ss);
+        SP = 0xfffe;
+        cpu_state.pc = 0;
+
+        return ram;
+}
+
+static void *bench_808x_init() { return bench_808x_init_common(0); }
+static void *bench_808x_fast_init() { return bench_808x_init_common(1); }
+
+static void bench_808x_close(void *p) { cpu_808x_fast = 0; }
+
+static uint64_t bench_808x_exec_run(void *p, int iterations) {
+        /*4.77 MHz, in 10ms slices as the emulator runs it*/
+        int cycles_to_run = 4772728 / 100;
+        int start_ins = insc;
+
+        while (insc - start_ins < iterations)
+                execx86(cycles_to_run);
+
+        return insc - start_ins;
+}
+
+bench_t bench_cpu[] = {
+        {"timer_insert", "insert", bench_timer_init, bench_timer_insert_run, bench_timer_close},
+        {"timer_process", "callback", bench_timer_init, bench_timer_process_run, bench_timer_close},
+        {"mem_readl_tlb_hit", "access", bench_mem_init, bench_mem_readl_hit_run, bench_mem_close},
+        {"mem_writel_tlb_hit", "access", bench_mem_init, bench_mem_writel_hit_run, bench_mem_close},
+        {"mem_readl_tlb_miss", "access", bench_mem_init, bench_mem_readl_miss_run, bench_mem_close},
+        {"mem_writel_tlb_miss", "access", bench_mem_init, bench_mem_writel_miss_run, bench_mem_close},
+        {"mem_mapping_set_addr", "move", bench_mapping_init, bench_mapping_set_addr_run, bench_mapping_close},
+        {"dynarec_compile", "block", bench_dynarec_init, bench_dynarec_compile_run, bench_dynarec_close},
+        {"dynarec_exec", "instruction", bench_dynarec_init, bench_dynarec_exec_run, bench_dynarec_close},
+        {"interp_exec", "instruction", bench_interp_init, bench_interp_exec_run, bench_dynarec_close},
+        {"808x_exec", "instruction", bench_808x_init, bench_808x_exec_run, bench_808x_close},
+        {"808x_fast_exec", "instruction", bench_808x_fast_init, bench_808x_exec_run, bench_808x_close},
+        {NULL, NULL, NULL, NULL, NULL}};
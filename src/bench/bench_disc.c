@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "cdrom-image.h"
+#include "hdd_file.h"
+#include "ide_atapi.h"
+#include "minivhd/minivhd.h"
+#include "bench.h"
+
+/*Disc image readers. Scratch images are created in bench_tmp_path and deleted
+  on close. Both benchmarks read sequentially through the whole image, wrapping
+  at the end, as a guest copying a large file would. One operation is one
+  sector*/
+
+/*Dynamic VHD, fully allocated so that every read goes through the block
+  allocation table rather than the unallocated-block fast path*/
+#define BENCH_VHD_SIZE (16 << 20)
+#define BENCH_VHD_READ_SECTORS 8
+
+typedef struct bench_vhd_t {
+        hdd_file_t hdd;
+        char fn[512];
+        int sectors;
+        int pos;
+        uint8_t buffer[BENCH_VHD_READ_SECTORS * 512];
+} bench_vhd_t;
+
+static void *bench_vhd_init() {
+        bench_vhd_t *bench = malloc(sizeof(bench_vhd_t));
+        MVHDGeom geom = mvhd_calculate_geometry(BENCH_VHD_SIZE);
+        MVHDMeta *vhdm;
+        uint8_t *data;
+        int err;
+        int c;
+
+        memset(bench, 0, sizeof(bench_vhd_t));
+        bench_tmp_file(bench->fn, "pcem_bench.vhd", sizeof(bench->fn));
+
+        vhdm = mvhd_create_sparse(bench->fn, geom, &err);
+        if (!vhdm) {
+                bench_skip("can't create VHD image");
+                free(bench);
+                return NULL;
+        }
+        bench->sectors = geom.cyl * geom.heads * geom.spt;
+        data = malloc(64 * 512);
+        for (c = 0; c < 64 * 512; c++)
+                data[c] = c;
+        for (c = 0; c < bench->sectors; c += 64)
+                mvhd_write_sectors(vhdm, c, (bench->sectors - c) < 64 ? (bench->sectors - c) : 64, data);
+        free(data);
+        mvhd_close(vhdm);
+
+        hdd_load_ext(&bench->hdd, bench->fn, geom.spt, geom.heads, geom.cyl, 1);
+        if (!bench->hdd.f) {
+                bench_skip("can't open VHD image");
+                remove(bench->fn);
+                free(bench);
+                return NULL;
+        }
+
+        return bench;
+}
+
+static void bench_vhd_close(void *p) {
+        bench_vhd_t *bench = p;
+
+        hdd_close(&bench->hdd);
+        remove(bench->fn);
+        free(bench);
+}
+
+static uint64_t bench_vhd_read_run(void *p, int iterations) {
+        bench_vhd_t *bench = p;
+        int c;
+
+        for (c = 0; c < iterations; c++) {
+                if (bench->pos + BENCH_VHD_READ_SECTORS > bench->sectors)
+                        bench->pos = 0;
+                hdd_read_sectors(&bench->hdd, bench->pos, BENCH_VHD_READ_SECTORS, bench->buffer);
+                bench->pos += BENCH_VHD_READ_SECTORS;
+        }
+
+        return (uint64_t)iterations * BENCH_VHD_READ_SECTORS;
+}
+
+/*ISO 9660 image through the CD image ATAPI backend*/
+#define BENCH_CD_SECTORS 4096
+#define BENCH_CD_READ_SECTORS 16
+
+typedef struct bench_cd_t {
+        char fn[512];
+        int pos;
+        uint8_t buffer[BENCH_CD_READ_SECTORS * 2048];
+} bench_cd_t;
+
+static void *bench_cd_init() {
+        bench_cd_t *bench = malloc(sizeof(bench_cd_t));
+        uint8_t sector[2048];
+        FILE *f;
+        int c;
+
+        memset(bench, 0, sizeof(bench_cd_t));
+        bench_tmp_file(bench->fn, "pcem_bench.iso", sizeof(bench->fn));
+
+        f = fopen(bench->fn, "wb");
+        if (!f) {
+                bench_skip("can't create ISO image");
+                free(bench);
+                return NULL;
+        }
+        for (c = 0; c < BENCH_CD_SECTORS; c++) {
+                memset(sector, c, sizeof(sector));
+                if (c == 16) {
+                        /*Primary volume descriptor*/
+                        memset(sector, 0, sizeof(sector));
+                        sector[0] = 1;
+                        memcpy(&sector[1], "CD001", 5);
+                        sector[6] = 1;
+                }
+                fwrite(sector, sizeof(sector), 1, f);
+        }
+        fclose(f);
+
+        if (image_open(bench->fn)) {
+                bench_skip("can't open ISO image");
+                remove(bench->fn);
+                free(bench);
+                return NULL;
+        }
+
+        return bench;
+}
+
+static void bench_cd_close(void *p) {
+        bench_cd_t *bench = p;
+
+        image_close();
+        remove(bench->fn);
+        free(bench);
+}
+
+static uint64_t bench_cd_read_run(void *p, int iterations) {
+        bench_cd_t *bench = p;
+        int c;
+
+        for (c = 0; c < iterations; c++) {
+                if (bench->pos + BENCH_CD_READ_SECTORS > BENCH_CD_SECTORS)
+                        bench->pos = 0;
+                atapi->readsector(bench->buffer, bench->pos, BENCH_CD_READ_SECTORS);
+                bench->pos += BENCH_CD_READ_SECTORS;
+        }
+
+        return (uint64_t)iterations * BENCH_CD_READ_SECTORS;
+}
+
+bench_t bench_disc[] = {{"vhd_read", "sector", bench_vhd_init, bench_vhd_read_run, bench_vhd_close},
+                        {"cd_image_read", "sector", bench_cd_init, bench_cd_read_run, bench_cd_close},
+                        {NULL, NULL, NULL, NULL, NULL}};
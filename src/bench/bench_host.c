@@ -0,0 +1,77 @@
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "video.h"
+#include "plat-joystick.h"
+#include "plat-keyboard.h"
+#include "plat-mouse.h"
+#include "viewer.h"
+#include "viewer_voodoo.h"
+
+/*Host side of the emulator core for pcem-bench. These stand in for the parts
+  of the wx-ui frontend the core calls into - there is no window, no input and
+  no viewers, so all of them do nothing apart from the bitmap and timer
+  functions, which the benchmarks rely on*/
+
+uint64_t timer_freq;
+uint64_t timer_read() { return SDL_GetPerformanceCounter(); }
+
+void hline(VIDEO_BITMAP *b, int x1, int y, int x2, int col) {
+        if (y < 0 || y >= buffer32->h)
+                return;
+
+        for (; x1 < x2; x1++)
+                ((uint32_t *)b->line[y])[x1] = col;
+}
+
+void destroy_bitmap(VIDEO_BITMAP *b) {
+        free(b->dat);
+        free(b);
+}
+
+VIDEO_BITMAP *create_bitmap(int x, int y) {
+        VIDEO_BITMAP *b = malloc(sizeof(VIDEO_BITMAP) + (y * sizeof(uint8_t *)));
+        int c;
+        b->dat = malloc(x * y * 4);
+        for (c = 0; c < y; c++) {
+                b->line[c] = b->dat + (c * x * 4);
+        }
+        b->w = x;
+        b->h = y;
+        return b;
+}
+
+void startblit() {}
+void endblit() {}
+void set_window_title(const char *s) {}
+void updatewindowsize(int x, int y) {}
+void stop_emulation_now(void) {}
+
+joystick_t joystick_state[MAX_JOYSTICKS];
+void joystick_poll() {}
+
+uint8_t pcem_key[272];
+void keyboard_poll_host() {}
+
+int mouse_buttons;
+void mouse_poll_host() {}
+void mouse_get_mickeys(int *x, int *y, int *z) { *x = *y = *z = 0; }
+
+viewer_t viewer_font;
+viewer_t viewer_palette;
+viewer_t viewer_palette_16;
+viewer_t viewer_voodoo;
+viewer_t viewer_vram;
+
+void viewer_reset() {}
+void viewer_add(char *title, viewer_t *viewer, void *p) {}
+void viewer_update(viewer_t *viewer, void *p) {}
+void viewer_call(viewer_t *viewer, void *p, void (*func)(void *v, void *param), void *param) {}
+void viewer_close_all() {}
+
+void voodoo_viewer_swap_buffer(void *v, void *param) {}
+void voodoo_viewer_queue_triangle(void *v, void *param) {}
+void voodoo_viewer_begin_strip(void *v, void *param) {}
+void voodoo_viewer_end_strip(void *v, void *param) {}
+void voodoo_viewer_use_texture(void *v, void *param) {}
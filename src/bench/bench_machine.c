@@ -0,0 +1,96 @@
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__APPLE__) && defined(__aarch64__)
+#include <pthread.h>
+#endif
+#include "ibm.h"
+#include "cpu.h"
+#include "codegen.h"
+#include "config.h"
+#include "device.h"
+#include "mem.h"
+#include "model.h"
+#include "io.h"
+#include "paths.h"
+#include "pic.h"
+#include "plugin.h"
+#include "sound.h"
+#include "sound_out.h"
+#include "timer.h"
+#include "video.h"
+#include "x86.h"
+#include "bench.h"
+
+/*Emulator core setup shared by pcem-bench and pcem-voodoo-replay*/
+
+char bench_tmp_path[512] = "./";
+
+/*fatal() calls this - don't overwrite the user's CMOS for the bench machine*/
+static void bench_savenvr() {}
+
+void bench_core_init(char *roms_path) {
+        timer_freq = SDL_GetPerformanceFrequency();
+
+        _savenvr = bench_savenvr;
+        _dumppic = dumppic;
+        _dumpregs = dumpregs;
+        _sound_speed_changed = sound_speed_changed;
+
+        paths_init();
+        set_logs_path(bench_tmp_path);
+        if (roms_path)
+                set_roms_paths(roms_path);
+
+        init_plugin_engine();
+        model_init_builtin();
+        model = model_get_model_from_internal_name("p55t2p4");
+
+        device_init();
+        initvideo();
+        mem_size = 16384;
+        mem_init();
+#if defined(__APPLE__) && defined(__aarch64__)
+        pthread_jit_write_protect_np(0);
+#endif
+        codegen_init();
+#if defined(__APPLE__) && defined(__aarch64__)
+        pthread_jit_write_protect_np(1);
+#endif
+        cpu_use_dynarec = 1;
+
+        /*No host audio - mixed blocks go to the null sink, which discards them*/
+        sound_sink = SOUND_SINK_NULL;
+        sound_buf_len = 200;
+        sound_update_buf_length();
+        sound_init();
+}
+
+void bench_core_close() {
+        device_close_all();
+        closevideo();
+}
+
+void bench_machine_init() {
+        device_close_all();
+        device_init();
+
+        timer_reset();
+        sound_reset();
+        io_init();
+
+        AT = 1;
+        cpu_manufacturer = 0;
+        cpu = 0;
+        cpu_set();
+        setpitclock(models[model]->cpu[cpu_manufacturer].cpus[cpu].rspeed);
+        mem_alloc();
+        resetx86();
+
+        sound_speed_changed();
+
+        cycles = cycles_main = 0;
+        tsc = 0;
+}
+
+void bench_tmp_file(char *s, const char *fn, int size) { append_filename(s, bench_tmp_path, (char *)fn, size); }
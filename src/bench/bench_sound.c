@@ -0,0 +1,179 @@
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "device.h"
+#include "io.h"
+#include "sound.h"
+#include "sound_emu8k.h"
+#include "sound_gus.h"
+#include "sound_mpu401_uart.h"
+#include "sound_opl.h"
+#include "sound_sb.h"
+#include "sound_sb_dsp.h"
+#include "timer.h"
+#include "bench.h"
+
+/*Sound card mixing. Each iteration runs the emulated timers for one mixer
+  block of SOUND_BENCH_BLOCK samples at 48 kHz, so the card's own sample timers
+  and its get_buffer() handler are both included. Output goes to the null sink
+  set up by bench.c. One operation is one 48 kHz output sample*/
+
+#define SOUND_BENCH_BLOCK 2400
+
+typedef struct bench_sound_t {
+        uint64_t block_time;
+} bench_sound_t;
+
+static bench_sound_t *bench_sound_init(device_t *d) {
+        bench_sound_t *bench = malloc(sizeof(bench_sound_t));
+
+        bench_machine_init();
+        device_add(d);
+
+        bench->block_time = (uint64_t)(((double)TIMER_USEC * (1000000.0 / 48000.0) * SOUND_BENCH_BLOCK) / (double)(1ull << 32));
+
+        return bench;
+}
+
+static void bench_sound_close(void *p) {
+        device_close_all();
+        free(p);
+}
+
+static uint64_t bench_sound_run(void *p, int iterations) {
+        bench_sound_t *bench = p;
+        uint64_t end = tsc + bench->block_time * iterations;
+
+        while (tsc < end) {
+                tsc += (uint32_t)(timer_target - (uint32_t)tsc);
+                timer_process();
+        }
+
+        return (uint64_t)iterations * SOUND_BENCH_BLOCK;
+}
+
+/*OPL3 on a Sound Blaster 16, with all 18 two-operator channels keyed on*/
+static void bench_opl3_write(int bank, uint8_t reg, uint8_t val) {
+        outb(0x388 + bank * 2, reg);
+        outb(0x389 + bank * 2, val);
+}
+
+static void *bench_sb16_opl3_init() {
+        static const uint8_t op_offsets[9] = {0, 1, 2, 8, 9, 10, 16, 17, 18};
+        bench_sound_t *bench = bench_sound_init(&sb_16_device);
+        int bank, ch;
+
+        /*OPL3 mode*/
+        bench_opl3_write(1, 0x05, 0x01);
+        for (bank = 0; bank < 2; bank++) {
+                for (ch = 0; ch < 9; ch++) {
+                        int op = op_offsets[ch];
+                        int fnum = 0x200 + ch * 0x20;
+
+                        bench_opl3_write(bank, 0x20 + op, 0x21);
+                        bench_opl3_write(bank, 0x23 + op, 0x21);
+                        bench_opl3_write(bank, 0x40 + op, 0x10);
+                        bench_opl3_write(bank, 0x43 + op, 0x00);
+                        bench_opl3_write(bank, 0x60 + op, 0xf4);
+                        bench_opl3_write(bank, 0x63 + op, 0xf4);
+                        bench_opl3_write(bank, 0x80 + op, 0x05);
+                        bench_opl3_write(bank, 0x83 + op, 0x05);
+                        bench_opl3_write(bank, 0xe0 + op, ch & 3);
+                        bench_opl3_write(bank, 0xe3 + op, 0);
+                        bench_opl3_write(bank, 0xc0 + ch, 0x30 | (3 << 1));
+                        bench_opl3_write(bank, 0xa0 + ch, fnum & 0xff);
+                        bench_opl3_write(bank, 0xb0 + ch, 0x20 | (4 << 2) | (fnum >> 8));
+                }
+        }
+
+        return bench;
+}
+
+/*Gravis UltraSound with all 32 voices looping over an 8-bit sample, so the
+  wave engine runs at its slowest output rate but with every voice active*/
+static void bench_gus_write(uint8_t reg, uint16_t val) {
+        outb(0x343, reg);
+        outb(0x344, val & 0xff);
+        outb(0x345, val >> 8);
+}
+
+static void bench_gus_write_high(uint8_t reg, uint8_t val) {
+        outb(0x343, reg);
+        outb(0x345, val);
+}
+
+static void *bench_gus_init() {
+        bench_sound_t *bench = bench_sound_init(&gus_device);
+        int c;
+
+        /*Out of reset, 32 active voices*/
+        bench_gus_write_high(0x4c, 3);
+        bench_gus_write_high(0x0e, 31);
+
+        for (c = 0; c < 0x1000; c++) {
+                bench_gus_write(0x43, c);
+                bench_gus_write_high(0x44, 0);
+                outb(0x347, (c & 0xff) ^ 0x80);
+        }
+
+        /*Every voice loops over 0-0x1000 at just under 1.0 pitch, so the
+          interpolating path is taken*/
+        for (c = 0; c < 32; c++) {
+                outb(0x342, c);
+                bench_gus_write(0x02, 0);
+                bench_gus_write(0x03, 0);
+                bench_gus_write(0x04, 0x20);
+                bench_gus_write(0x05, 0);
+                bench_gus_write(0x0a, 0);
+                bench_gus_write(0x0b, 0);
+                bench_gus_write(0x01, 0x300 + c * 8);
+                bench_gus_write_high(0x09, 0xf0);
+                bench_gus_write_high(0x0c, c & 15);
+                bench_gus_write_high(0x00, 0x08);
+        }
+
+        return bench;
+}
+
+/*AWE32 with all 32 EMU8000 voices looping over the sample ROM. Needs
+  awe32.raw*/
+static void bench_emu8k_write(uint16_t port, int reg, int voice, uint16_t val) {
+        outw(0xe22, (reg << 5) | voice);
+        outw(port, val);
+}
+
+static void *bench_awe32_init() {
+        bench_sound_t *bench;
+        int c;
+
+        if (!device_available(&sb_awe32_device)) {
+                bench_skip("awe32.raw not found");
+                return NULL;
+        }
+
+        bench = bench_sound_init(&sb_awe32_device);
+
+        /*Envelope engine off and no attenuation, so each voice plays at full
+          volume from CCCA and loops between PSST and CSL*/
+        for (c = 0; c < 32; c++) {
+                uint32_t start = 0x1000 + c * 0x400;
+                uint32_t end = start + 0x3ff;
+
+                bench_emu8k_write(0xa20, 5, c, 0x0080);
+                bench_emu8k_write(0xe20, 1, c, 0xff00);
+                bench_emu8k_write(0xe20, 0, c, 0xe000 - c * 0x40);
+                bench_emu8k_write(0x620, 6, c, start & 0xffff);
+                bench_emu8k_write(0x622, 6, c, (start >> 16) | ((c * 8) << 8));
+                bench_emu8k_write(0x620, 7, c, end & 0xffff);
+                bench_emu8k_write(0x622, 7, c, end >> 16);
+                bench_emu8k_write(0xa20, 0, c, start & 0xffff);
+                bench_emu8k_write(0xa22, 0, c, start >> 16);
+        }
+
+        return bench;
+}
+
+bench_t bench_sound[] = {{"sb16_opl3", "sample", bench_sb16_opl3_init, bench_sound_run, bench_sound_close},
+                         {"gus", "sample", bench_gus_init, bench_sound_run, bench_sound_close},
+                         {"awe32", "sample", bench_awe32_init, bench_sound_run, bench_sound_close},
+                         {NULL, NULL, NULL, NULL, NULL}};
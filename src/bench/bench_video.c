@@ -0,0 +1,247 @@
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "config.h"
+#include "device.h"
+#include "mem.h"
+#include "thread.h"
+#include "video.h"
+#include "vid_svga.h"
+#include "vid_svga_compose.h"
+#include "vid_svga_render.h"
+#include "vid_voodoo.h"
+#include "vid_voodoo_common.h"
+#include "vid_voodoo_reg.h"
+#include "vid_voodoo_regs.h"
+#include "vid_voodoo_render.h"
+#include "vid_voodoo_texture.h"
+#include "bench.h"
+
+/*SVGA scanline renderers, on a bare svga_t in 1024x768 framebuffer-only mode
+  with every line marked changed. One operation is one scanline*/
+#define BENCH_SVGA_VRAM (4 << 20)
+#define BENCH_SVGA_WIDTH 1024
+#define BENCH_SVGA_HEIGHT 768
+
+typedef struct bench_svga_t {
+        svga_t svga;
+        void (*render)(svga_t *svga);
+        svga_compose_t *compose;
+} bench_svga_t;
+
+static void *bench_svga_init(void (*render)(svga_t *svga)) {
+        bench_svga_t *bench = malloc(sizeof(bench_svga_t));
+        svga_t *svga = &bench->svga;
+        int c;
+
+        memset(bench, 0, sizeof(bench_svga_t));
+        bench->render = render;
+
+        svga->vram = malloc(BENCH_SVGA_VRAM);
+        svga->changedvram = malloc(BENCH_SVGA_VRAM >> 12);
+        svga->vram_display_mask = BENCH_SVGA_VRAM - 1;
+        for (c = 0; c < BENCH_SVGA_VRAM; c++)
+                svga->vram[c] = (c * 0x9e3779b1) >> 24;
+        memset(svga->changedvram, 0, BENCH_SVGA_VRAM >> 12);
+
+        for (c = 0; c < 256; c++)
+                svga->pallook[c] = makecol32(c, c ^ 0x55, 255 - c);
+        for (c = 0; c < 16; c++)
+                svga->egapal[c] = c;
+        svga->plane_mask = 0xf;
+        svga->hdisp = BENCH_SVGA_WIDTH;
+        svga->fullchange = 1;
+        svga->firstline_draw = 2000;
+        svga->fb_only = 1;
+        svga_recalc_remap_func(svga);
+
+        return bench;
+}
+
+static void bench_svga_close(void *p) {
+        bench_svga_t *bench = p;
+
+        free(bench->svga.changedvram);
+        free(bench->svga.vram);
+        free(bench);
+}
+
+static uint64_t bench_svga_run(void *p, int iterations) {
+        bench_svga_t *bench = p;
+        svga_t *svga = &bench->svga;
+        int c, line;
+
+        for (c = 0; c < iterations; c++) {
+                for (line = 0; line < BENCH_SVGA_HEIGHT; line++) {
+                        svga->displine = line;
+                        svga->ma = line * (BENCH_SVGA_WIDTH * 4);
+                        bench->render(svga);
+                }
+        }
+
+        return (uint64_t)iterations * BENCH_SVGA_HEIGHT;
+}
+
+static void *bench_svga_4bpp_init() { return bench_svga_init(svga_render_4bpp_highres); }
+static void *bench_svga_8bpp_init() { return bench_svga_init(svga_render_8bpp_highres); }
+static void *bench_svga_15bpp_init() { return bench_svga_init(svga_render_15bpp_highres); }
+static void *bench_svga_16bpp_init() { return bench_svga_init(svga_render_16bpp_highres); }
+static void *bench_svga_24bpp_init() { return bench_svga_init(svga_render_24bpp_highres); }
+static void *bench_svga_32bpp_init() { return bench_svga_init(svga_render_32bpp_highres); }
+
+/*The same frames through the deferred composer, recording each line and then
+  drawing the frame on BENCH_SVGA_COMPOSE_THREADS workers plus this thread*/
+#define BENCH_SVGA_COMPOSE_THREADS 3
+
+static void *bench_svga_compose_init(void (*render)(svga_t *svga)) {
+        bench_svga_t *bench = bench_svga_init(render);
+
+        bench->svga.render = render;
+        bench->compose = svga_compose_init(&bench->svga, BENCH_SVGA_COMPOSE_THREADS);
+
+        return bench;
+}
+
+static void bench_svga_compose_close(void *p) {
+        bench_svga_t *bench = p;
+
+        svga_compose_close(bench->compose);
+        bench_svga_close(p);
+}
+
+static uint64_t bench_svga_compose_run(void *p, int iterations) {
+        bench_svga_t *bench = p;
+        svga_t *svga = &bench->svga;
+        int c, line;
+
+        for (c = 0; c < iterations; c++) {
+                for (line = 0; line < BENCH_SVGA_HEIGHT; line++) {
+                        svga->displine = line;
+                        svga->ma = line * (BENCH_SVGA_WIDTH * 4);
+                        svga_compose_line(bench->compose);
+                }
+                svga_compose_flush(bench->compose);
+        }
+
+        return (uint64_t)iterations * BENCH_SVGA_HEIGHT;
+}
+
+static void *bench_svga_compose_8bpp_init() { return bench_svga_compose_init(svga_render_8bpp_highres); }
+static void *bench_svga_compose_32bpp_init() { return bench_svga_compose_init(svga_render_32bpp_highres); }
+
+/*Voodoo Graphics rasteriser. voodoo_triangle() is called directly on this
+  thread for each render thread's set of lines, so the FIFO and render thread
+  handoff are not included. Rendering uses the recompiler if it is enabled for
+  this host, the _interp variants use the interpreted pipeline that hosts
+  without a recompiler get. One operation is one pixel*/
+typedef struct bench_voodoo_t {
+        voodoo_set_t *set;
+        voodoo_t *voodoo;
+        int textured;
+} bench_voodoo_t;
+
+static void *bench_voodoo_init(int textured, int recompiler) {
+        bench_voodoo_t *bench = malloc(sizeof(bench_voodoo_t));
+        voodoo_t *voodoo;
+        int c;
+
+        bench_machine_init();
+
+        config_set_int(CFG_MACHINE, voodoo_device.name, "recompiler", recompiler);
+        current_device = &voodoo_device;
+        bench->set = voodoo_device.init();
+        bench->voodoo = voodoo = bench->set->voodoos[0];
+        bench->textured = textured;
+
+        /*640x480, 16-bit colour and depth*/
+        voodoo->fbiInit1 = 10 << 4;
+        voodoo->fbiInit2 = 150 << 11;
+        voodoo_recalc(voodoo);
+
+        voodoo_reg_writel(SST_clipLeftRight, 640, voodoo);
+        voodoo_reg_writel(SST_clipLowYHighY, 480, voodoo);
+        voodoo_reg_writel(SST_fbzMode,
+                          FBZ_RGB_WMASK | FBZ_DEPTH_ENABLE | FBZ_DEPTH_WMASK | (DEPTHOP_ALWAYS << 5) | FBZ_DITHER | 1, voodoo);
+        voodoo_reg_writel(SST_alphaMode, 0, voodoo);
+
+        /*A 300x380 pixel triangle, vertices in 12.4 fixed point*/
+        voodoo_reg_writel(SST_vertexAx, 100 << 4, voodoo);
+        voodoo_reg_writel(SST_vertexAy, 20 << 4, voodoo);
+        voodoo_reg_writel(SST_vertexBx, 400 << 4, voodoo);
+        voodoo_reg_writel(SST_vertexBy, 200 << 4, voodoo);
+        voodoo_reg_writel(SST_vertexCx, 60 << 4, voodoo);
+        voodoo_reg_writel(SST_vertexCy, 400 << 4, voodoo);
+
+        voodoo_reg_writel(SST_startR, 0x20 << 12, voodoo);
+        voodoo_reg_writel(SST_startG, 0x80 << 12, voodoo);
+        voodoo_reg_writel(SST_startB, 0xe0 << 12, voodoo);
+        voodoo_reg_writel(SST_dRdX, 1 << 11, voodoo);
+        voodoo_reg_writel(SST_dGdY, 1 << 10, voodoo);
+        voodoo_reg_writel(SST_startZ, 0x8000 << 12, voodoo);
+
+        if (textured) {
+                /*256x256 RGB565 texture, bilinear filtered with perspective
+                  correction, one texel per pixel*/
+                for (c = 0; c < 256 * 256; c++)
+                        ((uint16_t *)voodoo->tex_mem[0])[c] = (c * 0x9e3779b1) >> 16;
+
+                voodoo_reg_writel(SST_fbzColorPath, FBZCP_TEXTURE_ENABLED | 1, voodoo);
+                voodoo_reg_writel(SST_textureMode, (TEX_R5G6B5 << 8) | TEXTUREMODE_LOCAL | 6 | 1, voodoo);
+                voodoo_reg_writel(SST_tLOD, 0, voodoo);
+                voodoo_reg_writel(SST_texBaseAddr, 0, voodoo);
+                voodoo_reg_writel(SST_startS, 0, voodoo);
+                voodoo_reg_writel(SST_startT, 0, voodoo);
+                voodoo_reg_writel(SST_startW, 1 << 30, voodoo);
+                voodoo_reg_writel(SST_dSdX, 1 << 18, voodoo);
+                voodoo_reg_writel(SST_dTdY, 1 << 18, voodoo);
+
+                voodoo_use_texture(voodoo, &voodoo->params, 0);
+        } else
+                voodoo_reg_writel(SST_fbzColorPath, 0, voodoo);
+
+        voodoo->params.sign = 0;
+
+        return bench;
+}
+
+static void bench_voodoo_close(void *p) {
+        bench_voodoo_t *bench = p;
+
+        voodoo_device.close(bench->set);
+        free(bench);
+}
+
+static uint64_t bench_voodoo_run(void *p, int iterations) {
+        bench_voodoo_t *bench = p;
+        voodoo_t *voodoo = bench->voodoo;
+        uint32_t start_pixels = voodoo->fbiPixelsIn;
+        int c, odd_even;
+
+        for (c = 0; c < iterations; c++) {
+                for (odd_even = 0; odd_even < voodoo->render_threads; odd_even++)
+                        voodoo_triangle(voodoo, &voodoo->params, odd_even);
+        }
+
+        return voodoo->fbiPixelsIn - start_pixels;
+}
+
+static void *bench_voodoo_gouraud_init() { return bench_voodoo_init(0, 1); }
+static void *bench_voodoo_textured_init() { return bench_voodoo_init(1, 1); }
+static void *bench_voodoo_gouraud_interp_init() { return bench_voodoo_init(0, 0); }
+static void *bench_voodoo_textured_interp_init() { return bench_voodoo_init(1, 0); }
+
+bench_t bench_video[] = {
+        {"svga_render_4bpp", "line", bench_svga_4bpp_init, bench_svga_run, bench_svga_close},
+        {"svga_render_8bpp", "line", bench_svga_8bpp_init, bench_svga_run, bench_svga_close},
+        {"svga_render_15bpp", "line", bench_svga_15bpp_init, bench_svga_run, bench_svga_close},
+        {"svga_render_16bpp", "line", bench_svga_16bpp_init, bench_svga_run, bench_svga_close},
+        {"svga_render_24bpp", "line", bench_svga_24bpp_init, bench_svga_run, bench_svga_close},
+        {"svga_render_32bpp", "line", bench_svga_32bpp_init, bench_svga_run, bench_svga_close},
+        {"svga_compose_8bpp", "line", bench_svga_compose_8bpp_init, bench_svga_compose_run, bench_svga_compose_close},
+        {"svga_compose_32bpp", "line", bench_svga_compose_32bpp_init, bench_svga_compose_run, bench_svga_compose_close},
+        {"voodoo_triangle_gouraud", "pixel", bench_voodoo_gouraud_init, bench_voodoo_run, bench_voodoo_close},
+        {"voodoo_triangle_textured", "pixel", bench_voodoo_textured_init, bench_voodoo_run, bench_voodoo_close},
+        {"voodoo_triangle_gouraud_interp", "pixel", bench_voodoo_gouraud_interp_init, bench_voodoo_run, bench_voodoo_close},
+        {"voodoo_triangle_textured_interp", "pixel", bench_voodoo_textured_interp_init, bench_voodoo_run,
+         bench_voodoo_close},
+        {NULL, NULL, NULL, NULL, NULL}};
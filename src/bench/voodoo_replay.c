@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "config.h"
+#include "device.h"
+#include "mem.h"
+#include "paths.h"
+#include "thread.h"
+#include "video.h"
+#include "vid_svga.h"
+#include "vid_voodoo.h"
+#include "vid_voodoo_common.h"
+#include "vid_voodoo_fifo.h"
+#include "vid_voodoo_trace.h"
+#include "bench.h"
+
+/*pcem-voodoo-replay - replays a Voodoo command stream captured with the
+  voodoo_trace option, with no CPU emulation.
+
+  Recorded writes are passed to the card's memory handlers in order, so they go
+  through voodoo_queue_command() or the CMDFIFO to the FIFO and render threads
+  exactly as writes from the emulated CPU would. No timers run, so the FIFO
+  threads are woken every REPLAY_WAKE_WRITES writes instead of by the wake
+  timer, and at the end of each frame the replay waits for every card to go
+  idle, with the swap done without waiting for vsync. A frame's time therefore
+  covers feeding and completely drawing it.
+
+  Output is one JSON object per line per frame, then a summary :
+
+  {"frame":N,"ms":X,"triangles":N,"pixels":N}
+  {"summary":1,"version":"...","frames":N,"seconds":X,"triangles":N,"pixels":N,
+   "triangles_per_sec":X,"pixels_per_sec":X,"frame_ms_min":X,"frame_ms_median":X,
+   "frame_ms_max":X,"checksums":N,"checksum_mismatches":N}
+
+  A checksum that doesn't match the capture is reported as
+  {"frame":N,"card":N,"checksum":"mismatch","expected":"...","got":"..."} and
+  makes the exit status 2.*/
+
+#define REPLAY_WAKE_WRITES 256
+
+typedef struct replay_t {
+        FILE *f;
+        FILE *out;
+        voodoo_set_t *set;
+        svga_t *svga;
+
+        int frames, max_frames;
+        double *frame_ms;
+        int frame_ms_size;
+
+        uint64_t frame_start;
+        uint32_t frame_tris, frame_pixels;
+        uint64_t total_tris, total_pixels;
+        uint64_t total_time;
+
+        int checksums, mismatches;
+        int writes;
+} replay_t;
+
+static int replay_read(replay_t *replay, void *p, int size) { return fread(p, size, 1, replay->f) == 1; }
+
+/*tri_count counts once per render thread, so count triangles as they are
+  queued to the render threads*/
+static uint32_t replay_tri_count(replay_t *replay) {
+        uint32_t count = 0;
+        int c;
+
+        for (c = 0; c < replay->set->nr_cards; c++)
+                count += replay->set->voodoos[c]->params_write_idx;
+
+        return count;
+}
+
+static uint32_t replay_pixel_count(replay_t *replay) {
+        uint32_t count = 0;
+        int c, d;
+
+        for (c = 0; c < replay->set->nr_cards; c++) {
+                for (d = 0; d < 4; d++)
+                        count += replay->set->voodoos[c]->pixel_count[d];
+        }
+
+        return count;
+}
+
+static void replay_frame_start(replay_t *replay) {
+        replay->frame_tris = replay_tri_count(replay);
+        replay->frame_pixels = replay_pixel_count(replay);
+        replay->frame_start = timer_read();
+}
+
+static void replay_wake(replay_t *replay) {
+        int c;
+
+        for (c = 0; c < replay->set->nr_cards; c++)
+                voodoo_wake_fifo_thread_now(replay->set->voodoos[c]);
+}
+
+static void replay_frame_end(replay_t *replay, uint32_t frame) {
+        uint64_t elapsed;
+        uint32_t tris, pixels;
+        int c;
+
+        for (c = 0; c < replay->set->nr_cards; c++)
+                voodoo_trace_sync(replay->set->voodoos[c]);
+        elapsed = timer_read() - replay->frame_start;
+        tris = replay_tri_count(replay) - replay->frame_tris;
+        pixels = replay_pixel_count(replay) - replay->frame_pixels;
+
+        if (replay->frames == replay->frame_ms_size) {
+                replay->frame_ms_size = replay->frame_ms_size ? replay->frame_ms_size * 2 : 1024;
+                replay->frame_ms = realloc(replay->frame_ms, replay->frame_ms_size * sizeof(double));
+        }
+        replay->frame_ms[replay->frames++] = ((double)elapsed * 1000.0) / (double)timer_freq;
+        replay->total_time += elapsed;
+        replay->total_tris += tris;
+        replay->total_pixels += pixels;
+
+        fprintf(replay->out, "{\"frame\":%u,\"ms\":%.3f,\"triangles\":%u,\"pixels\":%u}\n", frame,
+                replay->frame_ms[replay->frames - 1], tris, pixels);
+
+        replay_frame_start(replay);
+}
+
+static void replay_checksum(replay_t *replay, voodoo_t *voodoo, int card, uint32_t expected) {
+        uint32_t got;
+
+        /*Not timed - the card is already idle from the end of the frame*/
+        voodoo_trace_sync(voodoo);
+        got = voodoo_trace_checksum(voodoo);
+        replay->checksums++;
+        if (got != expected) {
+                replay->mismatches++;
+                fprintf(replay->out,
+                        "{\"frame\":%i,\"card\":%i,\"checksum\":\"mismatch\",\"expected\":\"%08x\",\"got\":\"%08x\"}\n",
+                        replay->frames - 1, card, expected, got);
+        }
+        replay_frame_start(replay);
+}
+
+static int replay_run(replay_t *replay) {
+        uint32_t record[2];
+        uint32_t burst[VOODOO_TRACE_BURST_MAX];
+
+        replay_frame_start(replay);
+
+        while (replay_read(replay, record, sizeof(record))) {
+                int card = (record[0] & VOODOO_TRACE_CARD) ? 1 : 0;
+                uint32_t addr = record[0] & VOODOO_TRACE_ADDR_MASK;
+                voodoo_t *voodoo;
+                int c;
+
+                if (card >= replay->set->nr_cards) {
+                        printf("pcem-voodoo-replay : record for card %i, trace has %i\n", card, replay->set->nr_cards);
+                        return 0;
+                }
+                voodoo = replay->set->voodoos[card];
+
+                switch (record[0] >> VOODOO_TRACE_TYPE_SHIFT) {
+                case VOODOO_TRACE_WRITEL:
+                        voodoo->mapping.write_l(addr, record[1], voodoo->mapping.p);
+                        replay->writes++;
+                        break;
+
+                case VOODOO_TRACE_WRITEL_BURST:
+                        if (record[1] > VOODOO_TRACE_BURST_MAX || !replay_read(replay, burst, record[1] * 4)) {
+                                printf("pcem-voodoo-replay : bad burst record\n");
+                                return 0;
+                        }
+                        for (c = 0; c < record[1]; c++)
+                                voodoo->mapping.write_l(addr + c * 4, burst[c], voodoo->mapping.p);
+                        replay->writes += record[1];
+                        break;
+
+                case VOODOO_TRACE_WRITEW:
+                        voodoo->mapping.write_w(addr, record[1], voodoo->mapping.p);
+                        replay->writes++;
+                        break;
+
+                case VOODOO_TRACE_INIT_ENABLE:
+                        voodoo->initEnable = record[1];
+                        break;
+
+                case VOODOO_TRACE_FRAME:
+                        replay_frame_end(replay, record[1]);
+                        if (replay->max_frames && replay->frames >= replay->max_frames)
+                                return 1;
+                        break;
+
+                case VOODOO_TRACE_CHECKSUM:
+                        replay_checksum(replay, voodoo, card, record[1]);
+                        break;
+
+                default:
+                        printf("pcem-voodoo-replay : bad record %08x\n", record[0]);
+                        return 0;
+                }
+
+                if (replay->writes >= REPLAY_WAKE_WRITES) {
+                        replay_wake(replay);
+                        replay->writes = 0;
+                }
+        }
+
+        return 1;
+}
+
+static int replay_double_compare(const void *a, const void *b) {
+        double da = *(const double *)a;
+        double db = *(const double *)b;
+
+        return (da > db) - (da < db);
+}
+
+static void replay_summary(replay_t *replay) {
+        double seconds = (double)replay->total_time / (double)timer_freq;
+        double median = 0.0, min = 0.0, max = 0.0;
+
+        if (replay->frames) {
+                qsort(replay->frame_ms, replay->frames, sizeof(double), replay_double_compare);
+                min = replay->frame_ms[0];
+                median = replay->frame_ms[replay->frames / 2];
+                max = replay->frame_ms[replay->frames - 1];
+        }
+
+        fprintf(replay->out,
+                "{\"summary\":1,\"version\":\"%s\",\"frames\":%i,\"seconds\":%.3f,\"triangles\":%llu,\"pixels\":%llu,"
+                "\"triangles_per_sec\":%.1f,\"pixels_per_sec\":%.1f,\"frame_ms_min\":%.3f,\"frame_ms_median\":%.3f,"
+                "\"frame_ms_max\":%.3f,\"checksums\":%i,\"checksum_mismatches\":%i}\n",
+                PCEM_VERSION_STRING, replay->frames, seconds, (unsigned long long)replay->total_tris,
+                (unsigned long long)replay->total_pixels, seconds ? (double)replay->total_tris / seconds : 0.0,
+                seconds ? (double)replay->total_pixels / seconds : 0.0, min, median, max, replay->checksums,
+                replay->mismatches);
+}
+
+static void replay_usage() {
+        printf("pcem-voodoo-replay [options] trace\n\n");
+        printf("--threads n        - render threads per card, 1, 2 or 4 (default 2)\n");
+        printf("--no-recompiler    - use the interpreted pixel pipeline\n");
+        printf("--frames n         - stop after n frames\n");
+        printf("--output file      - write results to file rather than stdout\n");
+        printf("--tmpdir path      - directory for pcem.log (default .)\n");
+}
+
+int main(int argc, char **argv) {
+        voodoo_trace_header_t header;
+        replay_t replay;
+        const char *output = NULL;
+        const char *trace_fn = NULL;
+        int render_threads = 2;
+        int recompiler = 1;
+        int ok;
+        int c;
+
+        memset(&replay, 0, sizeof(replay));
+        replay.out = stdout;
+
+        for (c = 1; c < argc; c++) {
+                if (!strcasecmp(argv[c], "--help")) {
+                        replay_usage();
+                        return 0;
+                } else if (!strcasecmp(argv[c], "--no-recompiler")) {
+                        recompiler = 0;
+                } else if (argv[c][0] != '-') {
+                        trace_fn = argv[c];
+                } else if ((c + 1) == argc) {
+                        replay_usage();
+                        return 1;
+                } else if (!strcasecmp(argv[c], "--threads")) {
+                        render_threads = atoi(argv[++c]);
+                } else if (!strcasecmp(argv[c], "--frames")) {
+                        replay.max_frames = atoi(argv[++c]);
+                } else if (!strcasecmp(argv[c], "--output")) {
+                        output = argv[++c];
+                } else if (!strcasecmp(argv[c], "--tmpdir")) {
+                        safe_strncpy(bench_tmp_path, argv[++c], sizeof(bench_tmp_path) - 1);
+                        put_backslash(bench_tmp_path);
+                } else {
+                        replay_usage();
+                        return 1;
+                }
+        }
+
+        if (!trace_fn || (render_threads != 1 && render_threads != 2 && render_threads != 4)) {
+                replay_usage();
+                return 1;
+        }
+
+        replay.f = fopen(trace_fn, "rb");
+        if (!replay.f) {
+                printf("pcem-voodoo-replay : can't open %s\n", trace_fn);
+                return 1;
+        }
+        if (!replay_read(&replay, &header, sizeof(header)) || memcmp(header.magic, VOODOO_TRACE_MAGIC, sizeof(header.magic)) ||
+            header.version != VOODOO_TRACE_VERSION || header.type >= VOODOO_BANSHEE || header.nr_cards < 1 ||
+            header.nr_cards > 2) {
+                printf("pcem-voodoo-replay : %s is not a supported Voodoo trace\n", trace_fn);
+                fclose(replay.f);
+                return 1;
+        }
+
+        if (output) {
+                replay.out = fopen(output, "wt");
+                if (!replay.out) {
+                        printf("pcem-voodoo-replay : can't open %s\n", output);
+                        fclose(replay.f);
+                        return 1;
+                }
+        }
+
+        bench_core_init(NULL);
+        bench_machine_init();
+
+        /*Configure the card as it was captured*/
+        config_set_int(CFG_MACHINE, voodoo_device.name, "type", header.type);
+        config_set_int(CFG_MACHINE, voodoo_device.name, "sli", header.nr_cards == 2);
+        config_set_int(CFG_MACHINE, voodoo_device.name, "framebuffer_memory", header.fb_size);
+        config_set_int(CFG_MACHINE, voodoo_device.name, "texture_memory", header.texture_size);
+        config_set_int(CFG_MACHINE, voodoo_device.name, "bilinear", (header.flags & VOODOO_TRACE_BILINEAR) ? 1 : 0);
+        config_set_int(CFG_MACHINE, voodoo_device.name, "dithersub", (header.flags & VOODOO_TRACE_DITHERSUB) ? 1 : 0);
+        config_set_int(CFG_MACHINE, voodoo_device.name, "render_threads", render_threads);
+        config_set_int(CFG_MACHINE, voodoo_device.name, "recompiler", recompiler);
+
+        current_device = &voodoo_device;
+        replay.set = voodoo_device.init();
+
+        /*There is no VGA card for the passthrough switch to act on*/
+        replay.svga = malloc(sizeof(svga_t));
+        memset(replay.svga, 0, sizeof(svga_t));
+        for (c = 0; c < replay.set->nr_cards; c++)
+                replay.set->voodoos[c]->svga = replay.svga;
+
+        ok = replay_run(&replay);
+        for (c = 0; c < replay.set->nr_cards; c++)
+                voodoo_trace_sync(replay.set->voodoos[c]);
+        replay_summary(&replay);
+
+        voodoo_device.close(replay.set);
+        free(replay.svga);
+        free(replay.frame_ms);
+        bench_core_close();
+
+        fclose(replay.f);
+        if (replay.out != stdout)
+                fclose(replay.out);
+
+        if (!ok)
+                return 1;
+        return replay.mismatches ? 2 : 0;
+}
@@ -15,6 +15,7 @@
 #include "codegen_backend.h"
 #include "codegen_ir.h"
 #include "codegen_reg.h"
+#include "profiler.h"
 
 uint8_t *block_write_data = NULL;
 
@@ -467,6 +468,8 @@ void codegen_check_flush(page_t *page, uint64_t mask, uint32_t phys_addr) {
                         //                        pclog("Delete block from codegen_check_flush %08x %08x  %016llx %016llx %016llx
                         //                        %02x\n", phys_addr, block->pc, *block->dirty_mask, block->page_mask,
                         //                        *block->dirty_mask & block->page_mask, block->flags);
+                        if (profiler_enabled)
+                                profiler_block_flushed(block->phys, block->pc);
                         invalidate_block(block);
                         cpu_recomp_evicted++;
                 }
@@ -486,6 +489,8 @@ void codegen_check_flush(page_t *page, uint64_t mask, uint32_t phys_addr) {
                 if (*block->dirty_mask2 & block->page_mask2) {
                         //                        pclog("Delete block from codegen_check_flush2 %08x %08x\n", phys_addr,
                         //                        block->pc);*/
+                        if (profiler_enabled)
+                                profiler_block_flushed(block->phys, block->pc);
                         invalidate_block(block);
                         cpu_recomp_evicted++;
                 }
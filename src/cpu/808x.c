@@ -120,6 +120,16 @@ static int prefetchw = 0;
 
 static inline uint8_t FETCH() {
         uint8_t temp;
+
+        if (cpu_808x_fast) {
+                /*No queue - fetch directly and charge the bus cycles. These are
+                  reconciled against the opcode timing at the end of the
+                  instruction*/
+                temp = readmembf(cs + cpu_state.pc);
+                cpu_state.pc++;
+                memcycs += (4 >> is8086);
+                return temp;
+        }
         /*        temp=prefetchqueue[0];
                 prefetchqueue[0]=prefetchqueue[1];
                 prefetchqueue[1]=prefetchqueue[2];
@@ -173,7 +183,7 @@ static inline uint8_t FETCH() {
 static inline void FETCHADD(int c) {
         int d;
         //        if (output) printf("FETCHADD %i\n",c);
-        if (c < 0)
+        if (c < 0 || cpu_808x_fast)
                 return;
         if (prefetchw > ((is8086) ? 4 : 3))
                 return;
@@ -203,7 +213,7 @@ static inline void FETCHADD(int c) {
 
 static void FETCHCOMPLETE() {
         //        pclog("Fetchcomplete %i %i %i\n",fetchcycles&3,fetchcycles,prefetchw);
-        if (!(fetchcycles & 3))
+        if (!(fetchcycles & 3) || cpu_808x_fast)
                 return;
         if (prefetchw > ((is8086) ? 4 : 3))
                 return;
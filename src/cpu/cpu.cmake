@@ -1,5 +1,6 @@
 set(PCEM_PRIVATE_API ${PCEM_PRIVATE_API}
         ${CMAKE_SOURCE_DIR}/includes/private/cpu/cpu.h
+        ${CMAKE_SOURCE_DIR}/includes/private/cpu/profiler.h
         ${CMAKE_SOURCE_DIR}/includes/private/cpu/386_common.h
         ${CMAKE_SOURCE_DIR}/includes/private/cpu/386_ops.h
         ${CMAKE_SOURCE_DIR}/includes/private/cpu/8087.h
@@ -59,6 +60,7 @@ set(PCEM_SRC ${PCEM_SRC}
         cpu/808x.c
         cpu/cpu.c
         cpu/cpu_tables.c
+        cpu/profiler.c
         cpu/x86seg.c
         cpu/x87.c
         cpu/x87_timings.c
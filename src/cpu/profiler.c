@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "x86.h"
+#include "cpu.h"
+#include "mem.h"
+#include "codegen.h"
+#include "codegen_backend.h"
+#include "timer.h"
+#include "profiler.h"
+
+int profiler_enabled = 0;
+int profiler_interval = 1000;
+char profiler_fn[512] = "pcem_profile.txt";
+
+enum { PROFILER_MODE_INTERPRETER = 0, PROFILER_MODE_DYNAREC };
+
+static const char *profiler_mode_names[] = {"interpreter", "dynarec"};
+
+typedef struct profiler_sample_t {
+        uint32_t phys, eip;
+        uint16_t cs_sel;
+        uint8_t cpl, mode;
+        uint32_t count;
+} profiler_sample_t;
+
+typedef struct profiler_flush_t {
+        uint32_t phys, pc;
+        uint32_t count;
+} profiler_flush_t;
+
+#define PROFILER_SAMPLE_SIZE (1 << 16)
+#define PROFILER_FLUSH_SIZE (1 << 14)
+#define PROFILER_MAX_PROBE 32
+
+static profiler_sample_t *profiler_samples;
+static profiler_flush_t *profiler_flushes;
+static uint64_t profiler_total, profiler_mode_total[2], profiler_dropped;
+static uint64_t profiler_flush_total;
+
+static pc_timer_t profiler_timer;
+
+static inline uint32_t profiler_hash(uint32_t a, uint32_t b) { return ((a * 0x9e3779b1) ^ (b * 0x85ebca6b)) >> 8; }
+
+/*Would execution at this address run a compiled block? The timer fires between
+  blocks, so inrecomp itself is never set here*/
+static int profiler_block_compiled(uint32_t addr, uint32_t phys) {
+        codeblock_t *block;
+
+        if (!is386 || !cpu_use_dynarec || !codeblock || !codeblock_hash || phys == 0xffffffff)
+                return 0;
+
+        block = &codeblock[codeblock_hash[HASH(phys)]];
+        return block->pc == addr && block->_cs == cs && block->phys == phys && (block->flags & CODEBLOCK_WAS_RECOMPILED);
+}
+
+static void profiler_sample(void *p) {
+        uint32_t addr = cs + cpu_state.pc;
+        uint32_t phys;
+        uint32_t hash;
+        int mode;
+        int c;
+
+        if (cr0 >> 31)
+                phys = mmutranslate_noabrt(addr, 0);
+        else
+                phys = addr & rammask;
+        mode = profiler_block_compiled(addr, phys) ? PROFILER_MODE_DYNAREC : PROFILER_MODE_INTERPRETER;
+
+        profiler_total++;
+        profiler_mode_total[mode]++;
+
+        hash = profiler_hash(phys, cpu_state.pc ^ ((uint32_t)mode << 31));
+        for (c = 0; c < PROFILER_MAX_PROBE; c++) {
+                profiler_sample_t *s = &profiler_samples[(hash + c) & (PROFILER_SAMPLE_SIZE - 1)];
+
+                if (!s->count) {
+                        s->phys = phys;
+                        s->eip = cpu_state.pc;
+                        s->cs_sel = CS;
+                        s->cpl = CPL;
+                        s->mode = mode;
+                        s->count = 1;
+                        break;
+                }
+                if (s->phys == phys && s->eip == cpu_state.pc && s->cs_sel == CS && s->cpl == CPL && s->mode == mode) {
+                        s->count++;
+                        break;
+                }
+        }
+        if (c == PROFILER_MAX_PROBE)
+                profiler_dropped++;
+
+        timer_advance_u64(&profiler_timer, (uint64_t)profiler_interval * TIMER_USEC);
+}
+
+void profiler_block_flushed(uint32_t phys, uint32_t pc) {
+        uint32_t hash = profiler_hash(phys, pc);
+        int c;
+
+        if (!profiler_flushes)
+                return;
+
+        profiler_flush_total++;
+
+        for (c = 0; c < PROFILER_MAX_PROBE; c++) {
+                profiler_flush_t *f = &profiler_flushes[(hash + c) & (PROFILER_FLUSH_SIZE - 1)];
+
+                if (!f->count) {
+                        f->phys = phys;
+                        f->pc = pc;
+                        f->count = 1;
+                        return;
+                }
+                if (f->phys == phys && f->pc == pc) {
+                        f->count++;
+                        return;
+                }
+        }
+}
+
+void profiler_init() {
+        if (!profiler_enabled)
+                return;
+
+        if (!profiler_samples) {
+                profiler_samples = malloc(sizeof(profiler_sample_t) * PROFILER_SAMPLE_SIZE);
+                memset(profiler_samples, 0, sizeof(profiler_sample_t) * PROFILER_SAMPLE_SIZE);
+                profiler_flushes = malloc(sizeof(profiler_flush_t) * PROFILER_FLUSH_SIZE);
+                memset(profiler_flushes, 0, sizeof(profiler_flush_t) * PROFILER_FLUSH_SIZE);
+        }
+
+        /*Timer periods are limited to one second*/
+        if (profiler_interval < 10)
+                profiler_interval = 10;
+        if (profiler_interval > 1000000)
+                profiler_interval = 1000000;
+
+        timer_add(&profiler_timer, profiler_sample, NULL, 0);
+        timer_set_delay_u64(&profiler_timer, (uint64_t)profiler_interval * TIMER_USEC);
+}
+
+static int profiler_sample_compare(const void *a, const void *b) {
+        const profiler_sample_t *sa = *(const profiler_sample_t **)a;
+        const profiler_sample_t *sb = *(const profiler_sample_t **)b;
+
+        return (sa->count < sb->count) - (sa->count > sb->count);
+}
+
+static int profiler_flush_compare(const void *a, const void *b) {
+        const profiler_flush_t *fa = *(const profiler_flush_t **)a;
+        const profiler_flush_t *fb = *(const profiler_flush_t **)b;
+
+        return (fa->count < fb->count) - (fa->count > fb->count);
+}
+
+void profiler_close() {
+        profiler_sample_t **sorted_samples;
+        profiler_flush_t **sorted_flushes;
+        int nr_samples = 0, nr_flushes = 0;
+        FILE *f;
+        int c;
+
+        if (!profiler_samples)
+                return;
+
+        sorted_samples = malloc(sizeof(profiler_sample_t *) * PROFILER_SAMPLE_SIZE);
+        for (c = 0; c < PROFILER_SAMPLE_SIZE; c++) {
+                if (profiler_samples[c].count)
+                        sorted_samples[nr_samples++] = &profiler_samples[c];
+        }
+        qsort(sorted_samples, nr_samples, sizeof(profiler_sample_t *), profiler_sample_compare);
+
+        sorted_flushes = malloc(sizeof(profiler_flush_t *) * PROFILER_FLUSH_SIZE);
+        for (c = 0; c < PROFILER_FLUSH_SIZE; c++) {
+                if (profiler_flushes[c].count)
+                        sorted_flushes[nr_flushes++] = &profiler_flushes[c];
+        }
+        qsort(sorted_flushes, nr_flushes, sizeof(profiler_flush_t *), profiler_flush_compare);
+
+        /*Collapsed stack format - one line per unique sample, frames separated by
+          ';' and followed by the hit count*/
+        f = fopen(profiler_fn, "wt");
+        if (f) {
+                for (c = 0; c < nr_samples; c++) {
+                        profiler_sample_t *s = sorted_samples[c];
+
+                        fprintf(f, "%s;cpl%i;%04x:%08x@%08x %u\n", profiler_mode_names[s->mode], s->cpl, s->cs_sel, s->eip,
+                                s->phys, s->count);
+                }
+                for (c = 0; c < nr_flushes; c++)
+                        fprintf(f, "recompile;%08x@%08x %u\n", sorted_flushes[c]->pc, sorted_flushes[c]->phys,
+                                sorted_flushes[c]->count);
+                fclose(f);
+        } else
+                pclog("profiler_close : can't open %s\n", profiler_fn);
+
+        pclog("Profiler : %llu samples every %ius, %llu dropped\n", (unsigned long long)profiler_total, profiler_interval,
+              (unsigned long long)profiler_dropped);
+        if (profiler_total)
+                pclog("Profiler : interpreter %.1f%%, dynarec %.1f%%\n",
+                      (double)profiler_mode_total[PROFILER_MODE_INTERPRETER] * 100.0 / (double)profiler_total,
+                      (double)profiler_mode_total[PROFILER_MODE_DYNAREC] * 100.0 / (double)profiler_total);
+        for (c = 0; c < nr_samples && c < 20; c++) {
+                profiler_sample_t *s = sorted_samples[c];
+
+                pclog("  %5.1f%%  %04x:%08x  phys %08x  CPL%i  %s\n", (double)s->count * 100.0 / (double)profiler_total,
+                      s->cs_sel, s->eip, s->phys, s->cpl, profiler_mode_names[s->mode]);
+        }
+        pclog("Profiler : %llu code block invalidations\n", (unsigned long long)profiler_flush_total);
+        for (c = 0; c < nr_flushes && c < 20; c++)
+                pclog("  %8u  %08x  phys %08x\n", sorted_flushes[c]->count, sorted_flushes[c]->pc, sorted_flushes[c]->phys);
+
+        free(sorted_samples);
+        free(sorted_flushes);
+        free(profiler_samples);
+        free(profiler_flushes);
+        profiler_samples = NULL;
+        profiler_flushes = NULL;
+}
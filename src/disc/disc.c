@@ -9,6 +9,7 @@
 #include "timer.h"
 
 int disc_drivesel = 0;
+int disc_fast = 0;
 pc_timer_t disc_poll_timer;
 
 int disc_track[2];
@@ -65,9 +65,9 @@ void disc_sector_add(int drive, int side, uint8_t c, uint8_t h, uint8_t r, uint8
         disc_sector_count[drive][side]++;
 }
 
-static int get_bitcell_period() {
-        return (disc_sector_data[disc_sector_drive][disc_sector_side][cur_sector].rate * 300) / fdd_getrpm(disc_sector_drive);
-}
+static int sector_bitcell_period(sector_t *s) { return (s->rate * 300) / fdd_getrpm(disc_sector_drive); }
+
+static int get_bitcell_period() { return sector_bitcell_period(&disc_sector_data[disc_sector_drive][disc_sector_side][cur_sector]); }
 
 void disc_sector_readsector(int drive, int sector, int track, int side, int rate, int sector_size) {
         //        pclog("disc_sector_readsector: fdc_period=%i img_period=%i rate=%i sector=%i track=%i side=%i\n",
@@ -146,10 +146,60 @@ static void advance_byte() {
         }
 }
 
+/*Fast mode. A Read or Write Data sector is located and transferred by DMA on
+  the first poll after the command, instead of waiting for it to rotate under
+  the head. Anything unusual (missing sector, wrong density, write protect,
+  PIO transfers) falls through to the timed path, which reports the error*/
+static int disc_sector_fast_poll() {
+        sector_t *s;
+        int size;
+        int c;
+
+        if (!fdc_is_dma() || !fdd_can_read_medium(disc_sector_drive ^ fdd_swap))
+                return 0;
+        if (disc_sector_state == STATE_WRITE_FIND_SECTOR && writeprot[disc_sector_drive])
+                return 0;
+
+        s = NULL;
+        for (c = 0; c < disc_sector_count[disc_sector_drive][disc_sector_side]; c++) {
+                sector_t *cur = &disc_sector_data[disc_sector_drive][disc_sector_side][c];
+                if (disc_sector_track == cur->c && disc_sector_side == cur->h && disc_sector_sector == cur->r &&
+                    disc_sector_n == cur->n) {
+                        s = cur;
+                        break;
+                }
+        }
+        if (!s || fdc_get_bitcell_period() != sector_bitcell_period(s))
+                return 0;
+
+        size = 128 << s->n;
+        if (disc_sector_state == STATE_READ_FIND_SECTOR) {
+                for (c = 0; c < size; c++)
+                        fdc_data(s->data[c]);
+        } else {
+                for (c = 0; c < size; c++)
+                        s->data[c] = fdc_getdata(c == size - 1);
+                disc_sector_writeback[disc_sector_drive](disc_sector_drive, disc_sector_track);
+        }
+
+        /*Leave the head just past the sector, as the timed path would*/
+        cur_sector = (s - disc_sector_data[disc_sector_drive][disc_sector_side]) + 1;
+        cur_byte = 0;
+        disc_intersector_delay = 40;
+
+        disc_sector_state = STATE_IDLE;
+        fdc_finishread();
+        return 1;
+}
+
 void disc_sector_poll() {
         sector_t *s;
         int data;
 
+        if (disc_fast && (disc_sector_state == STATE_READ_FIND_SECTOR || disc_sector_state == STATE_WRITE_FIND_SECTOR) &&
+            disc_sector_fast_poll())
+                return;
+
         if (cur_sector >= disc_sector_count[disc_sector_drive][disc_sector_side])
                 cur_sector = 0;
         if (cur_byte >= (128 << disc_sector_data[disc_sector_drive][disc_sector_side][cur_sector].n))
@@ -33,8 +33,12 @@
 
 #if !defined(WIN32)
 #include <libgen.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #else
 #include <string.h>
+#include <windows.h>
 #endif
 
 using namespace std;
@@ -46,25 +50,172 @@ using namespace std;
 #define safe_strncpy(a, b, n) do { strncpy((a),(b),(n)-1); (a)[(n)-1] = 0; } while (0)
 
 CDROM_Interface_Image::BinaryFile::BinaryFile(const char *filename, bool &error) {
-	file = new ifstream(filename, ios::in | ios::binary);
-	error = (file == NULL) || (file->fail());
+#if defined(WIN32)
+	handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	error = (handle == INVALID_HANDLE_VALUE);
+	if (!error) {
+		LARGE_INTEGER size;
+		length = GetFileSizeEx((HANDLE)handle, &size) ? size.QuadPart : -1;
+	}
+#else
+	fd = open(filename, O_RDONLY);
+	error = (fd < 0);
+	if (!error) {
+		struct stat st;
+		length = fstat(fd, &st) ? -1 : (Bit64s)st.st_size;
+	}
+#endif
+	for (int c = 0; c < CACHE_BLOCKS; c++) {
+		cache[c].block = -1;
+		cache[c].last_used = 0;
+		cache[c].len = 0;
+		cache[c].data = NULL;
+	}
+	use_counter = 0;
+	last_miss = -2;
+	readahead_buf = NULL;
+	lock = thread_create_mutex();
 }
 
 CDROM_Interface_Image::BinaryFile::~BinaryFile() {
-	delete file;
+#if defined(WIN32)
+	if (handle != INVALID_HANDLE_VALUE)
+		CloseHandle((HANDLE)handle);
+#else
+	if (fd >= 0)
+		close(fd);
+#endif
+	for (int c = 0; c < CACHE_BLOCKS; c++)
+		delete[] cache[c].data;
+	delete[] readahead_buf;
+	thread_destroy_mutex(lock);
+}
+
+bool CDROM_Interface_Image::BinaryFile::readFile(Bit8u *buffer, Bit64s seek, int count, int *actual) {
+	*actual = 0;
+	while (count) {
+#if defined(WIN32)
+		OVERLAPPED ov;
+		DWORD ret;
+		memset(&ov, 0, sizeof(ov));
+		ov.Offset = (DWORD)seek;
+		ov.OffsetHigh = (DWORD)(seek >> 32);
+		if (!ReadFile((HANDLE)handle, buffer, count, &ret, &ov))
+			return GetLastError() == ERROR_HANDLE_EOF;
+#else
+		ssize_t ret = pread(fd, buffer, count, (off_t)seek);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+#endif
+		if (!ret)
+			break; /*EOF*/
+		buffer += ret;
+		seek += ret;
+		count -= ret;
+		*actual += ret;
+	}
+	return true;
+}
+
+CDROM_Interface_Image::BinaryFile::CacheBlock *CDROM_Interface_Image::BinaryFile::findBlock(Bit64s block) {
+	for (int c = 0; c < CACHE_BLOCKS; c++) {
+		if (cache[c].block == block) {
+			cache[c].last_used = ++use_counter;
+			return &cache[c];
+		}
+	}
+	return NULL;
+}
+
+/*Load block on a cache miss. If the miss follows on from the previous one, the
+  guest is streaming, so also load the following blocks*/
+CDROM_Interface_Image::BinaryFile::CacheBlock *CDROM_Interface_Image::BinaryFile::fetchBlocks(Bit64s block) {
+	int num = (block == last_miss + 1) ? READAHEAD_BLOCKS : 1;
+	Bit64s end_block = (length + CACHE_BLOCK_SIZE - 1) >> CACHE_BLOCK_SHIFT;
+	CacheBlock *first = NULL;
+	int actual;
+
+	last_miss = block + num - 1;
+	if (block + num > end_block)
+		num = (int)(end_block - block);
+	if (num <= 0)
+		return NULL;
+
+	if (!readahead_buf)
+		readahead_buf = new Bit8u[READAHEAD_BLOCKS * CACHE_BLOCK_SIZE];
+	if (!readFile(readahead_buf, block << CACHE_BLOCK_SHIFT, num * CACHE_BLOCK_SIZE, &actual))
+		return NULL;
+
+	for (int c = 0; c < num; c++) {
+		CacheBlock *victim = &cache[0];
+
+		if (c && findBlock(block + c))
+			continue;
+		for (int d = 1; d < CACHE_BLOCKS; d++) {
+			if (cache[d].last_used < victim->last_used)
+				victim = &cache[d];
+		}
+		if (!victim->data)
+			victim->data = new Bit8u[CACHE_BLOCK_SIZE];
+		victim->block = block + c;
+		victim->len = actual - c * CACHE_BLOCK_SIZE;
+		if (victim->len > CACHE_BLOCK_SIZE)
+			victim->len = CACHE_BLOCK_SIZE;
+		if (victim->len < 0)
+			victim->len = 0;
+		memcpy(victim->data, &readahead_buf[c * CACHE_BLOCK_SIZE], victim->len);
+		/*Read-ahead blocks are least recently used until actually hit*/
+		if (c)
+			victim->last_used = use_counter > CACHE_BLOCKS / 2 ? use_counter - CACHE_BLOCKS / 2 : 0;
+		else
+			victim->last_used = ++use_counter;
+		if (!c)
+			first = victim;
+	}
+	return first;
 }
 
-bool CDROM_Interface_Image::BinaryFile::read(Bit8u *buffer, int seek, int count) {
-	file->seekg(seek, ios::beg);
-	file->read((char *)buffer, count);
-	return !(file->fail());
+bool CDROM_Interface_Image::BinaryFile::read(Bit8u *buffer, Bit64s seek, int count) {
+	bool ret = true;
+
+	if (seek < 0)
+		return false;
+
+	thread_lock_mutex(lock);
+	while (count) {
+		Bit64s block = seek >> CACHE_BLOCK_SHIFT;
+		int offset = (int)(seek & (CACHE_BLOCK_SIZE - 1));
+		int len = CACHE_BLOCK_SIZE - offset;
+		CacheBlock *cb = findBlock(block);
+
+		if (!cb)
+			cb = fetchBlocks(block);
+		if (!cb || offset >= cb->len) {
+			ret = false;
+			break;
+		}
+		if (len > count)
+			len = count;
+		if (len > cb->len - offset) {
+			/*Short block at end of file*/
+			memcpy(buffer, &cb->data[offset], cb->len - offset);
+			ret = false;
+			break;
+		}
+		memcpy(buffer, &cb->data[offset], len);
+		buffer += len;
+		seek += len;
+		count -= len;
+	}
+	thread_unlock_mutex(lock);
+
+	return ret;
 }
 
-int CDROM_Interface_Image::BinaryFile::getLength() {
-	file->seekg(0, ios::end);
-	int length = (int)file->tellg();
-	if (file->fail())
-		return -1;
+Bit64s CDROM_Interface_Image::BinaryFile::getLength() {
 	return length;
 }
 
@@ -132,20 +283,38 @@ bool CDROM_Interface_Image::GetMediaTrayStatus(bool &mediaPresent, bool &mediaCh
 
 bool CDROM_Interface_Image::ReadSectors(PhysPt buffer, bool raw, unsigned long sector, unsigned long num) {
 	int sectorSize = raw ? RAW_SECTOR_SIZE : COOKED_SECTOR_SIZE;
-	Bitu buflen = num * sectorSize;
-	Bit8u *buf = new Bit8u[buflen];
+	Bit8u *buf = (Bit8u *)buffer;
 
-	bool success = true; //Gobliiins reads 0 sectors
-	for (unsigned long i = 0; i < num; i++) {
-		success = ReadSector(&buf[i * sectorSize], raw, sector + i);
-		if (!success)
-			break;
-	}
+	while (num) {
+		int track = GetTrack(sector) - 1;
+		if (track < 0)
+			return false;
 
-	memcpy((void *)buffer, buf, buflen);
-	delete[] buf;
+		/*Sectors stored in the requested format can be read straight from
+		  the image in one go, up to the end of the track*/
+		if (tracks[track].sectorSize == sectorSize && !tracks[track].mode2) {
+			unsigned long count = tracks[track].start + tracks[track].length - sector;
+			if (count > num)
+				count = num;
+			if (count) {
+				Bit64s seek = tracks[track].skip + (Bit64s)(sector - tracks[track].start) * sectorSize;
+				if (!tracks[track].file->read(buf, seek, count * sectorSize))
+					return false;
+				buf += count * sectorSize;
+				sector += count;
+				num -= count;
+				continue;
+			}
+		}
 
-	return success;
+		if (!ReadSector(buf, raw, sector))
+			return false;
+		buf += sectorSize;
+		sector++;
+		num--;
+	}
+
+	return true; //Gobliiins reads 0 sectors
 }
 
 bool CDROM_Interface_Image::LoadUnloadMedia(bool unload) {
@@ -171,7 +340,7 @@ bool CDROM_Interface_Image::ReadSector(Bit8u *buffer, bool raw, unsigned long se
 	if (track < 0)
 		return false;
 
-	int seek = tracks[track].skip + (sector - tracks[track].start) * tracks[track].sectorSize;
+	Bit64s seek = tracks[track].skip + (Bit64s)(sector - tracks[track].start) * tracks[track].sectorSize;
 	int length = (raw ? RAW_SECTOR_SIZE : COOKED_SECTOR_SIZE);
 	if (tracks[track].sectorSize != RAW_SECTOR_SIZE && raw)
 		return false;
@@ -231,7 +400,7 @@ bool CDROM_Interface_Image::LoadIsoFile(char *filename) {
 
 bool CDROM_Interface_Image::CanReadPVD(TrackFile *file, int sectorSize, bool mode2) {
 	Bit8u pvd[COOKED_SECTOR_SIZE];
-	int seek = 16 * sectorSize;        // first vd is located at sector 16
+	Bit64s seek = 16 * sectorSize;        // first vd is located at sector 16
 	if (sectorSize == RAW_SECTOR_SIZE && !mode2)
 		seek += 16;
 	if (mode2)
@@ -406,7 +575,7 @@ bool CDROM_Interface_Image::AddTrack(Track &curr, int &shift, int prestart, int
 	if (tracks.empty()) {
 		if (curr.number != 1)
 			return false;
-		curr.skip = skip * curr.sectorSize;
+		curr.skip = (Bit64s)skip * curr.sectorSize;
 		curr.start += currPregap;
 		totalPregap = currPregap;
 		tracks.push_back(curr);
@@ -419,18 +588,18 @@ bool CDROM_Interface_Image::AddTrack(Track &curr, int &shift, int prestart, int
 	if (prev.file == curr.file) {
 		curr.start += shift;
 		prev.length = curr.start + totalPregap - prev.start - skip;
-		curr.skip += prev.skip + prev.length * prev.sectorSize + skip * curr.sectorSize;
+		curr.skip += prev.skip + (Bit64s)prev.length * prev.sectorSize + (Bit64s)skip * curr.sectorSize;
 		totalPregap += currPregap;
 		curr.start += totalPregap;
 		// current track uses a different file as the previous track
 	} else {
-		int tmp = prev.file->getLength() - prev.skip;
+		Bit64s tmp = prev.file->getLength() - prev.skip;
 		prev.length = tmp / prev.sectorSize;
 		if (tmp % prev.sectorSize != 0)
 			prev.length++; // padding
 
 		curr.start += prev.start + prev.length + currPregap;
-		curr.skip = skip * curr.sectorSize;
+		curr.skip = (Bit64s)skip * curr.sectorSize;
 		shift += prev.start + prev.length;
 		totalPregap = currPregap;
 	}
@@ -228,6 +228,8 @@ void fdc_update_rate(int drive) {
 
 int fdc_get_bitcell_period() { return fdc.bitcell_period; }
 
+int fdc_is_dma() { return !fdc.pcjr && fdc.dma; }
+
 static int fdc_get_densel(int drive) {
         switch (fdc.rwc[drive]) {
         case 1:
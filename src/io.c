@@ -1,66 +1,91 @@
+#include <stdlib.h>
+#include <string.h>
 #include "ibm.h"
 #include "amstrad.h"
 #include "ide.h"
 #include "io.h"
+#include "io_profiler.h"
 #include "video.h"
 #include "cpu.h"
 
-uint8_t (*port_inb[0x10000][2])(uint16_t addr, void *priv);
-uint16_t (*port_inw[0x10000][2])(uint16_t addr, void *priv);
-uint32_t (*port_inl[0x10000][2])(uint16_t addr, void *priv);
+typedef struct io_handler_t {
+        uint8_t (*inb)(uint16_t addr, void *priv);
+        uint16_t (*inw)(uint16_t addr, void *priv);
+        uint32_t (*inl)(uint16_t addr, void *priv);
 
-void (*port_outb[0x10000][2])(uint16_t addr, uint8_t val, void *priv);
-void (*port_outw[0x10000][2])(uint16_t addr, uint16_t val, void *priv);
-void (*port_outl[0x10000][2])(uint16_t addr, uint32_t val, void *priv);
+        void (*outb)(uint16_t addr, uint8_t val, void *priv);
+        void (*outw)(uint16_t addr, uint16_t val, void *priv);
+        void (*outl)(uint16_t addr, uint32_t val, void *priv);
 
-void *port_priv[0x10000][2];
+        void *priv;
+} io_handler_t;
+
+typedef struct io_port_t {
+        io_handler_t h[2];
+
+        int (*insw)(uint16_t addr, uint16_t *buf, int count, void *priv);
+        int (*outsw)(uint16_t addr, const uint16_t *buf, int count, void *priv);
+        void *block_priv;
+} io_port_t;
+
+/*Port handlers are kept in 256-port blocks, allocated the first time a handler
+  is installed in that block. Unused blocks point at io_empty_block, so lookups
+  never need a NULL check. Most machines only touch a handful of blocks*/
+#define IO_BLOCK_SHIFT 8
+#define IO_BLOCK_SIZE (1 << IO_BLOCK_SHIFT)
+#define IO_BLOCK_MASK (IO_BLOCK_SIZE - 1)
+
+static io_port_t io_empty_block[IO_BLOCK_SIZE];
+static io_port_t *io_blocks[0x10000 >> IO_BLOCK_SHIFT];
+
+#define IO_PORT(port) (&io_blocks[(port) >> IO_BLOCK_SHIFT][(port)&IO_BLOCK_MASK])
+
+static io_port_t *io_port_alloc(uint16_t port) {
+        io_port_t **block = &io_blocks[port >> IO_BLOCK_SHIFT];
+
+        if (!*block || *block == io_empty_block) {
+                *block = malloc(sizeof(io_port_t) * IO_BLOCK_SIZE);
+                memset(*block, 0, sizeof(io_port_t) * IO_BLOCK_SIZE);
+        }
+
+        return &(*block)[port & IO_BLOCK_MASK];
+}
 
 void io_init() {
         int c;
         pclog("io_init\n");
-        for (c = 0; c < 0x10000; c++) {
-                port_inb[c][0] = NULL;
-                port_inw[c][0] = NULL;
-                port_inl[c][0] = NULL;
-                port_outb[c][0] = NULL;
-                port_outw[c][0] = NULL;
-                port_outl[c][0] = NULL;
-                port_inb[c][1] = NULL;
-                port_inw[c][1] = NULL;
-                port_inl[c][1] = NULL;
-                port_outb[c][1] = NULL;
-                port_outw[c][1] = NULL;
-                port_outl[c][1] = NULL;
-                port_priv[c][0] = NULL;
-                port_priv[c][1] = NULL;
+        for (c = 0; c < (0x10000 >> IO_BLOCK_SHIFT); c++) {
+                if (io_blocks[c] && io_blocks[c] != io_empty_block)
+                        free(io_blocks[c]);
+                io_blocks[c] = io_empty_block;
         }
 }
 
+static int io_handler_empty(io_handler_t *h) { return !h->inb && !h->inw && !h->inl && !h->outb && !h->outw && !h->outl; }
+
 void io_sethandler(uint16_t base, int size, uint8_t (*inb)(uint16_t addr, void *priv), uint16_t (*inw)(uint16_t addr, void *priv),
                    uint32_t (*inl)(uint16_t addr, void *priv), void (*outb)(uint16_t addr, uint8_t val, void *priv),
                    void (*outw)(uint16_t addr, uint16_t val, void *priv), void (*outl)(uint16_t addr, uint32_t val, void *priv),
                    void *priv) {
         int c;
         for (c = 0; c < size; c++) {
-                if (!port_inb[base + c][0] && !port_inw[base + c][0] && !port_inl[base + c][0] && !port_outb[base + c][0] &&
-                    !port_outw[base + c][0] && !port_outl[base + c][0]) {
-                        port_inb[base + c][0] = inb;
-                        port_inw[base + c][0] = inw;
-                        port_inl[base + c][0] = inl;
-                        port_outb[base + c][0] = outb;
-                        port_outw[base + c][0] = outw;
-                        port_outl[base + c][0] = outl;
-                        port_priv[base + c][0] = priv;
-                } else if (!port_inb[base + c][1] && !port_inw[base + c][1] && !port_inl[base + c][1] &&
-                           !port_outb[base + c][1] && !port_outw[base + c][1] && !port_outl[base + c][1]) {
-                        port_inb[base + c][1] = inb;
-                        port_inw[base + c][1] = inw;
-                        port_inl[base + c][1] = inl;
-                        port_outb[base + c][1] = outb;
-                        port_outw[base + c][1] = outw;
-                        port_outl[base + c][1] = outl;
-                        port_priv[base + c][1] = priv;
-                }
+                io_port_t *p = io_port_alloc(base + c);
+                io_handler_t *h;
+
+                if (io_handler_empty(&p->h[0]))
+                        h = &p->h[0];
+                else if (io_handler_empty(&p->h[1]))
+                        h = &p->h[1];
+                else
+                        continue;
+
+                h->inb = inb;
+                h->inw = inw;
+                h->inl = inl;
+                h->outb = outb;
+                h->outw = outw;
+                h->outl = outl;
+                h->priv = priv;
         }
 }
 
@@ -68,33 +93,52 @@ void io_removehandler(uint16_t base, int size, uint8_t (*inb)(uint16_t addr, voi
                       uint16_t (*inw)(uint16_t addr, void *priv), uint32_t (*inl)(uint16_t addr, void *priv),
                       void (*outb)(uint16_t addr, uint8_t val, void *priv), void (*outw)(uint16_t addr, uint16_t val, void *priv),
                       void (*outl)(uint16_t addr, uint32_t val, void *priv), void *priv) {
-        int c;
+        int c, d;
         for (c = 0; c < size; c++) {
-                if (port_priv[base + c][0] == priv && port_inb[base + c][0] == inb && port_inw[base + c][0] == inw &&
-                    port_inl[base + c][0] == inl && port_outb[base + c][0] == outb && port_outw[base + c][0] == outw &&
-                    port_outl[base + c][0] == outl) {
-                        port_inb[base + c][0] = NULL;
-                        port_inw[base + c][0] = NULL;
-                        port_inl[base + c][0] = NULL;
-                        port_outb[base + c][0] = NULL;
-                        port_outw[base + c][0] = NULL;
-                        port_outl[base + c][0] = NULL;
-                        port_priv[base + c][0] = NULL;
-                }
-                if (port_priv[base + c][1] == priv && port_inb[base + c][1] == inb && port_inw[base + c][1] == inw &&
-                    port_inl[base + c][1] == inl && port_outb[base + c][1] == outb && port_outw[base + c][1] == outw &&
-                    port_outl[base + c][1] == outl) {
-                        port_inb[base + c][1] = NULL;
-                        port_inw[base + c][1] = NULL;
-                        port_inl[base + c][1] = NULL;
-                        port_outb[base + c][1] = NULL;
-                        port_outw[base + c][1] = NULL;
-                        port_outl[base + c][1] = NULL;
-                        port_priv[base + c][1] = NULL;
+                uint16_t port = base + c;
+                io_port_t *p;
+
+                if (!io_blocks[port >> IO_BLOCK_SHIFT] || io_blocks[port >> IO_BLOCK_SHIFT] == io_empty_block)
+                        continue;
+                p = IO_PORT(port);
+
+                for (d = 0; d < 2; d++) {
+                        io_handler_t *h = &p->h[d];
+
+                        if (h->priv == priv && h->inb == inb && h->inw == inw && h->inl == inl && h->outb == outb &&
+                            h->outw == outw && h->outl == outl)
+                                memset(h, 0, sizeof(io_handler_t));
                 }
         }
 }
 
+void io_set_block_handler(uint16_t port, int (*insw)(uint16_t addr, uint16_t *buf, int count, void *priv),
+                          int (*outsw)(uint16_t addr, const uint16_t *buf, int count, void *priv), void *priv) {
+        io_port_t *p = io_port_alloc(port);
+
+        p->insw = insw;
+        p->outsw = outsw;
+        p->block_priv = priv;
+}
+
+void io_remove_block_handler(uint16_t port, void *priv) {
+        io_port_t *p;
+
+        if (!io_blocks[port >> IO_BLOCK_SHIFT] || io_blocks[port >> IO_BLOCK_SHIFT] == io_empty_block)
+                return;
+        p = IO_PORT(port);
+
+        if (p->block_priv == priv) {
+                p->insw = NULL;
+                p->outsw = NULL;
+                p->block_priv = NULL;
+        }
+}
+
+static void io_profile(uint16_t port, io_port_t *p, int write, uint64_t start) {
+        io_profiler_port(port, io_handler_empty(&p->h[0]) ? p->h[1].priv : p->h[0].priv, write, timer_read() - start);
+}
+
 uint8_t cgamode, cgastat = 0, cgacol;
 int hsync;
 uint8_t lpt2dat;
@@ -102,11 +146,16 @@ int sw9;
 int t237 = 0;
 uint8_t inb(uint16_t port) {
         uint8_t temp = 0xff;
+        io_port_t *p = IO_PORT(port);
+        uint64_t start = io_profiler_enabled ? timer_read() : 0;
 
-        if (port_inb[port][0])
-                temp &= port_inb[port][0](port, port_priv[port][0]);
-        if (port_inb[port][1])
-                temp &= port_inb[port][1](port, port_priv[port][1]);
+        if (p->h[0].inb)
+                temp &= p->h[0].inb(port, p->h[0].priv);
+        if (p->h[1].inb)
+                temp &= p->h[1].inb(port, p->h[1].priv);
+
+        if (io_profiler_enabled)
+                io_profile(port, p, 0, start);
 
         if (port & 0x80)
                 amstrad_latch = AMSTRAD_NOLATCH;
@@ -115,7 +164,7 @@ uint8_t inb(uint16_t port) {
         else
                 amstrad_latch = AMSTRAD_SW9;
 
-        /*           if (!port_inb[port][0] && !port_inb[port][1])
+        /*           if (!p->h[0].inb && !p->h[1].inb)
                         pclog("Bad INB %04X %04X:%04X\n", port, CS, pc);*/
 
         return temp;
@@ -124,64 +173,108 @@ uint8_t inb(uint16_t port) {
 uint8_t cpu_readport(uint32_t port) { return inb(port); }
 
 void outb(uint16_t port, uint8_t val) {
-        if (port_outb[port][0])
-                port_outb[port][0](port, val, port_priv[port][0]);
-        if (port_outb[port][1])
-                port_outb[port][1](port, val, port_priv[port][1]);
+        io_port_t *p = IO_PORT(port);
+        uint64_t start = io_profiler_enabled ? timer_read() : 0;
+
+        if (p->h[0].outb)
+                p->h[0].outb(port, val, p->h[0].priv);
+        if (p->h[1].outb)
+                p->h[1].outb(port, val, p->h[1].priv);
+
+        if (io_profiler_enabled)
+                io_profile(port, p, 1, start);
 
-        /*        if (!port_outb[port][0] && !port_outb[port][1])
+        /*        if (!p->h[0].outb && !p->h[1].outb)
                         pclog("Bad OUTB %04X %02X %04X:%08X\n", port, val, CS, pc);*/
         return;
 }
 
 uint16_t inw(uint16_t port) {
+        io_port_t *p = IO_PORT(port);
         //        pclog("INW %04X\n", port);
-        if (port_inw[port][0])
-                return port_inw[port][0](port, port_priv[port][0]);
-        if (port_inw[port][1])
-                return port_inw[port][1](port, port_priv[port][1]);
+        if (p->h[0].inw || p->h[1].inw) {
+                uint64_t start = io_profiler_enabled ? timer_read() : 0;
+                uint16_t temp = p->h[0].inw ? p->h[0].inw(port, p->h[0].priv) : p->h[1].inw(port, p->h[1].priv);
+
+                if (io_profiler_enabled)
+                        io_profile(port, p, 0, start);
+                return temp;
+        }
 
         return inb(port) | (inb(port + 1) << 8);
 }
 
 void outw(uint16_t port, uint16_t val) {
+        io_port_t *p = IO_PORT(port);
         //        printf("OUTW %04X %04X %04X:%08X\n",port,val, CS, pc);
         /*        if ((port & ~0xf) == 0xf000)
                    pclog("OUTW %04X %04X\n", port, val);*/
 
-        if (port_outw[port][0])
-                port_outw[port][0](port, val, port_priv[port][0]);
-        if (port_outw[port][1])
-                port_outw[port][1](port, val, port_priv[port][1]);
+        if (p->h[0].outw || p->h[1].outw) {
+                uint64_t start = io_profiler_enabled ? timer_read() : 0;
+
+                if (p->h[0].outw)
+                        p->h[0].outw(port, val, p->h[0].priv);
+                if (p->h[1].outw)
+                        p->h[1].outw(port, val, p->h[1].priv);
 
-        if (port_outw[port][0] || port_outw[port][1])
+                if (io_profiler_enabled)
+                        io_profile(port, p, 1, start);
                 return;
+        }
 
         outb(port, val);
         outb(port + 1, val >> 8);
 }
 
+int insw_block(uint16_t port, uint16_t *buf, int count) {
+        io_port_t *p = IO_PORT(port);
+        if (p->insw)
+                return p->insw(port, buf, count, p->block_priv);
+
+        return 0;
+}
+
+int outsw_block(uint16_t port, const uint16_t *buf, int count) {
+        io_port_t *p = IO_PORT(port);
+        if (p->outsw)
+                return p->outsw(port, buf, count, p->block_priv);
+
+        return 0;
+}
+
 uint32_t inl(uint16_t port) {
+        io_port_t *p = IO_PORT(port);
         //        pclog("INL %04X\n", port);
-        if (port_inl[port][0])
-                return port_inl[port][0](port, port_priv[port][0]);
-        if (port_inl[port][1])
-                return port_inl[port][1](port, port_priv[port][1]);
+        if (p->h[0].inl || p->h[1].inl) {
+                uint64_t start = io_profiler_enabled ? timer_read() : 0;
+                uint32_t temp = p->h[0].inl ? p->h[0].inl(port, p->h[0].priv) : p->h[1].inl(port, p->h[1].priv);
+
+                if (io_profiler_enabled)
+                        io_profile(port, p, 0, start);
+                return temp;
+        }
 
         return inw(port) | (inw(port + 2) << 16);
 }
 
 void outl(uint16_t port, uint32_t val) {
+        io_port_t *p = IO_PORT(port);
         /*        if ((port & ~0xf) == 0xf000)
                    pclog("OUTL %04X %08X\n", port, val);*/
 
-        if (port_outl[port][0])
-                port_outl[port][0](port, val, port_priv[port][0]);
-        if (port_outl[port][1])
-                port_outl[port][1](port, val, port_priv[port][1]);
+        if (p->h[0].outl || p->h[1].outl) {
+                uint64_t start = io_profiler_enabled ? timer_read() : 0;
 
-        if (port_outl[port][0] || port_outl[port][1])
+                if (p->h[0].outl)
+                        p->h[0].outl(port, val, p->h[0].priv);
+                if (p->h[1].outl)
+                        p->h[1].outl(port, val, p->h[1].priv);
+
+                if (io_profiler_enabled)
+                        io_profile(port, p, 1, start);
                 return;
+        }
 
         outw(port, val);
         outw(port + 2, val >> 16);
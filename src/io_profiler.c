@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "device.h"
+#include "mem.h"
+#include "io_profiler.h"
+
+int io_profiler_enabled = 0;
+char io_profiler_fn[512] = "pcem_ioprofile.txt";
+
+static volatile int io_profiler_report_requested;
+
+typedef struct io_profiler_stat_t {
+        uint64_t count[2];
+        uint64_t time[2];
+} io_profiler_stat_t;
+
+typedef struct io_profiler_port_t {
+        io_profiler_stat_t stat;
+        void *priv;
+} io_profiler_port_t;
+
+/*Mapping base, size and private pointer are copied on every access, so the
+  report never has to look at a mapping that may since have been freed*/
+typedef struct io_profiler_mapping_t {
+        mem_mapping_t *mapping;
+        uint32_t base, size;
+        void *p;
+        io_profiler_stat_t stat;
+} io_profiler_mapping_t;
+
+typedef struct io_profiler_range_t {
+        uint16_t start, end;
+        void *priv;
+        io_profiler_stat_t stat;
+} io_profiler_range_t;
+
+typedef struct io_profiler_device_t {
+        device_t *device;
+        io_profiler_stat_t stat;
+} io_profiler_device_t;
+
+#define IO_PROFILER_MAPPINGS 1024
+#define IO_PROFILER_MAX_PROBE 32
+
+static io_profiler_port_t *io_profiler_ports;
+static io_profiler_mapping_t *io_profiler_mappings;
+static uint64_t io_profiler_dropped;
+static uint64_t io_profiler_start_time;
+
+static inline void io_profiler_add(io_profiler_stat_t *stat, int write, uint64_t time) {
+        stat->count[write]++;
+        stat->time[write] += time;
+}
+
+static inline void io_profiler_merge(io_profiler_stat_t *dest, io_profiler_stat_t *src) {
+        dest->count[0] += src->count[0];
+        dest->count[1] += src->count[1];
+        dest->time[0] += src->time[0];
+        dest->time[1] += src->time[1];
+}
+
+static inline uint64_t io_profiler_total_time(io_profiler_stat_t *stat) { return stat->time[0] + stat->time[1]; }
+
+void io_profiler_port(uint16_t port, void *priv, int write, uint64_t time) {
+        if (!io_profiler_ports)
+                return;
+
+        io_profiler_add(&io_profiler_ports[port].stat, write, time);
+        io_profiler_ports[port].priv = priv;
+}
+
+void io_profiler_mmio(mem_mapping_t *mapping, int write, uint64_t time) {
+        uint32_t hash;
+        int c;
+
+        if (!io_profiler_mappings)
+                return;
+
+        hash = ((uint32_t)(uintptr_t)mapping * 0x9e3779b1) >> 8;
+        for (c = 0; c < IO_PROFILER_MAX_PROBE; c++) {
+                io_profiler_mapping_t *m = &io_profiler_mappings[(hash + c) & (IO_PROFILER_MAPPINGS - 1)];
+
+                if (!m->mapping || m->mapping == mapping) {
+                        m->mapping = mapping;
+                        m->base = mapping->base;
+                        m->size = mapping->size;
+                        m->p = mapping->p;
+                        io_profiler_add(&m->stat, write, time);
+                        return;
+                }
+        }
+        io_profiler_dropped++;
+}
+
+void io_profiler_reset() {
+        if (!io_profiler_enabled)
+                return;
+
+        if (!io_profiler_ports) {
+                io_profiler_ports = malloc(sizeof(io_profiler_port_t) * 0x10000);
+                io_profiler_mappings = malloc(sizeof(io_profiler_mapping_t) * IO_PROFILER_MAPPINGS);
+        }
+        memset(io_profiler_ports, 0, sizeof(io_profiler_port_t) * 0x10000);
+        memset(io_profiler_mappings, 0, sizeof(io_profiler_mapping_t) * IO_PROFILER_MAPPINGS);
+        io_profiler_dropped = 0;
+        io_profiler_start_time = timer_read();
+}
+
+static int io_profiler_range_compare(const void *a, const void *b) {
+        uint64_t ta = io_profiler_total_time(&((io_profiler_range_t *)a)->stat);
+        uint64_t tb = io_profiler_total_time(&((io_profiler_range_t *)b)->stat);
+
+        return (ta < tb) - (ta > tb);
+}
+
+static int io_profiler_mapping_compare(const void *a, const void *b) {
+        uint64_t ta = io_profiler_total_time(&((io_profiler_mapping_t *)a)->stat);
+        uint64_t tb = io_profiler_total_time(&((io_profiler_mapping_t *)b)->stat);
+
+        return (ta < tb) - (ta > tb);
+}
+
+static int io_profiler_device_compare(const void *a, const void *b) {
+        uint64_t ta = io_profiler_total_time(&((io_profiler_device_t *)a)->stat);
+        uint64_t tb = io_profiler_total_time(&((io_profiler_device_t *)b)->stat);
+
+        return (ta < tb) - (ta > tb);
+}
+
+static const char *io_profiler_device_name(device_t *device) { return device ? device->name : "(system)"; }
+
+static void io_profiler_device_add(io_profiler_device_t *devices, int *nr_devices, void *priv, io_profiler_stat_t *stat) {
+        device_t *device = device_find_for_priv(priv);
+        int c;
+
+        for (c = 0; c < *nr_devices; c++) {
+                if (devices[c].device == device) {
+                        io_profiler_merge(&devices[c].stat, stat);
+                        return;
+                }
+        }
+        devices[*nr_devices].device = device;
+        memset(&devices[*nr_devices].stat, 0, sizeof(io_profiler_stat_t));
+        io_profiler_merge(&devices[*nr_devices].stat, stat);
+        (*nr_devices)++;
+}
+
+static void io_profiler_print_stat(FILE *f, io_profiler_stat_t *stat, uint64_t total_time) {
+        uint64_t count = stat->count[0] + stat->count[1];
+        uint64_t time = io_profiler_total_time(stat);
+
+        fprintf(f, "%10llu reads %10llu writes %10.3f ms %5.1f%% %8.0f ns/access\n", (unsigned long long)stat->count[0],
+                (unsigned long long)stat->count[1], (double)time * 1000.0 / (double)timer_freq,
+                total_time ? (double)time * 100.0 / (double)total_time : 0.0,
+                count ? ((double)time * 1000000000.0 / (double)timer_freq) / (double)count : 0.0);
+}
+
+static void io_profiler_report() {
+        io_profiler_range_t *ranges;
+        io_profiler_mapping_t *mappings;
+        io_profiler_device_t *devices;
+        int nr_ranges = 0, nr_mappings = 0, nr_devices = 0;
+        uint64_t total_time = 0;
+        uint64_t elapsed;
+        FILE *f;
+        int c;
+
+        if (!io_profiler_ports || !timer_freq)
+                return;
+
+        /*Merge adjacent ports with the same handler into ranges*/
+        ranges = malloc(sizeof(io_profiler_range_t) * 0x10000);
+        for (c = 0; c < 0x10000; c++) {
+                io_profiler_port_t *port = &io_profiler_ports[c];
+
+                if (!port->stat.count[0] && !port->stat.count[1])
+                        continue;
+
+                if (nr_ranges && ranges[nr_ranges - 1].end == c - 1 && ranges[nr_ranges - 1].priv == port->priv) {
+                        ranges[nr_ranges - 1].end = c;
+                        io_profiler_merge(&ranges[nr_ranges - 1].stat, &port->stat);
+                } else {
+                        ranges[nr_ranges].start = ranges[nr_ranges].end = c;
+                        ranges[nr_ranges].priv = port->priv;
+                        ranges[nr_ranges].stat = port->stat;
+                        nr_ranges++;
+                }
+                total_time += io_profiler_total_time(&port->stat);
+        }
+
+        mappings = malloc(sizeof(io_profiler_mapping_t) * IO_PROFILER_MAPPINGS);
+        for (c = 0; c < IO_PROFILER_MAPPINGS; c++) {
+                if (io_profiler_mappings[c].mapping) {
+                        mappings[nr_mappings++] = io_profiler_mappings[c];
+                        total_time += io_profiler_total_time(&io_profiler_mappings[c].stat);
+                }
+        }
+
+        devices = malloc(sizeof(io_profiler_device_t) * (DEV_MAX + 1));
+        for (c = 0; c < nr_ranges; c++)
+                io_profiler_device_add(devices, &nr_devices, ranges[c].priv, &ranges[c].stat);
+        for (c = 0; c < nr_mappings; c++)
+                io_profiler_device_add(devices, &nr_devices, mappings[c].p, &mappings[c].stat);
+
+        qsort(ranges, nr_ranges, sizeof(io_profiler_range_t), io_profiler_range_compare);
+        qsort(mappings, nr_mappings, sizeof(io_profiler_mapping_t), io_profiler_mapping_compare);
+        qsort(devices, nr_devices, sizeof(io_profiler_device_t), io_profiler_device_compare);
+
+        elapsed = timer_read() - io_profiler_start_time;
+
+        f = fopen(io_profiler_fn, "wt");
+        if (f) {
+                fprintf(f, "Device access profile : %.3f ms in handlers over %.3f s (%.2f%%)\n",
+                        (double)total_time * 1000.0 / (double)timer_freq, (double)elapsed / (double)timer_freq,
+                        elapsed ? (double)total_time * 100.0 / (double)elapsed : 0.0);
+                if (io_profiler_dropped)
+                        fprintf(f, "%llu mapping accesses not recorded\n", (unsigned long long)io_profiler_dropped);
+
+                fprintf(f, "\nDevices :\n");
+                for (c = 0; c < nr_devices; c++) {
+                        fprintf(f, "  %-40s ", io_profiler_device_name(devices[c].device));
+                        io_profiler_print_stat(f, &devices[c].stat, total_time);
+                }
+
+                fprintf(f, "\nPorts :\n");
+                for (c = 0; c < nr_ranges; c++) {
+                        fprintf(f, "  %04x-%04x %-30s ", ranges[c].start, ranges[c].end,
+                                io_profiler_device_name(device_find_for_priv(ranges[c].priv)));
+                        io_profiler_print_stat(f, &ranges[c].stat, total_time);
+                }
+
+                fprintf(f, "\nMemory mappings :\n");
+                for (c = 0; c < nr_mappings; c++) {
+                        fprintf(f, "  %08x-%08x %-30s ", mappings[c].base, mappings[c].base + mappings[c].size - 1,
+                                io_profiler_device_name(device_find_for_priv(mappings[c].p)));
+                        io_profiler_print_stat(f, &mappings[c].stat, total_time);
+                }
+                fclose(f);
+        } else
+                pclog("io_profiler_report : can't open %s\n", io_profiler_fn);
+
+        pclog("I/O profiler : %.3f ms in device handlers over %.3f s\n", (double)total_time * 1000.0 / (double)timer_freq,
+              (double)elapsed / (double)timer_freq);
+        for (c = 0; c < nr_devices && c < 10; c++)
+                pclog("  %5.1f%%  %s\n",
+                      total_time ? (double)io_profiler_total_time(&devices[c].stat) * 100.0 / (double)total_time : 0.0,
+                      io_profiler_device_name(devices[c].device));
+
+        free(ranges);
+        free(mappings);
+        free(devices);
+}
+
+void io_profiler_request_report() { io_profiler_report_requested = 1; }
+
+void io_profiler_poll() {
+        if (io_profiler_report_requested) {
+                io_profiler_report_requested = 0;
+                io_profiler_report();
+        }
+}
+
+void io_profiler_close() {
+        io_profiler_report();
+
+        free(io_profiler_ports);
+        free(io_profiler_mappings);
+        io_profiler_ports = NULL;
+        io_profiler_mappings = NULL;
+}
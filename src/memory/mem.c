@@ -5,12 +5,21 @@
         - c386sx16 BIOS fails checksum
 */
 
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined WIN32 || defined _WIN32 || defined _WIN32
+#include <windows.h>
+#endif
+
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include "ibm.h"
 
 #include "config.h"
+#include "io_profiler.h"
 #include "mem.h"
 #include "video.h"
 #include "x86.h"
@@ -23,6 +32,18 @@
 page_t *pages;
 page_t **page_lookup;
 
+/*Run a mapping handler access, timing it when the I/O profiler is enabled*/
+#define MEM_MAPPING_ACCESS(map, write, access)                                                                                   \
+        do {                                                                                                                     \
+                if (io_profiler_enabled) {                                                                                       \
+                        uint64_t start = timer_read();                                                                           \
+                        access;                                                                                                  \
+                        io_profiler_mmio(map, write, timer_read() - start);                                                      \
+                } else {                                                                                                         \
+                        access;                                                                                                  \
+                }                                                                                                                \
+        } while (0)
+
 static mem_mapping_t *read_mapping[0x40000];
 static mem_mapping_t *write_mapping[0x40000];
 static uint8_t *_mem_exec[0x40000];
@@ -50,6 +71,12 @@ uint8_t romext[32768];
 uint64_t *byte_dirty_mask;
 uint64_t *byte_code_present_mask;
 
+/*0 = normal pages, 1 = transparent huge pages, 2 = explicit huge pages (falls
+  back to transparent if none are reserved)*/
+int mem_huge_pages = 0;
+
+static uint32_t ram_alloc_size, byte_mask_alloc_size, pages_alloc_size;
+
 uint32_t mem_logical_addr;
 
 void (*smram_enable)(void);
@@ -62,6 +89,9 @@ int readlookup[256], readlookupp[256];
 uintptr_t *readlookup2;
 int readlnext;
 int writelookup[256], writelookupp[256];
+/*Bus address of each writelookup entry. Entries added with addwritelookup_ptr()
+  don't point into ram[], so the address can't be derived from writelookup2*/
+static uint32_t writelookup_phys[256];
 uintptr_t *writelookup2;
 int writelnext;
 
@@ -74,17 +104,25 @@ int mem_addr_is_ram(uint32_t addr) {
                (mapping == &ram_remapped_mapping);
 }
 
+/*Every valid readlookup2/writelookup2/page_lookup entry is also recorded in
+  readlookup[]/writelookup[], so only those entries need clearing here. The
+  full tables are only filled once, in mem_init()*/
 void resetreadlookup() {
         int c;
         //        /*if (output) */pclog("resetreadlookup\n");
-        memset(readlookup2, 0xFF, 1024 * 1024 * sizeof(uintptr_t));
-        for (c = 0; c < 256; c++)
+        for (c = 0; c < 256; c++) {
+                if (readlookup[c] != 0xFFFFFFFF)
+                        readlookup2[readlookup[c]] = -1;
                 readlookup[c] = 0xFFFFFFFF;
+        }
         readlnext = 0;
-        memset(writelookup2, 0xFF, 1024 * 1024 * sizeof(uintptr_t));
-        memset(page_lookup, 0, (1 << 20) * sizeof(page_t *));
-        for (c = 0; c < 256; c++)
+        for (c = 0; c < 256; c++) {
+                if (writelookup[c] != 0xFFFFFFFF) {
+                        page_lookup[writelookup[c]] = NULL;
+                        writelookup2[writelookup[c]] = -1;
+                }
                 writelookup[c] = 0xFFFFFFFF;
+        }
         writelnext = 0;
         pccache = 0xFFFFFFFF;
         //        readlnum=writelnum=0;
@@ -411,12 +449,57 @@ void addwritelookup(uint32_t virt, uint32_t phys) {
         //        pclog("addwritelookup %08x %08x %p %p %016llx %p\n", virt, phys, (void *)page_lookup[virt >> 12], (void
         //        *)writelookup2[virt >> 12], pages[phys >> 12].dirty_mask, (void *)&pages[phys >> 12]);
         writelookupp[writelnext] = mmu_perm;
+        writelookup_phys[writelnext] = phys & ~0xfff;
         writelookup[writelnext++] = virt >> 12;
         writelnext &= (cachesize - 1);
 
         cycles -= 9;
 }
 
+/*Add a write TLB entry for a page that isn't guest RAM, eg a linear framebuffer.
+  host points at the 4kB page of host memory that phys maps to. Writes to the
+  page then go straight to host memory without calling the mapping handlers, so
+  the owner must only do this while that is equivalent, and must cope with not
+  seeing the writes*/
+void addwritelookup_ptr(uint32_t virt, uint32_t phys, uint8_t *host) {
+        if (virt == 0xffffffff)
+                return;
+
+        if (page_lookup[virt >> 12] || writelookup2[virt >> 12] != -1)
+                return;
+
+        if (writelookup[writelnext] != -1) {
+                page_lookup[writelookup[writelnext]] = NULL;
+                writelookup2[writelookup[writelnext]] = -1;
+        }
+
+        writelookup2[virt >> 12] = (uintptr_t)host - (uintptr_t)(virt & ~0xfff);
+        writelookupp[writelnext] = mmu_perm;
+        writelookup_phys[writelnext] = phys & ~0xfff;
+        writelookup[writelnext++] = virt >> 12;
+        writelnext &= (cachesize - 1);
+
+        cycles -= 9;
+}
+
+/*Drop write TLB entries pointing into host memory [base, base + size)*/
+void mem_flush_write_host_range(uint8_t *base, uint32_t size) {
+        int c;
+
+        for (c = 0; c < 256; c++) {
+                if (writelookup[c] != 0xffffffff && writelookup2[writelookup[c]] != -1) {
+                        uintptr_t host = writelookup2[writelookup[c]] + ((uintptr_t)writelookup[c] << 12);
+
+                        if (host - (uintptr_t)base < size) {
+                                writelookup2[writelookup[c]] = -1;
+                                writelookup[c] = 0xffffffff;
+                        }
+                }
+        }
+}
+
+mem_mapping_t *mem_get_write_mapping(uint32_t addr) { return write_mapping[addr >> 14]; }
+
 uint8_t *getpccache(uint32_t a) {
         uint32_t a2 = a;
 
@@ -453,8 +536,12 @@ uint8_t readmembl(uint32_t addr) {
         addr &= rammask;
 
         map = read_mapping[addr >> 14];
-        if (map && map->read_b)
-                return map->read_b(addr, map->p);
+        if (map && map->read_b) {
+                uint8_t temp;
+
+                MEM_MAPPING_ACCESS(map, 0, temp = map->read_b(addr, map->p));
+                return temp;
+        }
         //        pclog("Bad readmembl %08X %04X:%08X\n", addr, CS, pc);
         return 0xFF;
 }
@@ -476,8 +563,10 @@ void writemembl(uint32_t addr, uint8_t val) {
         addr &= rammask;
 
         map = write_mapping[addr >> 14];
-        if (map && map->write_b)
-                return map->write_b(addr, val, map->p);
+        if (map && map->write_b) {
+                MEM_MAPPING_ACCESS(map, 1, map->write_b(addr, val, map->p));
+                return;
+        }
         //        else                          pclog("Bad writemembl %08X %02X  %04X:%08X\n", addr, val, CS, pc);
 }
 
@@ -509,12 +598,14 @@ uint16_t readmemwl(uint32_t addr) {
         addr &= rammask;
 
         map = read_mapping[addr >> 14];
-        if (map) {
-                if (map->read_w)
-                        return map->read_w(addr, map->p);
+        if (map && (map->read_w || map->read_b)) {
+                uint16_t temp;
 
-                if (map->read_b)
-                        return map->read_b(addr, map->p) | (map->read_b(addr + 1, map->p) << 8);
+                if (map->read_w)
+                        MEM_MAPPING_ACCESS(map, 0, temp = map->read_w(addr, map->p));
+                else
+                        MEM_MAPPING_ACCESS(map, 0, temp = map->read_b(addr, map->p) | (map->read_b(addr + 1, map->p) << 8));
+                return temp;
         }
 
         //        pclog("Bad readmemwl %08X\n", addr);
@@ -560,10 +651,9 @@ void writememwl(uint32_t addr, uint16_t val) {
         map = write_mapping[addr >> 14];
         if (map) {
                 if (map->write_w)
-                        map->write_w(addr, val, map->p);
+                        MEM_MAPPING_ACCESS(map, 1, map->write_w(addr, val, map->p));
                 else if (map->write_b) {
-                        map->write_b(addr, val, map->p);
-                        map->write_b(addr + 1, val >> 8, map->p);
+                        MEM_MAPPING_ACCESS(map, 1, map->write_b(addr, val, map->p); map->write_b(addr + 1, val >> 8, map->p));
                 }
         }
 
@@ -599,16 +689,18 @@ uint32_t readmemll(uint32_t addr) {
         addr &= rammask;
 
         map = read_mapping[addr >> 14];
-        if (map) {
-                if (map->read_l)
-                        return map->read_l(addr, map->p);
-
-                if (map->read_w)
-                        return map->read_w(addr, map->p) | (map->read_w(addr + 2, map->p) << 16);
+        if (map && (map->read_l || map->read_w || map->read_b)) {
+                uint32_t temp;
 
-                if (map->read_b)
-                        return map->read_b(addr, map->p) | (map->read_b(addr + 1, map->p) << 8) |
-                               (map->read_b(addr + 2, map->p) << 16) | (map->read_b(addr + 3, map->p) << 24);
+                if (map->read_l)
+                        MEM_MAPPING_ACCESS(map, 0, temp = map->read_l(addr, map->p));
+                else if (map->read_w)
+                        MEM_MAPPING_ACCESS(map, 0, temp = map->read_w(addr, map->p) | (map->read_w(addr + 2, map->p) << 16));
+                else
+                        MEM_MAPPING_ACCESS(map, 0,
+                                           temp = map->read_b(addr, map->p) | (map->read_b(addr + 1, map->p) << 8) |
+                                                  (map->read_b(addr + 2, map->p) << 16) | (map->read_b(addr + 3, map->p) << 24));
+                return temp;
         }
 
         //        pclog("Bad readmemll %08X\n", addr);
@@ -653,15 +745,12 @@ void writememll(uint32_t addr, uint32_t val) {
         map = write_mapping[addr >> 14];
         if (map) {
                 if (map->write_l)
-                        map->write_l(addr, val, map->p);
+                        MEM_MAPPING_ACCESS(map, 1, map->write_l(addr, val, map->p));
                 else if (map->write_w) {
-                        map->write_w(addr, val, map->p);
-                        map->write_w(addr + 2, val >> 16, map->p);
+                        MEM_MAPPING_ACCESS(map, 1, map->write_w(addr, val, map->p); map->write_w(addr + 2, val >> 16, map->p));
                 } else if (map->write_b) {
-                        map->write_b(addr, val, map->p);
-                        map->write_b(addr + 1, val >> 8, map->p);
-                        map->write_b(addr + 2, val >> 16, map->p);
-                        map->write_b(addr + 3, val >> 24, map->p);
+                        MEM_MAPPING_ACCESS(map, 1, map->write_b(addr, val, map->p); map->write_b(addr + 1, val >> 8, map->p);
+                                           map->write_b(addr + 2, val >> 16, map->p); map->write_b(addr + 3, val >> 24, map->p));
                 }
         }
         //        pclog("Bad writememll %08X %08X\n", addr, val);
@@ -695,8 +784,12 @@ uint64_t readmemql(uint32_t addr) {
         addr &= rammask;
 
         map = read_mapping[addr >> 14];
-        if (map && map->read_l)
-                return map->read_l(addr, map->p) | ((uint64_t)map->read_l(addr + 4, map->p) << 32);
+        if (map && map->read_l) {
+                uint64_t temp;
+
+                MEM_MAPPING_ACCESS(map, 0, temp = map->read_l(addr, map->p) | ((uint64_t)map->read_l(addr + 4, map->p) << 32));
+                return temp;
+        }
 
         return readmemll(addr) | ((uint64_t)readmemll(addr + 4) << 32);
 }
@@ -739,22 +832,15 @@ void writememql(uint32_t addr, uint64_t val) {
         map = write_mapping[addr >> 14];
         if (map) {
                 if (map->write_l) {
-                        map->write_l(addr, val, map->p);
-                        map->write_l(addr + 4, val >> 32, map->p);
+                        MEM_MAPPING_ACCESS(map, 1, map->write_l(addr, val, map->p); map->write_l(addr + 4, val >> 32, map->p));
                 } else if (map->write_w) {
-                        map->write_w(addr, val, map->p);
-                        map->write_w(addr + 2, val >> 16, map->p);
-                        map->write_w(addr + 4, val >> 32, map->p);
-                        map->write_w(addr + 6, val >> 48, map->p);
+                        MEM_MAPPING_ACCESS(map, 1, map->write_w(addr, val, map->p); map->write_w(addr + 2, val >> 16, map->p);
+                                           map->write_w(addr + 4, val >> 32, map->p); map->write_w(addr + 6, val >> 48, map->p));
                 } else if (map->write_b) {
-                        map->write_b(addr, val, map->p);
-                        map->write_b(addr + 1, val >> 8, map->p);
-                        map->write_b(addr + 2, val >> 16, map->p);
-                        map->write_b(addr + 3, val >> 24, map->p);
-                        map->write_b(addr + 4, val >> 32, map->p);
-                        map->write_b(addr + 5, val >> 40, map->p);
-                        map->write_b(addr + 6, val >> 48, map->p);
-                        map->write_b(addr + 7, val >> 56, map->p);
+                        MEM_MAPPING_ACCESS(map, 1, map->write_b(addr, val, map->p); map->write_b(addr + 1, val >> 8, map->p);
+                                           map->write_b(addr + 2, val >> 16, map->p); map->write_b(addr + 3, val >> 24, map->p);
+                                           map->write_b(addr + 4, val >> 32, map->p); map->write_b(addr + 5, val >> 40, map->p);
+                                           map->write_b(addr + 6, val >> 48, map->p); map->write_b(addr + 7, val >> 56, map->p));
                 }
         }
         //        pclog("Bad writememql %08X %08X\n", addr, val);
@@ -765,8 +851,12 @@ uint8_t mem_readb_phys(uint32_t addr) {
 
         mem_logical_addr = 0xffffffff;
 
-        if (map && map->read_b)
-                return map->read_b(addr, map->p);
+        if (map && map->read_b) {
+                uint8_t temp;
+
+                MEM_MAPPING_ACCESS(map, 0, temp = map->read_b(addr, map->p));
+                return temp;
+        }
 
         return 0xff;
 }
@@ -775,8 +865,12 @@ uint16_t mem_readw_phys(uint32_t addr) {
 
         mem_logical_addr = 0xffffffff;
 
-        if (map && map->read_w)
-                return map->read_w(addr, map->p);
+        if (map && map->read_w) {
+                uint16_t temp;
+
+                MEM_MAPPING_ACCESS(map, 0, temp = map->read_w(addr, map->p));
+                return temp;
+        }
 
         return mem_readb_phys(addr) | (mem_readb_phys(addr + 1) << 8);
 }
@@ -785,8 +879,12 @@ uint32_t mem_readl_phys(uint32_t addr) {
 
         mem_logical_addr = 0xffffffff;
 
-        if (map && map->read_l)
-                return map->read_l(addr, map->p);
+        if (map && map->read_l) {
+                uint32_t temp;
+
+                MEM_MAPPING_ACCESS(map, 0, temp = map->read_l(addr, map->p));
+                return temp;
+        }
 
         return mem_readw_phys(addr) | (mem_readw_phys(addr + 2) << 16);
 }
@@ -797,7 +895,7 @@ void mem_writeb_phys(uint32_t addr, uint8_t val) {
         mem_logical_addr = 0xffffffff;
 
         if (map && map->write_b)
-                map->write_b(addr, val, map->p);
+                MEM_MAPPING_ACCESS(map, 1, map->write_b(addr, val, map->p));
 }
 void mem_writew_phys(uint32_t addr, uint16_t val) {
         mem_mapping_t *map = write_mapping[addr >> 14];
@@ -805,7 +903,7 @@ void mem_writew_phys(uint32_t addr, uint16_t val) {
         mem_logical_addr = 0xffffffff;
 
         if (map && map->write_w && !(addr & 1))
-                map->write_w(addr, val, map->p);
+                MEM_MAPPING_ACCESS(map, 1, map->write_w(addr, val, map->p));
         else {
                 mem_writeb_phys(addr, val);
                 mem_writeb_phys(addr + 1, val >> 8);
@@ -817,7 +915,7 @@ void mem_writel_phys(uint32_t addr, uint32_t val) {
         mem_logical_addr = 0xffffffff;
 
         if (map && map->write_l && !(addr & 3))
-                map->write_l(addr, val, map->p);
+                MEM_MAPPING_ACCESS(map, 1, map->write_l(addr, val, map->p));
         else {
                 mem_writew_phys(addr, val);
                 mem_writew_phys(addr + 2, val >> 16);
@@ -1078,12 +1176,67 @@ static inline int mem_mapping_write_allowed(uint32_t flags, int state) {
         return 0;
 }
 
+/*Drop TLB entries that point at RAM offsets [base, base + size). Entries
+  elsewhere are unaffected by a memory map change in this range, so don't
+  need a full flush*/
+static void mem_flush_phys_range(uint64_t base, uint64_t size) {
+        int c;
+
+        /*Remapped RAM is reached through a different RAM offset than its bus
+          address, so a change there can't be tracked by offset. This includes
+          the mapping itself being disabled, which clears enable before the
+          recalc gets here*/
+        if (ram_remapped_mapping.size && (uint64_t)ram_remapped_mapping.base < base + size &&
+            (uint64_t)ram_remapped_mapping.base + ram_remapped_mapping.size > base) {
+                flushmmucache_cr3();
+                pccache = 0xFFFFFFFF;
+                return;
+        }
+
+        for (c = 0; c < 256; c++) {
+                if (readlookup[c] != 0xFFFFFFFF) {
+                        uint32_t phys = (readlookup2[readlookup[c]] + ((uintptr_t)readlookup[c] << 12)) - (uintptr_t)ram;
+
+                        if ((uint64_t)phys - base < size) {
+                                readlookup2[readlookup[c]] = -1;
+                                readlookup[c] = 0xFFFFFFFF;
+                        }
+                }
+                if (writelookup[c] != 0xFFFFFFFF) {
+                        if ((uint64_t)writelookup_phys[c] - base < size) {
+                                page_lookup[writelookup[c]] = NULL;
+                                writelookup2[writelookup[c]] = -1;
+                                writelookup[c] = 0xFFFFFFFF;
+                        }
+                }
+        }
+        pccache = 0xFFFFFFFF;
+}
+
+/*Ranges up to this many 16k slots are compared before and after the recalc,
+  so that a change that leaves the map as it was (eg re-setting the same
+  shadow state) doesn't touch the TLB at all*/
+#define RECALC_COMPARE_SLOTS 64
+
 static void mem_mapping_recalc(uint64_t base, uint64_t size) {
         uint64_t c;
         mem_mapping_t *mapping = base_mapping.next;
+        mem_mapping_t *old_read[RECALC_COMPARE_SLOTS], *old_write[RECALC_COMPARE_SLOTS];
+        uint8_t *old_exec[RECALC_COMPARE_SLOTS];
+        int compare;
 
         if (!size)
                 return;
+
+        compare = (((base + size - 1) >> 14) - (base >> 14)) < RECALC_COMPARE_SLOTS;
+        if (compare) {
+                for (c = base >> 14; c <= (base + size - 1) >> 14; c++) {
+                        old_read[c - (base >> 14)] = read_mapping[c];
+                        old_write[c - (base >> 14)] = write_mapping[c];
+                        old_exec[c - (base >> 14)] = _mem_exec[c];
+                }
+        }
+
         /*Clear out old mappings*/
         for (c = base; c < base + size; c += 0x4000) {
                 read_mapping[c >> 14] = NULL;
@@ -1120,7 +1273,24 @@ static void mem_mapping_recalc(uint64_t base, uint64_t size) {
                 }
                 mapping = mapping->next;
         }
-        flushmmucache_cr3();
+
+        if (compare) {
+                uint64_t first = 0, last = 0;
+                int changed = 0;
+
+                for (c = base >> 14; c <= (base + size - 1) >> 14; c++) {
+                        if (read_mapping[c] != old_read[c - (base >> 14)] || write_mapping[c] != old_write[c - (base >> 14)] ||
+                            _mem_exec[c] != old_exec[c - (base >> 14)]) {
+                                if (!changed)
+                                        first = c;
+                                last = c;
+                                changed = 1;
+                        }
+                }
+                if (changed)
+                        mem_flush_phys_range(first << 14, (last + 1 - first) << 14);
+        } else
+                mem_flush_phys_range(base & ~0x3fff, ((base + size + 0x3fff) & ~0x3fff) - (base & ~0x3fff));
 }
 
 void mem_mapping_add(mem_mapping_t *mapping, uint32_t base, uint32_t size, uint8_t (*read_b)(uint32_t addr, void *p),
@@ -1187,6 +1357,10 @@ void mem_mapping_set_handler(mem_mapping_t *mapping, uint8_t (*read_b)(uint32_t
         mapping->write_l = write_l;
 
         mem_mapping_recalc(mapping->base, mapping->size);
+        /*The slot table doesn't change when only the handlers do, but TLB entries
+          filled through the old handlers must still go*/
+        if (mapping->enable && mapping->size)
+                mem_flush_phys_range(mapping->base & ~0xfff, ((mapping->base + mapping->size + 0xfff) & ~0xfff) - (mapping->base & ~0xfff));
 }
 
 void mem_mapping_set_addr(mem_mapping_t *mapping, uint32_t base, uint32_t size) {
@@ -1326,10 +1500,21 @@ void mem_set_704kb() {
         mem_mapping_set_addr(&ram_low_mapping, 0x00000, (mem_size > 704) ? 0xb0000 : mem_size * 1024);
 }
 
+static void *mem_host_alloc(uint32_t size, int huge);
+
 void mem_init() {
+        int c;
+
         readlookup2 = malloc(1024 * 1024 * sizeof(uintptr_t));
         writelookup2 = malloc(1024 * 1024 * sizeof(uintptr_t));
-        page_lookup = malloc((1 << 20) * sizeof(page_t *));
+        memset(readlookup2, 0xFF, 1024 * 1024 * sizeof(uintptr_t));
+        memset(writelookup2, 0xFF, 1024 * 1024 * sizeof(uintptr_t));
+        /*Only the pages of page_lookup that are actually used get committed*/
+        page_lookup = mem_host_alloc((1 << 20) * sizeof(page_t *), 0);
+        for (c = 0; c < 256; c++) {
+                readlookup[c] = 0xFFFFFFFF;
+                writelookup[c] = 0xFFFFFFFF;
+        }
 
         memset(ff_array, 0xff, sizeof(ff_array));
 
@@ -1337,23 +1522,82 @@ void mem_init() {
         smram_disable = NULL;
 }
 
+/*Allocate zeroed memory straight from the host. Pages are only committed
+  when first touched, so guest RAM the guest never uses costs nothing*/
+static void *mem_host_alloc(uint32_t size, int huge) {
+        void *p;
+
+#if defined WIN32 || defined _WIN32 || defined _WIN32
+        p = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (!p)
+                fatal("mem_host_alloc : failed to allocate %u bytes\n", size);
+#elif defined(__linux__) || defined(__APPLE__)
+        p = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+        if (huge == 2 && !(size & 0x1fffff))
+                p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+#endif
+        if (p == MAP_FAILED)
+                p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+        if (p == MAP_FAILED)
+                fatal("mem_host_alloc : failed to allocate %u bytes\n", size);
+#if defined(MADV_HUGEPAGE)
+        if (huge)
+                madvise(p, size, MADV_HUGEPAGE);
+#endif
+#else
+        p = calloc(size, 1);
+        if (!p)
+                fatal("mem_host_alloc : failed to allocate %u bytes\n", size);
+#endif
+        return p;
+}
+
+static void mem_host_free(void *p, uint32_t size) {
+        if (!p)
+                return;
+#if defined WIN32 || defined _WIN32 || defined _WIN32
+        VirtualFree(p, 0, MEM_RELEASE);
+#elif defined(__linux__) || defined(__APPLE__)
+        munmap(p, size);
+#else
+        free(p);
+#endif
+}
+
+static uint32_t mem_host_rss_kb() {
+#if defined(__linux__)
+        FILE *f = fopen("/proc/self/statm", "r");
+        unsigned long size, resident;
+
+        if (!f)
+                return 0;
+        if (fscanf(f, "%lu %lu", &size, &resident) != 2)
+                resident = 0;
+        fclose(f);
+        return (resident * sysconf(_SC_PAGESIZE)) / 1024;
+#else
+        return 0;
+#endif
+}
+
 void mem_alloc() {
         int c;
+        uint64_t start_time = timer_read();
 
-        free(ram);
-        ram = malloc(mem_size * 1024);
-        memset(ram, 0, mem_size * 1024);
+        mem_host_free(ram, ram_alloc_size);
+        ram_alloc_size = mem_size * 1024;
+        ram = mem_host_alloc(ram_alloc_size, mem_huge_pages);
 
-        free(byte_dirty_mask);
-        byte_dirty_mask = malloc((mem_size * 1024) / 8);
-        memset(byte_dirty_mask, 0, (mem_size * 1024) / 8);
-        free(byte_code_present_mask);
-        byte_code_present_mask = malloc((mem_size * 1024) / 8);
-        memset(byte_code_present_mask, 0, (mem_size * 1024) / 8);
+        mem_host_free(byte_dirty_mask, byte_mask_alloc_size);
+        mem_host_free(byte_code_present_mask, byte_mask_alloc_size);
+        byte_mask_alloc_size = (mem_size * 1024) / 8;
+        byte_dirty_mask = mem_host_alloc(byte_mask_alloc_size, 0);
+        byte_code_present_mask = mem_host_alloc(byte_mask_alloc_size, 0);
 
-        free(pages);
-        pages = malloc((((mem_size + 384) * 1024) >> 12) * sizeof(page_t));
-        memset(pages, 0, (((mem_size + 384) * 1024) >> 12) * sizeof(page_t));
+        mem_host_free(pages, pages_alloc_size);
+        pages_alloc_size = (((mem_size + 384) * 1024) >> 12) * sizeof(page_t);
+        pages = mem_host_alloc(pages_alloc_size, 0);
         for (c = 0; c < (((mem_size + 384) * 1024) >> 12); c++) {
                 pages[c].mem = &ram[c << 12];
                 pages[c].write_b = mem_write_ramb_page;
@@ -1364,7 +1608,8 @@ void mem_alloc() {
                 pages[c].byte_code_present_mask = &byte_code_present_mask[c * 64];
         }
 
-        memset(page_lookup, 0, (1 << 20) * sizeof(page_t *));
+        /*pages[] has moved, drop any page_lookup entries that point into it*/
+        resetreadlookup();
 
         memset(read_mapping, 0, sizeof(read_mapping));
         memset(write_mapping, 0, sizeof(write_mapping));
@@ -1431,6 +1676,10 @@ void mem_alloc() {
 
         purgable_page_list_head = 0;
         purgeable_page_count = 0;
+
+        /*timer_freq isn't set up yet on the first reset*/
+        pclog("mem_alloc : %iKB guest RAM in %ius, host RSS %uKB\n", mem_size,
+              timer_freq ? (int)(((timer_read() - start_time) * 1000000) / timer_freq) : 0, mem_host_rss_kb());
 }
 
 void mem_reset_page_blocks() {
@@ -67,6 +67,32 @@ pcap_t *net_pcap;
 #endif
 
 queueADT slirpq;
+
+// Received SLIRP frames are queued in buffers taken from a fixed pool rather
+// than malloc'd per frame. If the pool runs dry the frame is dropped, as it
+// would be on a real network when the NIC can't keep up. PCAP frames are
+// passed straight from the capture buffer and don't need one.
+#define NE2000_PACKET_POOL 64
+
+static struct queuepacket packet_pool[NE2000_PACKET_POOL];
+static struct queuepacket *packet_free[NE2000_PACKET_POOL];
+static int packet_free_num;
+
+static void packet_pool_init() {
+        int c;
+
+        for (c = 0; c < NE2000_PACKET_POOL; c++)
+                packet_free[c] = &packet_pool[c];
+        packet_free_num = NE2000_PACKET_POOL;
+}
+
+static struct queuepacket *packet_alloc() {
+        if (!packet_free_num)
+                return NULL;
+        return packet_free[--packet_free_num];
+}
+
+static void packet_free_buf(struct queuepacket *qp) { packet_free[packet_free_num++] = qp; }
 int net_slirp_inited = 0;
 int net_is_slirp = 1; // by default we go with slirp
 int net_is_pcap = 0;  // and pretend pcap is dead.
@@ -473,6 +499,69 @@ void ne2000_asic_write_w(uint16_t offset, uint16_t value, void *p) {
         }
 }
 
+//
+// Block versions of asic_read_w/asic_write_w for REP INSW/OUTSW. Runs of
+// words that stay inside buffer memory, don't reach the ring wrap and don't
+// finish the remote-DMA transfer are copied in one go; anything else goes
+// through the per-word path so the side effects are unchanged.
+//
+static int ne2000_remote_dma_run(ne2000_t *ne2000, int count) {
+        uint32_t addr = ne2000->remote_dma;
+        uint32_t stop = ne2000->page_stop << 8;
+        int run;
+
+        if (!(ne2000->DCR.wdsize & 0x01) || (addr & 1) || addr < BX_NE2K_MEMSTART || addr >= BX_NE2K_MEMEND)
+                return 0;
+
+        run = (BX_NE2K_MEMEND - addr) >> 1;
+        if (addr < stop && run > (stop - addr - 1) >> 1)
+                run = (stop - addr - 1) >> 1;
+        if (run > (ne2000->remote_bytes - 1) >> 1)
+                run = (ne2000->remote_bytes - 1) >> 1;
+        if (run > count)
+                run = count;
+
+        return (run > 0) ? run : 0;
+}
+
+static int ne2000_asic_insw(uint16_t offset, uint16_t *buf, int count, void *p) {
+        ne2000_t *ne2000 = (ne2000_t *)p;
+        int c = 0;
+
+        while (c < count) {
+                int run = ne2000_remote_dma_run(ne2000, count - c);
+
+                if (run) {
+                        memcpy(&buf[c], &ne2000->mem[ne2000->remote_dma - BX_NE2K_MEMSTART], run * 2);
+                        ne2000->remote_dma += run * 2;
+                        ne2000->remote_bytes -= run * 2;
+                        c += run;
+                } else
+                        buf[c++] = cpu_to_le16(ne2000_asic_read_w(offset, ne2000));
+        }
+
+        return count;
+}
+
+static int ne2000_asic_outsw(uint16_t offset, const uint16_t *buf, int count, void *p) {
+        ne2000_t *ne2000 = (ne2000_t *)p;
+        int c = 0;
+
+        while (c < count) {
+                int run = ne2000_remote_dma_run(ne2000, count - c);
+
+                if (run) {
+                        memcpy(&ne2000->mem[ne2000->remote_dma - BX_NE2K_MEMSTART], &buf[c], run * 2);
+                        ne2000->remote_dma += run * 2;
+                        ne2000->remote_bytes -= run * 2;
+                        c += run;
+                } else
+                        ne2000_asic_write_w(offset, le16_to_cpu(buf[c++]), ne2000);
+        }
+
+        return count;
+}
+
 uint8_t ne2000_asic_read_b(uint16_t offset, void *p) {
         if (offset & 1)
                 return ne2000_asic_read_w(offset & ~1, p) >> 1;
@@ -1340,6 +1429,7 @@ static void ne2000_pci_add(ne2000_t *ne2000) {
         io_sethandler(ne2000->base_addr + 0x10, 0x000f, ne2000_asic_read_b, ne2000_asic_read_w, NULL, ne2000_asic_write_b,
                       ne2000_asic_write_w, NULL, ne2000);
         io_sethandler(ne2000->base_addr + 0x1f, 0x0001, ne2000_reset_read, NULL, NULL, ne2000_reset_write, NULL, NULL, ne2000);
+        io_set_block_handler(ne2000->base_addr + 0x10, ne2000_asic_insw, ne2000_asic_outsw, ne2000);
 }
 
 static void ne2000_pci_remove(ne2000_t *ne2000) {
@@ -1347,6 +1437,7 @@ static void ne2000_pci_remove(ne2000_t *ne2000) {
         io_removehandler(ne2000->base_addr + 0x10, 0x000f, ne2000_asic_read_b, ne2000_asic_read_w, NULL, ne2000_asic_write_b,
                          ne2000_asic_write_w, NULL, ne2000);
         io_removehandler(ne2000->base_addr + 0x1f, 0x0001, ne2000_reset_read, NULL, NULL, ne2000_reset_write, NULL, NULL, ne2000);
+        io_remove_block_handler(ne2000->base_addr + 0x10, ne2000);
 }
 
 static uint8_t rtl8029_pci_read(int func, int addr, void *p) {
@@ -1465,14 +1556,14 @@ static void ne2000_poller(void *p) {
                 while (QueuePeek(slirpq) > 0) {
                         qp = QueueDelete(slirpq);
                         if ((ne2000->DCR.loop == 0) || (ne2000->TCR.loop_cntl != 0)) {
-                                free(qp);
+                                packet_free_buf(qp);
                                 return;
                         }
                         ne2000_rx_frame(ne2000, &qp->data, qp->len);
 #ifdef NE2000_DEBUG
                         pclog("ne2000 inQ:%d  got a %dbyte packet @%d\n", QueuePeek(slirpq), qp->len, qp);
 #endif
-                        free(qp);
+                        packet_free_buf(qp);
                 }
                 fizz++;
                 if (fizz > 1200) {
@@ -1585,6 +1676,7 @@ void *ne2000_common_init() {
 
                         net_slirp_inited = 1;
                         slirpq = QueueCreate();
+                        packet_pool_init();
                         net_is_slirp = 1;
                         fizz = 0;
                         pclog("ne2000 slirpq is %x\n", &slirpq);
@@ -1698,6 +1790,7 @@ void *ne2000_init() {
         io_sethandler(addr + 0x10, 0x0010, ne2000_asic_read_b, ne2000_asic_read_w, NULL, ne2000_asic_write_b, ne2000_asic_write_w,
                       NULL, ne2000);
         io_sethandler(addr + 0x1f, 0x0001, ne2000_reset_read, NULL, NULL, ne2000_reset_write, NULL, NULL, ne2000);
+        io_set_block_handler(addr + 0x10, ne2000_asic_insw, ne2000_asic_outsw, ne2000);
 
         return ne2000;
 }
@@ -1767,7 +1860,12 @@ int slirp_can_output(void) { return net_slirp_inited; }
 
 void slirp_output(const unsigned char *pkt, int pkt_len) {
         struct queuepacket *p;
-        p = (struct queuepacket *)malloc(sizeof(struct queuepacket));
+
+        if (pkt_len > (int)sizeof(p->data) || QueueIsFull(slirpq))
+                return;
+        p = packet_alloc();
+        if (!p)
+                return;
         p->len = pkt_len;
         memcpy(p->data, pkt, pkt_len);
         QueueEnter(slirpq, p);
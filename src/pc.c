@@ -31,6 +31,7 @@
 #include "sound_gus.h"
 #include "ide.h"
 #include "io.h"
+#include "io_profiler.h"
 #include "keyboard.h"
 #include "keyboard_at.h"
 #include "lpt.h"
@@ -43,19 +44,27 @@
 #include "plat-keyboard.h"
 #include "plat-midi.h"
 #include "plat-mouse.h"
+#include "profiler.h"
 #include "scsi_cd.h"
 #include "scsi_zip.h"
 #include "serial.h"
 #include "sound.h"
+#include "sound_async.h"
 #include "sound_cms.h"
 #include "sound_dbopl.h"
 #include "sound_opl.h"
+#include "sound_out.h"
 #include "sound_sb.h"
 #include "sound_speaker.h"
 #include "sound_ssi2001.h"
+#include "telemetry.h"
 #include "timer.h"
 #include "vid_voodoo.h"
+#include "vid_voodoo_trace.h"
 #include "video.h"
+#include "video_capture.h"
+#include "vid_svga.h"
+#include "vid_svga_compose.h"
 #include "amstrad.h"
 #include "hdd.h"
 #include "x86.h"
@@ -243,6 +252,7 @@ void initpc(int argc, char *argv[]) {
 
         loadconfig(NULL);
         pclog("Config loaded\n");
+        telemetry_init();
 
         load_plugins();
 
@@ -356,6 +366,8 @@ void resetpchard() {
         viewer_reset();
 
         timer_reset();
+        profiler_init();
+        io_profiler_reset();
         sound_reset();
         io_init();
         cpu_set();
@@ -532,6 +544,8 @@ void runpc() {
                 emu_fps = frames;
                 frames = 0;
         }
+        telemetry_poll();
+        io_profiler_poll();
         if (win_title_update) {
                 win_title_update = 0;
                 sprintf(s, "PCem " PCEM_VERSION_STRING " - %i%% - %s - %s - %s", fps, model_getname(),
@@ -572,6 +586,10 @@ void speedchanged() {
 }
 
 void closepc() {
+        profiler_close();
+        io_profiler_close();
+        telemetry_close();
+        capture_close();
         codegen_close();
         atapi->exit();
         //        ioctl_close();
@@ -621,6 +639,8 @@ void loadconfig(char *fn) {
         video_force_aspect_ration = config_get_int(CFG_GLOBAL, NULL, "vid_force_aspect_ratio", 0);
         vid_disc_indicator = config_get_int(CFG_GLOBAL, NULL, "vid_disc_indicator", 1);
         vid_api = config_get_int(CFG_GLOBAL, NULL, "vid_api", 0);
+        svga_lfb_direct = config_get_int(CFG_GLOBAL, NULL, "vid_lfb_direct", 0);
+        svga_compose_threads = config_get_int(CFG_GLOBAL, NULL, "vid_compose_threads", 0);
         video_fullscreen_scale = config_get_int(CFG_GLOBAL, NULL, "video_fullscreen_scale", 0);
         video_fullscreen_first = config_get_int(CFG_GLOBAL, NULL, "video_fullscreen_first", 1);
 
@@ -632,11 +652,47 @@ void loadconfig(char *fn) {
 
         sound_buf_len = config_get_int(CFG_GLOBAL, NULL, "sound_buf_len", 200);
         sound_gain = config_get_int(CFG_GLOBAL, NULL, "sound_gain", 0);
+        sound_async = config_get_int(CFG_GLOBAL, NULL, "sound_async", 0);
+        disc_fast = config_get_int(CFG_GLOBAL, NULL, "fast_floppy", 0);
+        profiler_enabled = config_get_int(CFG_GLOBAL, NULL, "profiler", 0);
+        profiler_interval = config_get_int(CFG_GLOBAL, NULL, "profiler_interval", 1000);
+        p = (char *)config_get_string(CFG_GLOBAL, NULL, "profiler_file", "pcem_profile.txt");
+        if (p)
+                safe_strncpy(profiler_fn, p, sizeof(profiler_fn));
+        io_profiler_enabled = config_get_int(CFG_GLOBAL, NULL, "io_profiler", 0);
+        p = (char *)config_get_string(CFG_GLOBAL, NULL, "io_profiler_file", "pcem_ioprofile.txt");
+        if (p)
+                safe_strncpy(io_profiler_fn, p, sizeof(io_profiler_fn));
+        telemetry_enabled = config_get_int(CFG_GLOBAL, NULL, "telemetry", 0);
+        telemetry_interval = config_get_int(CFG_GLOBAL, NULL, "telemetry_interval", 1000);
+        telemetry_format = config_get_int(CFG_GLOBAL, NULL, "telemetry_format", TELEMETRY_FORMAT_JSON);
+        p = (char *)config_get_string(CFG_GLOBAL, NULL, "telemetry_file", "pcem_telemetry.jsonl");
+        if (p)
+                safe_strncpy(telemetry_fn, p, sizeof(telemetry_fn));
+        voodoo_trace_enabled = config_get_int(CFG_GLOBAL, NULL, "voodoo_trace", 0);
+        voodoo_trace_checksum_interval = config_get_int(CFG_GLOBAL, NULL, "voodoo_trace_checksum_interval", 60);
+        p = (char *)config_get_string(CFG_GLOBAL, NULL, "voodoo_trace_file", "pcem_voodoo.trc");
+        if (p)
+                safe_strncpy(voodoo_trace_fn, p, sizeof(voodoo_trace_fn));
+        mem_huge_pages = config_get_int(CFG_GLOBAL, NULL, "mem_huge_pages", 0);
+        sound_sink = config_get_int(CFG_GLOBAL, NULL, "sound_sink", SOUND_SINK_OPENAL);
+        p = (char *)config_get_string(CFG_GLOBAL, NULL, "sound_sink_file", "pcem.wav");
+        if (p)
+                safe_strncpy(sound_sink_fn, p, sizeof(sound_sink_fn));
+        capture_enabled = config_get_int(CFG_GLOBAL, NULL, "capture", 0);
+        capture_format = config_get_int(CFG_GLOBAL, NULL, "capture_format", CAPTURE_FORMAT_RAW);
+        p = (char *)config_get_string(CFG_GLOBAL, NULL, "capture_file", "pcem_capture");
+        if (p)
+                safe_strncpy(capture_fn, p, sizeof(capture_fn));
+        capture_changed_only = config_get_int(CFG_GLOBAL, NULL, "capture_changed_only", 0);
+        capture_buffers = config_get_int(CFG_GLOBAL, NULL, "capture_buffers", 8);
+        capture_fps = config_get_int(CFG_GLOBAL, NULL, "capture_fps", 60);
 
         GAMEBLASTER = config_get_int(CFG_MACHINE, NULL, "gameblaster", 0);
         GUS = config_get_int(CFG_MACHINE, NULL, "gus", 0);
         SSI2001 = config_get_int(CFG_MACHINE, NULL, "ssi2001", 0);
         voodoo_enabled = config_get_int(CFG_MACHINE, NULL, "voodoo", 0);
+        video_frameskip_max = config_get_int(CFG_MACHINE, NULL, "frameskip_max", 0);
 
         p = (char *)config_get_string(CFG_MACHINE, NULL, "model", "");
         if (p)
@@ -653,6 +709,7 @@ void loadconfig(char *fn) {
         p = (char *)config_get_string(CFG_MACHINE, NULL, "fpu", "none");
         fpu_type = fpu_get_type(model, cpu_manufacturer, cpu, p);
         cpu_use_dynarec = config_get_int(CFG_MACHINE, NULL, "cpu_use_dynarec", 0);
+        cpu_808x_fast = config_get_int(CFG_MACHINE, NULL, "cpu_808x_fast", 0);
         cpu_waitstates = config_get_int(CFG_MACHINE, NULL, "cpu_waitstates", 0);
 
         p = (char *)config_get_string(CFG_MACHINE, NULL, "gfxcard", "");
@@ -844,6 +901,8 @@ void saveconfig(char *fn) {
         config_set_int(CFG_GLOBAL, NULL, "vid_force_aspect_ratio", video_force_aspect_ration);
         config_set_int(CFG_GLOBAL, NULL, "vid_disc_indicator", vid_disc_indicator);
         config_set_int(CFG_GLOBAL, NULL, "vid_api", vid_api);
+        config_set_int(CFG_GLOBAL, NULL, "vid_lfb_direct", svga_lfb_direct);
+        config_set_int(CFG_GLOBAL, NULL, "vid_compose_threads", svga_compose_threads);
         config_set_int(CFG_GLOBAL, NULL, "video_fullscreen_scale", video_fullscreen_scale);
         config_set_int(CFG_GLOBAL, NULL, "video_fullscreen_first", video_fullscreen_first);
 
@@ -855,17 +914,42 @@ void saveconfig(char *fn) {
 
         config_set_int(CFG_GLOBAL, NULL, "sound_buf_len", sound_buf_len);
         config_set_int(CFG_GLOBAL, NULL, "sound_gain", sound_gain);
+        config_set_int(CFG_GLOBAL, NULL, "sound_async", sound_async);
+        config_set_int(CFG_GLOBAL, NULL, "fast_floppy", disc_fast);
+        config_set_int(CFG_GLOBAL, NULL, "profiler", profiler_enabled);
+        config_set_int(CFG_GLOBAL, NULL, "profiler_interval", profiler_interval);
+        config_set_string(CFG_GLOBAL, NULL, "profiler_file", profiler_fn);
+        config_set_int(CFG_GLOBAL, NULL, "io_profiler", io_profiler_enabled);
+        config_set_string(CFG_GLOBAL, NULL, "io_profiler_file", io_profiler_fn);
+        config_set_int(CFG_GLOBAL, NULL, "telemetry", telemetry_enabled);
+        config_set_int(CFG_GLOBAL, NULL, "telemetry_interval", telemetry_interval);
+        config_set_int(CFG_GLOBAL, NULL, "telemetry_format", telemetry_format);
+        config_set_string(CFG_GLOBAL, NULL, "telemetry_file", telemetry_fn);
+        config_set_int(CFG_GLOBAL, NULL, "voodoo_trace", voodoo_trace_enabled);
+        config_set_int(CFG_GLOBAL, NULL, "voodoo_trace_checksum_interval", voodoo_trace_checksum_interval);
+        config_set_string(CFG_GLOBAL, NULL, "voodoo_trace_file", voodoo_trace_fn);
+        config_set_int(CFG_GLOBAL, NULL, "mem_huge_pages", mem_huge_pages);
+        config_set_int(CFG_GLOBAL, NULL, "sound_sink", sound_sink);
+        config_set_string(CFG_GLOBAL, NULL, "sound_sink_file", sound_sink_fn);
+        config_set_int(CFG_GLOBAL, NULL, "capture", capture_enabled);
+        config_set_int(CFG_GLOBAL, NULL, "capture_format", capture_format);
+        config_set_string(CFG_GLOBAL, NULL, "capture_file", capture_fn);
+        config_set_int(CFG_GLOBAL, NULL, "capture_changed_only", capture_changed_only);
+        config_set_int(CFG_GLOBAL, NULL, "capture_buffers", capture_buffers);
+        config_set_int(CFG_GLOBAL, NULL, "capture_fps", capture_fps);
 
         config_set_int(CFG_MACHINE, NULL, "gameblaster", GAMEBLASTER);
         config_set_int(CFG_MACHINE, NULL, "gus", GUS);
         config_set_int(CFG_MACHINE, NULL, "ssi2001", SSI2001);
         config_set_int(CFG_MACHINE, NULL, "voodoo", voodoo_enabled);
+        config_set_int(CFG_MACHINE, NULL, "frameskip_max", video_frameskip_max);
 
         config_set_string(CFG_MACHINE, NULL, "model", model_get_internal_name());
         config_set_int(CFG_MACHINE, NULL, "cpu_manufacturer", cpu_manufacturer);
         config_set_int(CFG_MACHINE, NULL, "cpu", cpu);
         config_set_string(CFG_MACHINE, NULL, "fpu", (char *)fpu_get_internal_name(model, cpu_manufacturer, cpu, fpu_type));
         config_set_int(CFG_MACHINE, NULL, "cpu_use_dynarec", cpu_use_dynarec);
+        config_set_int(CFG_MACHINE, NULL, "cpu_808x_fast", cpu_808x_fast);
         config_set_int(CFG_MACHINE, NULL, "cpu_waitstates", cpu_waitstates);
 
         config_set_string(CFG_MACHINE, NULL, "gfxcard", video_get_internal_name(video_old_to_new(gfxcard)));
@@ -91,6 +91,33 @@ void device_add_status_info(char *s, int max_len) {
         }
 }
 
+/*Handler private data is often a structure embedded in the device state (eg
+  svga_t), so if there is no exact match, take the closest device state that
+  starts shortly before the pointer*/
+#define DEVICE_PRIV_MAX_OFFSET 0x10000
+
+device_t *device_find_for_priv(void *priv) {
+        device_t *best = NULL;
+        uintptr_t best_offset = DEVICE_PRIV_MAX_OFFSET;
+        int c;
+
+        if (!priv)
+                return NULL;
+
+        for (c = 0; c < 256; c++) {
+                if (devices[c] != NULL && device_priv[c] != NULL && (uintptr_t)priv >= (uintptr_t)device_priv[c]) {
+                        uintptr_t offset = (uintptr_t)priv - (uintptr_t)device_priv[c];
+
+                        if (offset < best_offset) {
+                                best = devices[c];
+                                best_offset = offset;
+                        }
+                }
+        }
+
+        return best;
+}
+
 int device_get_config_int(char *s) {
         device_config_t *config = current_device->config;
 
@@ -23,6 +23,7 @@
 
 #include "timer.h"
 #include "thread.h"
+#include "video_capture.h"
 
 #include <pcem/devices.h>
 
@@ -246,6 +247,7 @@ void sound_poll(void *priv) {
 
                 if (soundon)
                         givealbuffer(outbuffer);
+                capture_audio(outbuffer, sound_buf_len_al);
 
                 sound_pos_global = 0;
                 sound_update_buf_length();
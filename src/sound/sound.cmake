@@ -10,6 +10,7 @@ set(PCEM_PRIVATE_API ${PCEM_PRIVATE_API}
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_ad1848.h
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_adlibgold.h
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_adlib.h
+        ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_async.h
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_audiopci.h
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_azt2316a.h
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_cms.h
@@ -19,6 +20,7 @@ set(PCEM_PRIVATE_API ${PCEM_PRIVATE_API}
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound.h
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_mpu401_uart.h
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_opl.h
+        ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_out.h
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_pas16.h
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_ps1.h
         ${CMAKE_SOURCE_DIR}/includes/private/sound/sound_pssj.h
@@ -37,6 +39,7 @@ set(PCEM_SRC ${PCEM_SRC}
         sound/sound_ad1848.c
         sound/sound_adlib.c
         sound/sound_adlibgold.c
+        sound/sound_async.c
         sound/sound_audiopci.c
         sound/sound_azt2316a.c
         sound/sound_cms.c
@@ -45,6 +48,7 @@ set(PCEM_SRC ${PCEM_SRC}
         sound/sound_gus.c
         sound/sound_mpu401_uart.c
         sound/sound_opl.c
+        sound/sound_out.c
         sound/sound_pas16.c
         sound/sound_ps1.c
         sound/sound_pssj.c
@@ -79,6 +79,7 @@ void *adlib_mca_init() {
 void adlib_close(void *p) {
         adlib_t *adlib = (adlib_t *)p;
 
+        opl_close(&adlib->opl);
         free(adlib);
 }
 
@@ -0,0 +1,119 @@
+#include <stdlib.h>
+#include "ibm.h"
+#include "sound.h"
+#include "sound_async.h"
+#include "thread.h"
+#include "timer.h"
+
+/*Emulated time between worker wakeups. The worker is never more than this far
+  behind when the block is collected*/
+#define SOUND_ASYNC_TICK_US 4000
+
+int sound_async = 0;
+
+#define ASYNC_ENTRIES(async) ((async)->write_idx - (async)->read_idx)
+#define ASYNC_FULL(async) (ASYNC_ENTRIES(async) >= SOUND_ASYNC_SIZE)
+#define ASYNC_EMPTY(async) ((async)->read_idx == (async)->write_idx)
+
+static void sound_async_thread(void *param) {
+        sound_async_t *async = (sound_async_t *)param;
+
+        while (1) {
+                thread_set_event(async->done_event);
+                thread_wait_event(async->wake_event, -1);
+                thread_reset_event(async->wake_event);
+
+                while (!ASYNC_EMPTY(async)) {
+                        sound_async_entry_t *entry = &async->queue[async->read_idx & SOUND_ASYNC_MASK];
+
+                        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+                        if (entry->pos > async->pos) {
+                                async->update(async->pos, entry->pos, async->priv);
+                                async->pos = entry->pos;
+                        }
+
+                        switch (entry->type) {
+                        case SOUND_ASYNC_WRITE:
+                                async->write(entry->chan, entry->addr, entry->val, async->priv);
+                                break;
+
+                        case SOUND_ASYNC_END:
+                                async->pos = 0;
+                                break;
+                        }
+
+                        __atomic_store_n(&async->read_idx, async->read_idx + 1, __ATOMIC_RELEASE);
+                }
+        }
+}
+
+static void sound_async_queue(sound_async_t *async, int type, int chan, uint16_t addr, uint8_t val) {
+        sound_async_entry_t *entry;
+
+        while (ASYNC_FULL(async)) {
+                thread_set_event(async->wake_event);
+                thread_wait_event(async->done_event, 1);
+        }
+
+        entry = &async->queue[async->write_idx & SOUND_ASYNC_MASK];
+        entry->pos = sound_pos_global;
+        entry->addr = addr;
+        entry->val = val;
+        entry->type = type;
+        entry->chan = chan;
+
+        __atomic_store_n(&async->write_idx, async->write_idx + 1, __ATOMIC_RELEASE);
+}
+
+static void sound_async_tick(void *p) {
+        sound_async_t *async = (sound_async_t *)p;
+
+        timer_advance_u64(&async->tick_timer, TIMER_USEC * SOUND_ASYNC_TICK_US);
+
+        sound_async_queue(async, SOUND_ASYNC_SYNC, 0, 0, 0);
+        thread_set_event(async->wake_event);
+}
+
+void sound_async_write(sound_async_t *async, int chan, uint16_t addr, uint8_t val) {
+        sound_async_queue(async, SOUND_ASYNC_WRITE, chan, addr, val);
+}
+
+void sound_async_sync(sound_async_t *async) {
+        sound_async_queue(async, SOUND_ASYNC_END, 0, 0, 0);
+
+        while (!ASYNC_EMPTY(async)) {
+                thread_set_event(async->wake_event);
+                thread_wait_event(async->done_event, 1);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+sound_async_t *sound_async_init(void (*update)(int pos, int end, void *p), void (*write)(int chan, uint16_t addr, uint8_t val, void *p),
+                                void *p) {
+        sound_async_t *async = malloc(sizeof(sound_async_t));
+        memset(async, 0, sizeof(sound_async_t));
+
+        async->update = update;
+        async->write = write;
+        async->priv = p;
+
+        async->wake_event = thread_create_event();
+        async->done_event = thread_create_event();
+        async->thread = thread_create(sound_async_thread, async);
+
+        timer_add(&async->tick_timer, sound_async_tick, async, 0);
+        timer_set_delay_u64(&async->tick_timer, TIMER_USEC * SOUND_ASYNC_TICK_US);
+
+        return async;
+}
+
+void sound_async_close(sound_async_t *async) {
+        timer_disable(&async->tick_timer);
+
+        thread_kill(async->thread);
+        thread_destroy_event(async->wake_event);
+        thread_destroy_event(async->done_event);
+
+        free(async);
+}
@@ -5,7 +5,9 @@
 static struct {
         DBOPL::Chip chip;
         struct opl3_chip opl3chip;
+        int chip_addr;
         int addr;
+        int newm;
         int timer[2];
         uint8_t timer_ctrl;
         uint8_t status_mask;
@@ -29,6 +31,7 @@ enum {
 
 void opl_init(void (*timer_callback)(void *param, int timer, int64_t period), void *timer_param, int nr, int is_opl3,
               int opl_emu) {
+        opl[nr].newm = 0;
         if (!is_opl3 || !opl_emu) {
                 DBOPL::InitTables();
                 opl[nr].chip.Setup(48000, is_opl3);
@@ -64,18 +67,33 @@ void opl_timer_over(int nr, int timer) {
         opl_status_update(nr);
 }
 
-void opl_write(int nr, uint16_t addr, uint8_t val) {
+/*Synthesis side of a register write. May be called from a sound worker thread*/
+void opl_write_reg(int nr, uint16_t addr, uint8_t val) {
         if (!(addr & 1)) {
                 if (!opl[nr].is_opl3 || !opl[nr].opl_emu)
-                        opl[nr].addr = (int)opl[nr].chip.WriteAddr(addr, val) & (opl[nr].is_opl3 ? 0x1ff : 0xff);
+                        opl[nr].chip_addr = (int)opl[nr].chip.WriteAddr(addr, val) & (opl[nr].is_opl3 ? 0x1ff : 0xff);
                 else
-                        opl[nr].addr = (int)OPL3_WriteAddr(&opl[nr].opl3chip, addr, val) & 0x1ff;
+                        opl[nr].chip_addr = (int)OPL3_WriteAddr(&opl[nr].opl3chip, addr, val) & 0x1ff;
         } else {
                 if (!opl[nr].is_opl3 || !opl[nr].opl_emu)
-                        opl[nr].chip.WriteReg(opl[nr].addr, val);
+                        opl[nr].chip.WriteReg(opl[nr].chip_addr, val);
                 else
-                        OPL3_WriteReg(&opl[nr].opl3chip, opl[nr].addr, val);
+                        OPL3_WriteReg(&opl[nr].opl3chip, opl[nr].chip_addr, val);
+        }
+}
 
+/*Timer and status side of a register write. Always called on the emulation
+  thread, and does not touch the synthesis core. The address latch is tracked
+  separately from the core's, following the same OPL3 high bank rules*/
+void opl_write_timer(int nr, uint16_t addr, uint8_t val) {
+        if (!(addr & 1)) {
+                if (!opl[nr].is_opl3)
+                        opl[nr].addr = val;
+                else if ((addr & 2) && (val == 0x05 || opl[nr].newm))
+                        opl[nr].addr = 0x100 | val;
+                else
+                        opl[nr].addr = val;
+        } else {
                 switch (opl[nr].addr) {
                 case 0x02: /*Timer 1*/
                         opl[nr].timer[0] = 256 - val;
@@ -105,10 +123,18 @@ void opl_write(int nr, uint16_t addr, uint8_t val) {
                         opl[nr].status_mask = (~val & (CTRL_TIMER1_MASK | CTRL_TIMER2_MASK)) | 0x80;
                         opl[nr].timer_ctrl = val;
                         break;
+                case 0x105: /*OPL3 mode*/
+                        opl[nr].newm = val & 1;
+                        break;
                 }
         }
 }
 
+void opl_write(int nr, uint16_t addr, uint8_t val) {
+        opl_write_reg(nr, addr, val);
+        opl_write_timer(nr, addr, val);
+}
+
 uint8_t opl_read(int nr, uint16_t addr) {
         if (!(addr & 1)) {
                 return (opl[nr].status & opl[nr].status_mask) | (opl[nr].is_opl3 ? 0 : 0x06);
@@ -3,22 +3,40 @@
 #include "ibm.h"
 #include "io.h"
 #include "sound.h"
+#include "sound_async.h"
 #include "sound_opl.h"
 #include "sound_dbopl.h"
 #include "x86.h"
 
 /*Interfaces between PCem and the actual OPL emulator*/
 
+/*Chip select for queued writes*/
+#define OPL_CHAN_L 1
+#define OPL_CHAN_R 2
+
+static void opl_queue_write(opl_t *opl, int chan, uint16_t a, uint8_t v) {
+        sound_async_write(opl->async, chan, a, v);
+        if (chan & OPL_CHAN_L)
+                opl_write_timer(0, a, v);
+        if (chan & OPL_CHAN_R)
+                opl_write_timer(1, a, v);
+}
+
 uint8_t opl2_read(uint16_t a, void *priv) {
         opl_t *opl = (opl_t *)priv;
 
         cycles -= (int)(isa_timing * 8);
-        opl2_update2(opl);
+        if (!opl->async)
+                opl2_update2(opl);
         return opl_read(0, a);
 }
 void opl2_write(uint16_t a, uint8_t v, void *priv) {
         opl_t *opl = (opl_t *)priv;
 
+        if (opl->async) {
+                opl_queue_write(opl, OPL_CHAN_L | OPL_CHAN_R, a, v);
+                return;
+        }
         opl2_update2(opl);
         opl_write(0, a, v);
         opl_write(1, a, v);
@@ -28,12 +46,17 @@ uint8_t opl2_l_read(uint16_t a, void *priv) {
         opl_t *opl = (opl_t *)priv;
 
         cycles -= (int)(isa_timing * 8);
-        opl2_update2(opl);
+        if (!opl->async)
+                opl2_update2(opl);
         return opl_read(0, a);
 }
 void opl2_l_write(uint16_t a, uint8_t v, void *priv) {
         opl_t *opl = (opl_t *)priv;
 
+        if (opl->async) {
+                opl_queue_write(opl, OPL_CHAN_L, a, v);
+                return;
+        }
         opl2_update2(opl);
         opl_write(0, a, v);
 }
@@ -42,12 +65,17 @@ uint8_t opl2_r_read(uint16_t a, void *priv) {
         opl_t *opl = (opl_t *)priv;
 
         cycles -= (int)(isa_timing * 8);
-        opl2_update2(opl);
+        if (!opl->async)
+                opl2_update2(opl);
         return opl_read(1, a);
 }
 void opl2_r_write(uint16_t a, uint8_t v, void *priv) {
         opl_t *opl = (opl_t *)priv;
 
+        if (opl->async) {
+                opl_queue_write(opl, OPL_CHAN_R, a, v);
+                return;
+        }
         opl2_update2(opl);
         opl_write(1, a, v);
 }
@@ -56,37 +84,69 @@ uint8_t opl3_read(uint16_t a, void *priv) {
         opl_t *opl = (opl_t *)priv;
 
         cycles -= (int)(isa_timing * 8);
-        opl3_update2(opl);
+        if (!opl->async)
+                opl3_update2(opl);
         return opl_read(0, a);
 }
 void opl3_write(uint16_t a, uint8_t v, void *priv) {
         opl_t *opl = (opl_t *)priv;
 
+        if (opl->async) {
+                opl_queue_write(opl, OPL_CHAN_L, a, v);
+                return;
+        }
         opl3_update2(opl);
         opl_write(0, a, v);
 }
 
+static void opl2_render(opl_t *opl, int pos, int end) {
+        opl2_update(0, &opl->buffer[pos * 2], end - pos);
+        opl2_update(1, &opl->buffer[pos * 2 + 1], end - pos);
+        for (; pos < end; pos++) {
+                opl->filtbuf[0] = opl->buffer[pos * 2] = (opl->buffer[pos * 2] / 2);
+                opl->filtbuf[1] = opl->buffer[pos * 2 + 1] = (opl->buffer[pos * 2 + 1] / 2);
+        }
+}
+
+static void opl3_render(opl_t *opl, int pos, int end) {
+        opl3_update(0, &opl->buffer[pos * 2], end - pos);
+        for (; pos < end; pos++) {
+                opl->filtbuf[0] = opl->buffer[pos * 2] = (opl->buffer[pos * 2] / 2);
+                opl->filtbuf[1] = opl->buffer[pos * 2 + 1] = (opl->buffer[pos * 2 + 1] / 2);
+        }
+}
+
 void opl2_update2(opl_t *opl) {
-        if (opl->pos < sound_pos_global) {
-                opl2_update(0, &opl->buffer[opl->pos * 2], sound_pos_global - opl->pos);
-                opl2_update(1, &opl->buffer[opl->pos * 2 + 1], sound_pos_global - opl->pos);
-                for (; opl->pos < sound_pos_global; opl->pos++) {
-                        opl->filtbuf[0] = opl->buffer[opl->pos * 2] = (opl->buffer[opl->pos * 2] / 2);
-                        opl->filtbuf[1] = opl->buffer[opl->pos * 2 + 1] = (opl->buffer[opl->pos * 2 + 1] / 2);
-                }
+        if (opl->async) {
+                sound_async_sync(opl->async);
+                opl->pos = sound_pos_global;
+        } else if (opl->pos < sound_pos_global) {
+                opl2_render(opl, opl->pos, sound_pos_global);
+                opl->pos = sound_pos_global;
         }
 }
 
 void opl3_update2(opl_t *opl) {
-        if (opl->pos < sound_pos_global) {
-                opl3_update(0, &opl->buffer[opl->pos * 2], sound_pos_global - opl->pos);
-                for (; opl->pos < sound_pos_global; opl->pos++) {
-                        opl->filtbuf[0] = opl->buffer[opl->pos * 2] = (opl->buffer[opl->pos * 2] / 2);
-                        opl->filtbuf[1] = opl->buffer[opl->pos * 2 + 1] = (opl->buffer[opl->pos * 2 + 1] / 2);
-                }
+        if (opl->async) {
+                sound_async_sync(opl->async);
+                opl->pos = sound_pos_global;
+        } else if (opl->pos < sound_pos_global) {
+                opl3_render(opl, opl->pos, sound_pos_global);
+                opl->pos = sound_pos_global;
         }
 }
 
+/*Worker thread callbacks*/
+static void opl2_async_update(int pos, int end, void *p) { opl2_render((opl_t *)p, pos, end); }
+static void opl3_async_update(int pos, int end, void *p) { opl3_render((opl_t *)p, pos, end); }
+
+static void opl_async_write(int chan, uint16_t a, uint8_t v, void *p) {
+        if (chan & OPL_CHAN_L)
+                opl_write_reg(0, a, v);
+        if (chan & OPL_CHAN_R)
+                opl_write_reg(1, a, v);
+}
+
 void ym3812_timer_set_0(void *param, int timer, int64_t period) {
         opl_t *opl = (opl_t *)param;
 
@@ -125,10 +185,21 @@ void opl2_init(opl_t *opl) {
         timer_add(&opl->timers[0][1], opl_timer_callback01, (void *)opl, 0);
         timer_add(&opl->timers[1][0], opl_timer_callback10, (void *)opl, 0);
         timer_add(&opl->timers[1][1], opl_timer_callback11, (void *)opl, 0);
+
+        opl->async = sound_async ? sound_async_init(opl2_async_update, opl_async_write, opl) : NULL;
 }
 
 void opl3_init(opl_t *opl, int opl_emu) {
         opl_init(ymf262_timer_set, opl, 0, 1, opl_emu);
         timer_add(&opl->timers[0][0], opl_timer_callback00, (void *)opl, 0);
         timer_add(&opl->timers[0][1], opl_timer_callback01, (void *)opl, 0);
+
+        opl->async = sound_async ? sound_async_init(opl3_async_update, opl_async_write, opl) : NULL;
+}
+
+void opl_close(opl_t *opl) {
+        if (opl->async) {
+                sound_async_close(opl->async);
+                opl->async = NULL;
+        }
 }
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#include "ibm.h"
+#include "sound.h"
+#include "sound_out.h"
+#include "thread.h"
+
+#define FREQ 48000
+
+/*Ring size in stereo frames. Must be a power of 2*/
+#define RING_SIZE 32768
+#define RING_MASK (RING_SIZE - 1)
+
+/*Maximum deviation of the output rate from nominal. 0.5% is well below the
+  threshold where pitch change becomes audible*/
+#define MAX_RATE_ADJUST 0.005
+
+int sound_sink = SOUND_SINK_OPENAL;
+char sound_sink_fn[512] = "pcem.wav";
+
+volatile int sound_out_overruns, sound_out_underruns;
+
+static int16_t ring[RING_SIZE * 2];
+static volatile uint32_t ring_read, ring_write;
+
+/*Resampler state, owned by the host audio thread*/
+static uint32_t phase;
+static double avg_fill;
+
+void sound_out_reset() {
+        ring_read = ring_write = 0;
+        phase = 0;
+        avg_fill = 0.0;
+        sound_out_overruns = sound_out_underruns = 0;
+}
+
+void sound_out_convert(int16_t *dest, const int32_t *src, int samples) {
+        int c = 0;
+
+#if defined(__SSE2__)
+        for (; c + 8 <= samples; c += 8) {
+                __m128i a = _mm_loadu_si128((const __m128i *)&src[c]);
+                __m128i b = _mm_loadu_si128((const __m128i *)&src[c + 4]);
+
+                _mm_storeu_si128((__m128i *)&dest[c], _mm_packs_epi32(a, b));
+        }
+#elif defined(__ARM_NEON)
+        for (; c + 8 <= samples; c += 8) {
+                int32x4_t a = vld1q_s32(&src[c]);
+                int32x4_t b = vld1q_s32(&src[c + 4]);
+
+                vst1q_s16(&dest[c], vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+        }
+#endif
+        for (; c < samples; c++) {
+                if (src[c] < -32768)
+                        dest[c] = -32768;
+                else if (src[c] > 32767)
+                        dest[c] = 32767;
+                else
+                        dest[c] = src[c];
+        }
+}
+
+int sound_out_fill() { return __atomic_load_n(&ring_write, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring_read, __ATOMIC_ACQUIRE); }
+
+void sound_out_write(int32_t *buf, int len) {
+        uint32_t write = ring_write;
+        uint32_t read = __atomic_load_n(&ring_read, __ATOMIC_ACQUIRE);
+        int first;
+
+        if (RING_SIZE - (int)(write - read) < len) {
+                sound_out_overruns++;
+                return;
+        }
+
+        first = RING_SIZE - (write & RING_MASK);
+        if (first > len)
+                first = len;
+        sound_out_convert(&ring[(write & RING_MASK) * 2], buf, first * 2);
+        if (first < len)
+                sound_out_convert(ring, &buf[first * 2], (len - first) * 2);
+
+        __atomic_store_n(&ring_write, write + len, __ATOMIC_RELEASE);
+}
+
+int sound_out_read(int16_t *buf, int len, int target) {
+        uint32_t read = ring_read;
+        uint32_t write = __atomic_load_n(&ring_write, __ATOMIC_ACQUIRE);
+        int fill = write - read;
+        double adjust;
+        uint32_t step;
+        int c;
+
+        /*Proportional control, reaching full correction at 50% above or below
+          the target. The fill level is smoothed as it is a sawtooth from the
+          block-sized writes*/
+        avg_fill += ((double)fill - avg_fill) / 16.0;
+        adjust = (2.0 * (avg_fill - (double)target)) / (double)target;
+        if (adjust > 1.0)
+                adjust = 1.0;
+        else if (adjust < -1.0)
+                adjust = -1.0;
+        step = (uint32_t)(65536.0 * (1.0 + adjust * MAX_RATE_ADJUST));
+
+        /*Linear interpolation between frames pos and pos+1, so both must be
+          buffered*/
+        for (c = 0; c < len; c++) {
+                uint32_t pos = read + (phase >> 16);
+                int32_t frac = (phase & 0xffff) >> 1;
+                int16_t *a, *b;
+
+                if ((int)(write - pos) < 2)
+                        break;
+
+                a = &ring[(pos & RING_MASK) * 2];
+                b = &ring[((pos + 1) & RING_MASK) * 2];
+                buf[c * 2] = a[0] + (((b[0] - a[0]) * frac) >> 15);
+                buf[c * 2 + 1] = a[1] + (((b[1] - a[1]) * frac) >> 15);
+
+                phase += step;
+        }
+
+        if (c < len) {
+                /*Underrun - hold the last output value rather than clicking to zero*/
+                int16_t l = c ? buf[(c - 1) * 2] : 0;
+                int16_t r = c ? buf[(c - 1) * 2 + 1] : 0;
+                int d;
+
+                for (d = c; d < len; d++) {
+                        buf[d * 2] = l;
+                        buf[d * 2 + 1] = r;
+                }
+                sound_out_underruns++;
+        }
+
+        read += phase >> 16;
+        phase &= 0xffff;
+        __atomic_store_n(&ring_read, read, __ATOMIC_RELEASE);
+
+        return c;
+}
+
+/*Null and file sinks. These stand in for the host audio device, pulling
+  frames at the rate given by the host clock*/
+static thread_t *sink_thread;
+static volatile int sink_running, sink_done;
+static FILE *sink_f;
+static uint32_t sink_bytes;
+
+void sound_out_wav_header(FILE *f, uint32_t bytes) {
+        uint8_t header[44];
+
+        memcpy(&header[0], "RIFF", 4);
+        *(uint32_t *)&header[4] = 36 + bytes;
+        memcpy(&header[8], "WAVEfmt ", 8);
+        *(uint32_t *)&header[16] = 16;
+        *(uint16_t *)&header[20] = 1; /*PCM*/
+        *(uint16_t *)&header[22] = 2;
+        *(uint32_t *)&header[24] = FREQ;
+        *(uint32_t *)&header[28] = FREQ * 4;
+        *(uint16_t *)&header[32] = 4;
+        *(uint16_t *)&header[34] = 16;
+        memcpy(&header[36], "data", 4);
+        *(uint32_t *)&header[40] = bytes;
+
+        fseek(f, 0, SEEK_SET);
+        fwrite(header, 44, 1, f);
+        fseek(f, 0, SEEK_END);
+}
+
+static void sound_out_sink_thread(void *param) {
+        int16_t buf[MAXSOUNDBUFLEN * 2];
+        uint64_t last_time = timer_read();
+        uint64_t frac = 0;
+
+        while (sink_running) {
+                uint64_t new_time;
+                int frames;
+
+                thread_sleep(10);
+
+                new_time = timer_read();
+                frac += (new_time - last_time) * FREQ;
+                last_time = new_time;
+                frames = frac / timer_freq;
+                frac -= frames * timer_freq;
+
+                while (frames > 0) {
+                        int len = (frames > MAXSOUNDBUFLEN) ? MAXSOUNDBUFLEN : frames;
+
+                        sound_out_read(buf, len, sound_buf_len_al * 2);
+                        if (sink_f) {
+                                fwrite(buf, len * 4, 1, sink_f);
+                                sink_bytes += len * 4;
+                        }
+                        frames -= len;
+                }
+        }
+
+        sink_done = 1;
+}
+
+void sound_out_sink_init() {
+        if (sound_sink == SOUND_SINK_FILE) {
+                sink_f = fopen(sound_sink_fn, "wb");
+                if (!sink_f)
+                        pclog("sound_out_sink_init: can't open %s\n", sound_sink_fn);
+                else {
+                        sink_bytes = 0;
+                        sound_out_wav_header(sink_f, sink_bytes);
+                }
+        }
+
+        sink_running = 1;
+        sink_done = 0;
+        sink_thread = thread_create(sound_out_sink_thread, NULL);
+}
+
+void sound_out_sink_close() {
+        if (!sink_thread)
+                return;
+
+        sink_running = 0;
+        while (!sink_done)
+                thread_sleep(1);
+        thread_kill(sink_thread);
+        sink_thread = NULL;
+
+        if (sink_f) {
+                sound_out_wav_header(sink_f, sink_bytes);
+                fclose(sink_f);
+                sink_f = NULL;
+        }
+}
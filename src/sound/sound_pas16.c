@@ -709,6 +709,7 @@ void *pas16_init() {
 void pas16_close(void *p) {
         pas16_t *pas16 = (pas16_t *)p;
 
+        opl_close(&pas16->opl);
         free(pas16);
 }
 
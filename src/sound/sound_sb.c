@@ -1096,6 +1096,7 @@ void *sb_awe32_init() {
 
 void sb_close(void *p) {
         sb_t *sb = (sb_t *)p;
+        opl_close(&sb->opl);
         sb_dsp_close(&sb->dsp);
 #ifdef SB_DSP_RECORD_DEBUG
         if (soundfsb != 0) {
@@ -15,6 +15,8 @@
 #endif
 #include "ibm.h"
 #include "sound.h"
+#include "sound_out.h"
+#include "thread.h"
 
 FILE *allog;
 #ifdef USE_OPENAL
@@ -26,6 +28,9 @@ static ALuint source[2]; // audio source
 
 int sound_buf_len_al = 48000 / 20;
 
+static thread_t *al_thread;
+static volatile int al_thread_running, al_thread_done;
+
 void closeal();
 ALvoid alutInit(ALint *argc, ALbyte **argv) {
         ALCcontext *Context;
@@ -59,6 +64,11 @@ ALvoid alutExit(ALvoid) {
         alcCloseDevice(Device);
 }
 void initalmain(int argc, char *argv[]) {
+        sound_out_reset();
+        if (sound_sink != SOUND_SINK_OPENAL) {
+                atexit(closeal);
+                return;
+        }
 #ifdef USE_OPENAL
         alutInit(0, 0);
         //        printf("AlutInit\n");
@@ -68,7 +78,18 @@ void initalmain(int argc, char *argv[]) {
 }
 
 void closeal() {
+        if (sound_sink != SOUND_SINK_OPENAL) {
+                sound_out_sink_close();
+                return;
+        }
 #ifdef USE_OPENAL
+        if (al_thread) {
+                al_thread_running = 0;
+                while (!al_thread_done)
+                        thread_sleep(1);
+                thread_kill(al_thread);
+                al_thread = NULL;
+        }
         alutExit();
 #endif
 }
@@ -83,7 +104,58 @@ void check() {
 #endif
 }
 
+#ifdef USE_OPENAL
+/*Host audio thread. Refills processed OpenAL buffers from the output ring,
+  independently of emulation speed*/
+static void al_thread_func(void *param) {
+        int16_t buf16[MAXSOUNDBUFLEN * 2];
+        int last_gain = -1;
+
+        while (al_thread_running) {
+                int processed;
+                int state;
+
+                thread_sleep(5);
+
+                alGetSourcei(source[0], AL_SOURCE_STATE, &state);
+                if (state == AL_STOPPED)
+                        alSourcePlay(source[0]);
+
+                if (sound_gain != last_gain) {
+                        last_gain = sound_gain;
+                        alListenerf(AL_GAIN, pow(10.0, (double)sound_gain / 20.0));
+                }
+
+                alGetSourcei(source[0], AL_BUFFERS_PROCESSED, &processed);
+                check();
+
+                while (processed-- > 0) {
+                        ALuint buffer;
+                        int len = sound_buf_len_al;
+
+                        assert(len <= MAXSOUNDBUFLEN);
+
+                        alSourceUnqueueBuffers(source[0], 1, &buffer);
+                        check();
+
+                        sound_out_read(buf16, len, len * 2);
+                        alBufferData(buffer, AL_FORMAT_STEREO16, buf16, len * 2 * 2, FREQ);
+                        check();
+
+                        alSourceQueueBuffers(source[0], 1, &buffer);
+                        check();
+                }
+        }
+
+        al_thread_done = 1;
+}
+#endif
+
 void inital() {
+        if (sound_sink != SOUND_SINK_OPENAL) {
+                sound_out_sink_init();
+                return;
+        }
 #ifdef USE_OPENAL
         int c;
         int16_t buf[MAXSOUNDBUFLEN * 2];
@@ -137,74 +209,17 @@ void inital() {
         alSourcePlay(source[1]);
         check();
 //        printf("InitAL!!! %08X\n",source);
+
+        al_thread_running = 1;
+        al_thread_done = 0;
+        al_thread = thread_create(al_thread_func, NULL);
 #endif
 }
 
 void givealbuffer(int32_t *buf) {
-#ifdef USE_OPENAL
-        int16_t buf16[MAXSOUNDBUFLEN * 2];
-        int processed;
-        int state;
-
         assert(sound_buf_len_al <= MAXSOUNDBUFLEN);
 
-        // return;
-
-        //        printf("Start\n");
-        check();
-
-        //        printf("GiveALBuffer %08X\n",source);
-
-        alGetSourcei(source[0], AL_SOURCE_STATE, &state);
-
-        check();
-
-        if (state == 0x1014) {
-                alSourcePlay(source[0]);
-                //                printf("Resetting sound\n");
-        }
-        //        printf("State - %i %08X\n",state,state);
-        alGetSourcei(source[0], AL_BUFFERS_PROCESSED, &processed);
-
-        //        printf("P ");
-        check();
-        //        printf("Processed - %i\n",processed);
-
-        if (processed >= 1) {
-                int c;
-                ALuint buffer;
-                double gain = pow(10.0, (double)sound_gain / 20.0);
-
-                alListenerf(AL_GAIN, gain);
-
-                alSourceUnqueueBuffers(source[0], 1, &buffer);
-                //                printf("U ");
-                check();
-
-                for (c = 0; c < sound_buf_len_al * 2; c++) {
-                        if (buf[c] < -32768)
-                                buf16[c] = -32768;
-                        else if (buf[c] > 32767)
-                                buf16[c] = 32767;
-                        else
-                                buf16[c] = buf[c];
-                }
-                //                for (c=0;c<sound_buf_len_al*2;c++) buf[c]^=0x8000;
-                alBufferData(buffer, AL_FORMAT_STEREO16, buf16, sound_buf_len_al * 2 * 2, FREQ);
-                //                printf("B ");
-                check();
-
-                alSourceQueueBuffers(source[0], 1, &buffer);
-                //                printf("Q ");
-                check();
-
-                //                printf("\n");
-
-                //                if (!allog) allog=fopen("al.pcm","wb");
-                //                fwrite(buf,sound_buf_len_al*2,1,allog);
-        }
-//        printf("\n");
-#endif
+        sound_out_write(buf, sound_buf_len_al);
 }
 
 void givealbuffer_cd(int16_t *buf) {
@@ -212,6 +227,9 @@ void givealbuffer_cd(int16_t *buf) {
         int processed;
         int state;
 
+        if (sound_sink != SOUND_SINK_OPENAL)
+                return;
+
         // return;
 
         //        printf("Start\n");
@@ -236,9 +254,6 @@ void givealbuffer_cd(int16_t *buf) {
 
         if (processed >= 1) {
                 ALuint buffer;
-                double gain = pow(10.0, (double)sound_gain / 20.0);
-
-                alListenerf(AL_GAIN, gain);
 
                 alSourceUnqueueBuffers(source[1], 1, &buffer);
                 //                printf("U ");
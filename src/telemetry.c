@@ -0,0 +1,318 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+#include "ibm.h"
+#include "paths.h"
+#include "x86.h"
+#include "codegen.h"
+#include "sound_out.h"
+#include "timer.h"
+#include "video.h"
+#include "video_capture.h"
+#include "telemetry.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TELEMETRY_SOCKETS
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+int telemetry_enabled = 0;
+int telemetry_interval = 1000;
+int telemetry_format = TELEMETRY_FORMAT_JSON;
+char telemetry_fn[512] = "pcem_telemetry.jsonl";
+
+extern int fps;
+extern int sreadlnum, swritelnum, segareads, segawrites, scycles_lost;
+
+enum {
+        TELEMETRY_GAUGE_INT = 0,
+        TELEMETRY_GAUGE_FLOAT,
+        TELEMETRY_GAUGE_FUNC,
+        TELEMETRY_COUNTER_INT,
+        TELEMETRY_COUNTER_U64
+};
+
+typedef struct telemetry_value_t {
+        char name[64];
+        int type;
+
+        union {
+                volatile int *i;
+                volatile float *f;
+                volatile uint64_t *u64;
+                double (*get)(void *p);
+        } val;
+        void *p;
+
+        uint64_t last;
+} telemetry_value_t;
+
+#define TELEMETRY_MAX_VALUES 128
+
+static telemetry_value_t telemetry_values[TELEMETRY_MAX_VALUES];
+static int telemetry_nr_values;
+/*Set whenever the registry changes, so CSV output can write a new header*/
+static int telemetry_changed;
+
+static FILE *telemetry_f;
+#ifdef TELEMETRY_SOCKETS
+static int telemetry_socket = -1;
+#endif
+static int telemetry_open_failed;
+
+static uint64_t telemetry_start_time, telemetry_last_time;
+
+#define TELEMETRY_BUF_SIZE 16384
+static char telemetry_buf[TELEMETRY_BUF_SIZE];
+
+static telemetry_value_t *telemetry_add(const char *name, int type) {
+        telemetry_value_t *v;
+
+        if (telemetry_nr_values == TELEMETRY_MAX_VALUES) {
+                pclog("telemetry_add : too many values, dropping %s\n", name);
+                return NULL;
+        }
+
+        v = &telemetry_values[telemetry_nr_values++];
+        memset(v, 0, sizeof(telemetry_value_t));
+        safe_strncpy(v->name, name, sizeof(v->name));
+        v->type = type;
+        telemetry_changed = 1;
+
+        return v;
+}
+
+void telemetry_add_gauge_int(const char *name, volatile int *val) {
+        telemetry_value_t *v = telemetry_add(name, TELEMETRY_GAUGE_INT);
+
+        if (v)
+                v->val.i = val;
+}
+void telemetry_add_gauge_float(const char *name, volatile float *val) {
+        telemetry_value_t *v = telemetry_add(name, TELEMETRY_GAUGE_FLOAT);
+
+        if (v)
+                v->val.f = val;
+}
+void telemetry_add_gauge_func(const char *name, double (*get)(void *p), void *p) {
+        telemetry_value_t *v = telemetry_add(name, TELEMETRY_GAUGE_FUNC);
+
+        if (v) {
+                v->val.get = get;
+                v->p = p;
+        }
+}
+void telemetry_add_counter_int(const char *name, volatile int *val) {
+        telemetry_value_t *v = telemetry_add(name, TELEMETRY_COUNTER_INT);
+
+        if (v) {
+                v->val.i = val;
+                v->last = (uint32_t)*val;
+        }
+}
+void telemetry_add_counter_u64(const char *name, volatile uint64_t *val) {
+        telemetry_value_t *v = telemetry_add(name, TELEMETRY_COUNTER_U64);
+
+        if (v) {
+                v->val.u64 = val;
+                v->last = *val;
+        }
+}
+
+void telemetry_remove(const void *p) {
+        int c = 0;
+
+        while (c < telemetry_nr_values) {
+                telemetry_value_t *v = &telemetry_values[c];
+                const void *v_p = (v->type == TELEMETRY_GAUGE_FUNC) ? v->p : (const void *)v->val.i;
+
+                if (v_p == p) {
+                        memmove(v, v + 1, sizeof(telemetry_value_t) * (telemetry_nr_values - c - 1));
+                        telemetry_nr_values--;
+                        telemetry_changed = 1;
+                } else
+                        c++;
+        }
+}
+
+void telemetry_init() {
+        telemetry_add_gauge_int("speed", &fps);
+        telemetry_add_gauge_int("emu_fps", &emu_fps);
+        telemetry_add_gauge_float("mips", &mips);
+        telemetry_add_gauge_float("mflops", &flops);
+        telemetry_add_gauge_int("mem_reads", &sreadlnum);
+        telemetry_add_gauge_int("mem_writes", &swritelnum);
+        telemetry_add_gauge_int("video_reads", &segareads);
+        telemetry_add_gauge_int("video_writes", &segawrites);
+        telemetry_add_gauge_int("cycles_lost", &scycles_lost);
+        telemetry_add_gauge_int("recomp_new_blocks", &cpu_new_blocks_latched);
+        telemetry_add_gauge_int("recomp_blocks", &cpu_recomp_blocks_latched);
+        telemetry_add_gauge_int("recomp_ins", &cpu_recomp_ins_latched);
+        telemetry_add_gauge_int("recomp_full_ins", &cpu_recomp_full_ins_latched);
+        telemetry_add_gauge_int("recomp_flushes", &cpu_recomp_flushes_latched);
+        telemetry_add_gauge_int("recomp_evicted", &cpu_recomp_evicted_latched);
+        telemetry_add_gauge_int("recomp_reuse", &cpu_recomp_reuse_latched);
+        telemetry_add_gauge_int("recomp_removed", &cpu_recomp_removed_latched);
+        telemetry_add_counter_u64("timer_callbacks", &timer_callbacks);
+        telemetry_add_counter_int("sound_underruns", &sound_out_underruns);
+        telemetry_add_counter_int("sound_overruns", &sound_out_overruns);
+        telemetry_add_counter_int("capture_dropped_frames", &capture_dropped_frames);
+        telemetry_add_counter_int("capture_dropped_audio", &capture_dropped_audio);
+        telemetry_add_counter_int("video_frames_skipped", &video_frames_skipped);
+}
+
+static void telemetry_open() {
+        if (telemetry_interval < 10)
+                telemetry_interval = 10;
+
+#ifdef TELEMETRY_SOCKETS
+        if (!strncmp(telemetry_fn, "unix:", 5)) {
+                struct sockaddr_un addr;
+
+                memset(&addr, 0, sizeof(addr));
+                addr.sun_family = AF_UNIX;
+                safe_strncpy(addr.sun_path, telemetry_fn + 5, sizeof(addr.sun_path));
+
+                telemetry_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+                if (telemetry_socket != -1 && connect(telemetry_socket, (struct sockaddr *)&addr, sizeof(addr))) {
+                        close(telemetry_socket);
+                        telemetry_socket = -1;
+                }
+                if (telemetry_socket == -1) {
+                        pclog("telemetry_open : can't connect to %s\n", telemetry_fn);
+                        telemetry_open_failed = 1;
+                }
+                return;
+        }
+#endif
+        telemetry_f = fopen(telemetry_fn, "wt");
+        if (!telemetry_f) {
+                pclog("telemetry_open : can't open %s\n", telemetry_fn);
+                telemetry_open_failed = 1;
+        }
+}
+
+static void telemetry_write(const char *s, int len) {
+#ifdef TELEMETRY_SOCKETS
+        if (telemetry_socket != -1) {
+                /*Never block the emulation thread on a slow reader - drop the
+                  sample instead*/
+                if (send(telemetry_socket, s, len, MSG_DONTWAIT | MSG_NOSIGNAL) == -1 && errno != EAGAIN &&
+                    errno != EWOULDBLOCK) {
+                        pclog("telemetry_write : socket closed\n");
+                        close(telemetry_socket);
+                        telemetry_socket = -1;
+                        telemetry_open_failed = 1;
+                }
+                return;
+        }
+#endif
+        if (telemetry_f) {
+                fwrite(s, len, 1, telemetry_f);
+                fflush(telemetry_f);
+        }
+}
+
+static double telemetry_read(telemetry_value_t *v, double elapsed) {
+        uint64_t cur;
+        double rate;
+
+        switch (v->type) {
+        case TELEMETRY_GAUGE_INT:
+                return (double)*v->val.i;
+        case TELEMETRY_GAUGE_FLOAT:
+                return (double)*v->val.f;
+        case TELEMETRY_GAUGE_FUNC:
+                return v->val.get(v->p);
+        case TELEMETRY_COUNTER_INT:
+        case TELEMETRY_COUNTER_U64:
+                cur = (v->type == TELEMETRY_COUNTER_INT) ? (uint32_t)*v->val.i : *v->val.u64;
+                /*Counter has been reset since the last sample*/
+                if (cur < v->last)
+                        v->last = 0;
+                rate = (double)(cur - v->last) / elapsed;
+                v->last = cur;
+                return rate;
+        }
+        return 0.0;
+}
+
+void telemetry_poll() {
+        uint64_t now;
+        double elapsed;
+        int len = 0;
+        int c;
+
+        if (!telemetry_enabled || telemetry_open_failed || !timer_freq)
+                return;
+
+        now = timer_read();
+        if (!telemetry_start_time) {
+                telemetry_open();
+                telemetry_start_time = telemetry_last_time = now;
+                return;
+        }
+        if ((now - telemetry_last_time) < ((uint64_t)telemetry_interval * timer_freq) / 1000)
+                return;
+
+        elapsed = (double)(now - telemetry_last_time) / (double)timer_freq;
+        telemetry_last_time = now;
+
+        if (telemetry_format == TELEMETRY_FORMAT_CSV) {
+                if (telemetry_changed) {
+                        len += snprintf(telemetry_buf + len, TELEMETRY_BUF_SIZE - len, "time");
+                        for (c = 0; c < telemetry_nr_values && len < TELEMETRY_BUF_SIZE; c++)
+                                len += snprintf(telemetry_buf + len, TELEMETRY_BUF_SIZE - len, ",%s",
+                                                telemetry_values[c].name);
+                        if (len < TELEMETRY_BUF_SIZE)
+                                len += snprintf(telemetry_buf + len, TELEMETRY_BUF_SIZE - len, "\n");
+                }
+                if (len < TELEMETRY_BUF_SIZE)
+                        len += snprintf(telemetry_buf + len, TELEMETRY_BUF_SIZE - len, "%.3f",
+                                        (double)(now - telemetry_start_time) / (double)timer_freq);
+                for (c = 0; c < telemetry_nr_values && len < TELEMETRY_BUF_SIZE; c++)
+                        len += snprintf(telemetry_buf + len, TELEMETRY_BUF_SIZE - len, ",%g",
+                                        telemetry_read(&telemetry_values[c], elapsed));
+                if (len < TELEMETRY_BUF_SIZE)
+                        len += snprintf(telemetry_buf + len, TELEMETRY_BUF_SIZE - len, "\n");
+        } else {
+                len += snprintf(telemetry_buf + len, TELEMETRY_BUF_SIZE - len, "{\"time\":%.3f",
+                                (double)(now - telemetry_start_time) / (double)timer_freq);
+                for (c = 0; c < telemetry_nr_values && len < TELEMETRY_BUF_SIZE; c++)
+                        len += snprintf(telemetry_buf + len, TELEMETRY_BUF_SIZE - len, ",\"%s\":%g",
+                                        telemetry_values[c].name, telemetry_read(&telemetry_values[c], elapsed));
+                if (len < TELEMETRY_BUF_SIZE)
+                        len += snprintf(telemetry_buf + len, TELEMETRY_BUF_SIZE - len, "}\n");
+        }
+        telemetry_changed = 0;
+
+        /*Sample didn't fit - drop it rather than write a truncated line*/
+        if (len >= TELEMETRY_BUF_SIZE) {
+                pclog("telemetry_poll : sample too large\n");
+                return;
+        }
+        telemetry_write(telemetry_buf, len);
+}
+
+void telemetry_close() {
+        if (telemetry_f) {
+                fclose(telemetry_f);
+                telemetry_f = NULL;
+        }
+#ifdef TELEMETRY_SOCKETS
+        if (telemetry_socket != -1) {
+                close(telemetry_socket);
+                telemetry_socket = -1;
+        }
+#endif
+        telemetry_start_time = 0;
+        telemetry_open_failed = 0;
+}
@@ -4,6 +4,7 @@
 
 uint64_t TIMER_USEC;
 uint32_t timer_target;
+uint64_t timer_callbacks;
 
 /*Enabled timers are stored in a linked list, with the first timer to expire at
   the head.*/
@@ -79,7 +80,8 @@ static void timer_remove_head() {
                 pc_timer_t *timer = timer_head;
                 //		pclog("timer_remove_head %p %p\n", timer_head, timer_head->next);
                 timer_head = timer->next;
-                timer_head->prev = NULL;
+                if (timer_head)
+                        timer_head->prev = NULL;
                 timer->next = timer->prev = NULL;
                 timer->enabled = 0;
         }
@@ -89,17 +91,19 @@ void timer_process() {
         if (!timer_head)
                 return;
 
-        while (1) {
+        while (timer_head) {
                 pc_timer_t *timer = timer_head;
 
                 if (!TIMER_LESS_THAN_VAL(timer, (uint32_t)tsc))
                         break;
 
                 timer_remove_head();
+                timer_callbacks++;
                 timer->callback(timer->p);
         }
 
-        timer_target = timer_head->ts_integer;
+        if (timer_head)
+                timer_target = timer_head->ts_integer;
 }
 
 void timer_reset() {
@@ -142,7 +142,13 @@ void cga_poll(void *p) {
                                 //                                printf("Firstline %i\n",firstline);
                         }
                         cga->lastline = cga->displine;
-
+                }
+                if (cga->frameskip) {
+                        /*Not drawn, see video_frameskip(). Every mode reads one
+                          character or word per column*/
+                        if (cga->cgadispon)
+                                cga->ma += cga->crtc[1];
+                } else if (cga->cgadispon) {
                         cols[0] = ((cga->cgamode & 0x12) == 0x12) ? 0 : (cga->cgacol & 15);
                         for (c = 0; c < 8; c++) {
                                 ((uint32_t *)buffer32->line[cga->displine])[c] = cols[0];
@@ -282,12 +288,12 @@ void cga_poll(void *p) {
                 else
                         x = (cga->crtc[1] << 4) + 16;
 
-                if (cga->composite) {
+                if (cga->composite && !cga->frameskip) {
                         for (c = 0; c < x; c++)
                                 buffer32->line[cga->displine][c] = ((uint32_t *)buffer32->line[cga->displine])[c] & 0xf;
 
                         Composite_Process(cga->cgamode, 0, x >> 2, buffer32->line[cga->displine]);
-                } else {
+                } else if (!cga->frameskip) {
                         for (c = 0; c < x; c++)
                                 ((uint32_t *)buffer32->line[cga->displine])[c] =
                                         cgapal[((uint32_t *)buffer32->line[cga->displine])[c] & 0xf];
@@ -366,8 +372,11 @@ void cga_poll(void *p) {
                                                 updatewindowsize(xsize, (ysize << 1) + 16);
                                         }
 
-                                        video_blit_memtoscreen(0, cga->firstline - 4, 0, (cga->lastline - cga->firstline) + 8,
-                                                               xsize, (cga->lastline - cga->firstline) + 8);
+                                        if (!cga->frameskip)
+                                                video_blit_memtoscreen(0, cga->firstline - 4, 0,
+                                                                       (cga->lastline - cga->firstline) + 8, xsize,
+                                                                       (cga->lastline - cga->firstline) + 8);
+                                        cga->frameskip = video_frameskip(&cga->frameskip_count);
                                         frames++;
 
                                         video_res_x = xsize - 16;
@@ -534,7 +534,9 @@ void ega_poll(void *p) {
                                 video_wait_for_buffer();
                         }
 
-                        if (ega->scrblank) {
+                        if (ega->frameskip) {
+                                /*Not drawn, see video_frameskip()*/
+                        } else if (ega->scrblank) {
                                 for (x = 0; x < ega->hdisp; x++) {
                                         switch (ega->seqregs[1] & 9) {
                                         case 0:
@@ -624,7 +626,7 @@ void ega_poll(void *p) {
                                 fullchange = 2;
                         ega->blink++;
 
-                        if (fullchange)
+                        if (fullchange && !ega->frameskip)
                                 fullchange--;
                 }
                 if (ega->vc == ega->vsyncstart) {
@@ -651,7 +653,10 @@ void ega_poll(void *p) {
                                         updatewindowsize(xsize, ysize);
                         }
 
-                        video_blit_memtoscreen(32, 0, ega->firstline, ega->lastline, xsize, ega->lastline - ega->firstline);
+                        if (!ega->frameskip)
+                                video_blit_memtoscreen(32, 0, ega->firstline, ega->lastline, xsize,
+                                                       ega->lastline - ega->firstline);
+                        ega->frameskip = video_frameskip(&ega->frameskip_count);
 
                         ega->frames++;
                         ega->video_res_x = xsize;
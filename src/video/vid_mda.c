@@ -104,30 +104,36 @@ void mda_poll(void *p) {
                                 video_wait_for_buffer();
                         }
                         mda->lastline = mda->displine;
-                        for (x = 0; x < mda->crtc[1]; x++) {
-                                chr = mda->vram[(mda->ma << 1) & 0xfff];
-                                attr = mda->vram[((mda->ma << 1) + 1) & 0xfff];
-                                drawcursor = ((mda->ma == ca) && mda->con && mda->cursoron);
-                                blink = ((mda->blink & 16) && (mda->ctrl & 0x20) && (attr & 0x80) && !drawcursor);
-                                if (mda->sc == 12 && ((attr & 7) == 1)) {
-                                        for (c = 0; c < 9; c++)
-                                                ((uint32_t *)buffer32->line[mda->displine])[(x * 9) + c] =
-                                                        mdacols[attr][blink][1];
-                                } else {
-                                        for (c = 0; c < 8; c++)
-                                                ((uint32_t *)buffer32->line[mda->displine])[(x * 9) + c] =
-                                                        mdacols[attr][blink][(fontdatm[chr][mda->sc] & (1 << (c ^ 7))) ? 1 : 0];
-                                        if ((chr & ~0x1f) == 0xc0)
-                                                ((uint32_t *)buffer32->line[mda->displine])[(x * 9) + 8] =
-                                                        mdacols[attr][blink][fontdatm[chr][mda->sc] & 1];
-                                        else
-                                                ((uint32_t *)buffer32->line[mda->displine])[(x * 9) + 8] =
-                                                        mdacols[attr][blink][0];
-                                }
-                                mda->ma++;
-                                if (drawcursor) {
-                                        for (c = 0; c < 9; c++)
-                                                ((uint32_t *)buffer32->line[mda->displine])[(x * 9) + c] ^= mdacols[attr][0][1];
+                        if (mda->frameskip) { /*Not drawn, see video_frameskip()*/
+                                mda->ma += mda->crtc[1];
+                        } else {
+                                for (x = 0; x < mda->crtc[1]; x++) {
+                                        chr = mda->vram[(mda->ma << 1) & 0xfff];
+                                        attr = mda->vram[((mda->ma << 1) + 1) & 0xfff];
+                                        drawcursor = ((mda->ma == ca) && mda->con && mda->cursoron);
+                                        blink = ((mda->blink & 16) && (mda->ctrl & 0x20) && (attr & 0x80) && !drawcursor);
+                                        if (mda->sc == 12 && ((attr & 7) == 1)) {
+                                                for (c = 0; c < 9; c++)
+                                                        ((uint32_t *)buffer32->line[mda->displine])[(x * 9) + c] =
+                                                                mdacols[attr][blink][1];
+                                        } else {
+                                                for (c = 0; c < 8; c++)
+                                                        ((uint32_t *)buffer32->line[mda->displine])[(x * 9) + c] =
+                                                                mdacols[attr][blink]
+                                                                       [(fontdatm[chr][mda->sc] & (1 << (c ^ 7))) ? 1 : 0];
+                                                if ((chr & ~0x1f) == 0xc0)
+                                                        ((uint32_t *)buffer32->line[mda->displine])[(x * 9) + 8] =
+                                                                mdacols[attr][blink][fontdatm[chr][mda->sc] & 1];
+                                                else
+                                                        ((uint32_t *)buffer32->line[mda->displine])[(x * 9) + 8] =
+                                                                mdacols[attr][blink][0];
+                                        }
+                                        mda->ma++;
+                                        if (drawcursor) {
+                                                for (c = 0; c < 9; c++)
+                                                        ((uint32_t *)buffer32->line[mda->displine])[(x * 9) + c] ^=
+                                                                mdacols[attr][0][1];
+                                        }
                                 }
                         }
                 }
@@ -207,7 +213,9 @@ void mda_poll(void *p) {
                                                 updatewindowsize(xsize, ysize);
                                         }
 
-                                        video_blit_memtoscreen(0, mda->firstline, 0, ysize, xsize, ysize);
+                                        if (!mda->frameskip)
+                                                video_blit_memtoscreen(0, mda->firstline, 0, ysize, xsize, ysize);
+                                        mda->frameskip = video_frameskip(&mda->frameskip_count);
 
                                         frames++;
                                         video_res_x = mda->crtc[1];
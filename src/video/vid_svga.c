@@ -5,6 +5,7 @@
 #include "mem.h"
 #include "video.h"
 #include "vid_svga.h"
+#include "vid_svga_compose.h"
 #include "vid_svga_render.h"
 #include "io.h"
 #include "timer.h"
@@ -18,17 +19,113 @@ extern uint8_t edatlookup[4][4];
 
 uint8_t svga_rotate[8][256];
 
+int svga_lfb_direct = 0;
+
 /*Primary SVGA device. As multiple video cards are not yet supported this is the
   only SVGA device.*/
 static svga_t *svga_pri;
 
 svga_t *svga_get_pri() { return svga_pri; }
 void svga_set_override(svga_t *svga, int val) {
+        if (svga->compose)
+                svga_compose_flush(svga->compose);
         if (svga->override && !val)
                 svga->fullchange = changeframecount;
         svga->override = val;
 }
 
+#define LFB_TLB_MAP_WORDS(svga) (((svga)->lfb_tlb_vram_size + 0x1ffff) >> 17)
+
+/*Plain stores to VRAM only match svga_write*_linear() when none of the VGA
+  write logic is in use*/
+static inline int svga_lfb_direct_allowed(svga_t *svga) {
+        return svga->fast && !svga->writemode && !(svga->gdcreg[3] & 7);
+}
+
+static void svga_lfb_tlb_mark_changed(svga_t *svga) {
+        int c;
+
+        for (c = 0; c < LFB_TLB_MAP_WORDS(svga); c++) {
+                uint32_t bits = svga->lfb_tlb_map[c];
+
+                while (bits) {
+                        int bit = 0;
+
+                        while (!(bits & (1 << bit)))
+                                bit++;
+                        bits &= ~(1 << bit);
+                        svga->changedvram[(c << 5) + bit] = changeframecount;
+                }
+        }
+}
+
+/*Drop all direct LFB mappings from the TLB. Needed whenever a plain store would
+  no longer do the same as svga_write*_linear()*/
+static void svga_lfb_tlb_flush(svga_t *svga) {
+        if (!svga->lfb_tlb_active)
+                return;
+
+        svga_lfb_tlb_mark_changed(svga);
+        memset(svga->lfb_tlb_map, 0, LFB_TLB_MAP_WORDS(svga) * 4);
+        mem_flush_write_host_range(svga->vram, svga->lfb_tlb_vram_size);
+        svga->lfb_tlb_active = 0;
+}
+
+/*Called at vsync. Pages written directly since the last vsync are marked
+  changed, then the map is rebuilt from the pages still in the TLB*/
+static void svga_lfb_tlb_vsync(svga_t *svga) {
+        int c;
+
+        if (!svga->lfb_tlb_active)
+                return;
+        if (!svga_lfb_direct_allowed(svga)) {
+                svga_lfb_tlb_flush(svga);
+                return;
+        }
+
+        svga_lfb_tlb_mark_changed(svga);
+        memset(svga->lfb_tlb_map, 0, LFB_TLB_MAP_WORDS(svga) * 4);
+        svga->lfb_tlb_active = 0;
+        for (c = 0; c < 256; c++) {
+                if (writelookup[c] != 0xffffffff && writelookup2[writelookup[c]] != -1) {
+                        uintptr_t offset = (writelookup2[writelookup[c]] + ((uintptr_t)writelookup[c] << 12)) - (uintptr_t)svga->vram;
+
+                        if (offset < svga->lfb_tlb_vram_size) {
+                                svga->lfb_tlb_map[offset >> 17] |= 1 << ((offset >> 12) & 31);
+                                svga->lfb_tlb_active = 1;
+                        }
+                }
+        }
+}
+
+/*Expose the 4kB page containing addr to the TLB, if this write came straight
+  from the CPU to this card's linear framebuffer*/
+static void svga_lfb_tlb_add(svga_t *svga, uint32_t addr) {
+        mem_mapping_t *map;
+        uint32_t vram_addr;
+
+        if (!svga_lfb_direct || mem_logical_addr == 0xffffffff || !svga_lfb_direct_allowed(svga))
+                return;
+
+        map = mem_get_write_mapping(addr);
+        if (!map || map->p != svga || map->write_b != svga_write_linear || map->write_w != svga_writew_linear ||
+            map->write_l != svga_writel_linear)
+                return;
+
+        if (((addr & svga->decode_mask) | 0xfff) >= svga->vram_max)
+                return;
+        vram_addr = addr & svga->decode_mask & svga->vram_mask & ~0xfff;
+
+        if (!svga->lfb_tlb_map) {
+                svga->lfb_tlb_map = malloc(LFB_TLB_MAP_WORDS(svga) * 4);
+                memset(svga->lfb_tlb_map, 0, LFB_TLB_MAP_WORDS(svga) * 4);
+        }
+        svga->lfb_tlb_map[vram_addr >> 17] |= 1 << ((vram_addr >> 12) & 31);
+        svga->lfb_tlb_active = 1;
+
+        addwritelookup_ptr(mem_logical_addr, addr, &svga->vram[vram_addr]);
+}
+
 void svga_out(uint16_t addr, uint8_t val, void *p) {
         svga_t *svga = (svga_t *)p;
         int c;
@@ -44,6 +141,11 @@ void svga_out(uint16_t addr, uint8_t val, void *p) {
                                 svga_recalctimings(svga);
                         }
                 } else {
+                        /*Mode control and plane mask are read as lines are drawn,
+                          so draw any lines recorded under the old values first*/
+                        if (svga->compose && (svga->attraddr == 0x10 || svga->attraddr == 0x12) &&
+                            svga->attrregs[svga->attraddr] != val)
+                                svga_compose_flush(svga->compose);
                         if ((svga->attraddr == 0x13) && (svga->attrregs[0x13] != val))
                                 svga->fullchange = changeframecount;
                         svga->attrregs[svga->attraddr & 31] = val;
@@ -82,6 +184,9 @@ void svga_out(uint16_t addr, uint8_t val, void *p) {
         case 0x3C5:
                 if (svga->seqaddr > 0xf)
                         return;
+                /*Likewise clocking mode and character map select*/
+                if (svga->compose && (svga->seqaddr == 1 || svga->seqaddr == 3) && svga->seqregs[svga->seqaddr] != val)
+                        svga_compose_flush(svga->compose);
                 o = svga->seqregs[svga->seqaddr & 0xf];
                 svga->seqregs[svga->seqaddr & 0xf] = val;
                 if (o != val && (svga->seqaddr & 0xf) == 1)
@@ -109,6 +214,8 @@ void svga_out(uint16_t addr, uint8_t val, void *p) {
                         svga->chain4 = val & 8;
                         svga->fast = (svga->gdcreg[8] == 0xff && !(svga->gdcreg[3] & 0x18) && !svga->gdcreg[1]) &&
                                      ((svga->chain4 && svga->packed_chain4) || svga->fb_only);
+                        if (!svga_lfb_direct_allowed(svga))
+                                svga_lfb_tlb_flush(svga);
                         break;
                 }
                 break;
@@ -201,6 +308,8 @@ void svga_out(uint16_t addr, uint8_t val, void *p) {
                 svga->gdcreg[svga->gdcaddr & 15] = val;
                 svga->fast = (svga->gdcreg[8] == 0xff && !(svga->gdcreg[3] & 0x18) && !svga->gdcreg[1]) &&
                              ((svga->chain4 && svga->packed_chain4) || svga->fb_only);
+                if (!svga_lfb_direct_allowed(svga))
+                        svga_lfb_tlb_flush(svga);
                 if (((svga->gdcaddr & 15) == 5 && (val ^ o) & 0x70) || ((svga->gdcaddr & 15) == 6 && (val ^ o) & 1))
                         svga_recalctimings(svga);
                 break;
@@ -292,6 +401,14 @@ void svga_recalctimings(svga_t *svga) {
         double crtcconst;
         double _dispontime, _dispofftime, disptime;
 
+        if (svga->compose)
+                svga_compose_flush(svga->compose);
+
+        /*Cards can change packed/framebuffer-only state without going through
+          the GDC, but will normally recalculate timings when they do*/
+        if (!svga_lfb_direct_allowed(svga))
+                svga_lfb_tlb_flush(svga);
+
         svga->vtotal = svga->crtc[6];
         svga->dispend = svga->crtc[0x12];
         svga->vsyncstart = svga->crtc[0x10];
@@ -508,11 +625,13 @@ void svga_poll(void *p) {
                                 svga->changedvram[svga->ma >> 12] = svga->changedvram[(svga->ma >> 12) + 1] =
                                         svga->interlace ? 3 : 2;
 
-                        if (!svga->override)
-                                svga->render(svga);
+                        if (!svga->override && !svga->frameskip) {
+                                if (svga->hwcursor_on || svga->overlay_on || !svga->compose || !svga_compose_line(svga->compose))
+                                        svga->render(svga);
+                        }
 
                         if (svga->overlay_on) {
-                                if (!svga->override)
+                                if (!svga->override && !svga->frameskip)
                                         svga->overlay_draw(svga, svga->displine);
                                 svga->overlay_on--;
                                 if (svga->overlay_on && svga->interlace)
@@ -520,7 +639,7 @@ void svga_poll(void *p) {
                         }
 
                         if (svga->hwcursor_on) {
-                                if (!svga->override)
+                                if (!svga->override && !svga->frameskip)
                                         svga->hwcursor_draw(svga, svga->displine);
                                 svga->hwcursor_on--;
                                 if (svga->hwcursor_on && svga->interlace)
@@ -615,7 +734,10 @@ void svga_poll(void *p) {
                                 svga->fullchange = 2;
                         svga->blink++;
 
-                        for (x = 0; x < ((svga->vram_mask + 1) >> 12); x++) {
+                        svga_lfb_tlb_vsync(svga);
+                        /*Keep changes made during a skipped frame until they
+                          have been drawn*/
+                        for (x = 0; x < ((svga->vram_mask + 1) >> 12) && !svga->frameskip; x++) {
                                 if (svga->changedvram[x])
                                 {
                                         svga->changedvram[x]--;
@@ -623,7 +745,7 @@ void svga_poll(void *p) {
                                 }
                         }
                         //                        memset(changedvram,0,2048);
-                        if (svga->fullchange) {
+                        if (svga->fullchange && !svga->frameskip) {
                                 svga->fullchange--;
                                 viewer_update(&viewer_palette, svga);
                                 viewer_update(&viewer_palette_16, svga);
@@ -648,8 +770,11 @@ void svga_poll(void *p) {
                         wx = x;
                         wy = svga->lastline - svga->firstline;
 
-                        if (!svga->override)
+                        if (svga->compose)
+                                svga_compose_flush(svga->compose);
+                        if (!svga->override && !svga->frameskip)
                                 svga_doblit(svga->firstline_draw, svga->lastline_draw + 1, wx, wy, svga);
+                        svga->frameskip = !svga->override && video_frameskip(&svga->frameskip_count);
 
                         readflash = 0;
 
@@ -770,6 +895,7 @@ int svga_init(svga_t *svga, void *p, int memsize, void (*recalctimings_ex)(struc
         svga->dispofftime = 1000ull << 32;
         svga->bpp = 8;
         svga->vram = malloc(memsize);
+        svga->lfb_tlb_vram_size = memsize;
         svga->vram_max = memsize;
         svga->vram_display_mask = memsize - 1;
         svga->vram_mask = memsize - 1;
@@ -798,10 +924,16 @@ int svga_init(svga_t *svga, void *p, int memsize, void (*recalctimings_ex)(struc
         viewer_add("Font", &viewer_font, svga);
         viewer_add("Video memory", &viewer_vram, svga);
 
+        svga->compose = svga_compose_init(svga, svga_compose_threads);
+
         return 0;
 }
 
 void svga_close(svga_t *svga) {
+        if (svga->compose)
+                svga_compose_close(svga->compose);
+        svga_lfb_tlb_flush(svga);
+        free(svga->lfb_tlb_map);
         free(svga->changedvram);
         free(svga->vram);
 
@@ -1138,6 +1270,7 @@ void svga_write_linear(uint32_t addr, uint8_t val, void *p) {
         svga_t *svga = (svga_t *)p;
         uint8_t vala, valb, valc, vald, wm = svga->writemask;
         int writemask2 = svga->writemask;
+        uint32_t orig_addr = addr;
 
         cycles -= video_timing_write_b;
         cycles_lost += video_timing_write_b;
@@ -1170,6 +1303,7 @@ void svga_write_linear(uint32_t addr, uint8_t val, void *p) {
         if (svga_output)
                 pclog("%08X\n", addr);
         svga->changedvram[addr >> 12] = changeframecount;
+        svga_lfb_tlb_add(svga, orig_addr);
 
         switch (svga->writemode) {
         case 1:
@@ -1586,6 +1720,7 @@ void svga_writew_linear(uint32_t addr, uint16_t val, void *p) {
 
         if (svga_output)
                 pclog("Write LFBw %08X %04X\n", addr, val);
+        svga_lfb_tlb_add(svga, addr);
         addr &= svga->decode_mask;
         if (addr >= svga->vram_max)
                 return;
@@ -1612,6 +1747,7 @@ void svga_writel_linear(uint32_t addr, uint32_t val, void *p) {
 
         if (svga_output)
                 pclog("Write LFBl %08X %08X\n", addr, val);
+        svga_lfb_tlb_add(svga, addr);
         addr &= svga->decode_mask;
         if (addr >= svga->vram_max)
                 return;
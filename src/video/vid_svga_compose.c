@@ -0,0 +1,245 @@
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "mem.h"
+#include "thread.h"
+#include "video.h"
+#include "vid_svga.h"
+#include "vid_svga_compose.h"
+#include "vid_svga_render.h"
+
+int svga_compose_threads = 0;
+
+enum {
+        COMPOSE_INLINE = 0, /*Render function isn't known to be safe to defer*/
+        COMPOSE_DIRECT,
+        COMPOSE_PALETTE /*Also reads pallook[] and egapal[]*/
+};
+
+/*Render functions that only read the svga_t fields the composer restores or
+  keeps constant between svga_recalctimings() calls*/
+static const struct {
+        void (*render)(svga_t *svga);
+        int type;
+} svga_compose_renderers[] = {
+        {svga_render_null, COMPOSE_DIRECT},
+        {svga_render_blank, COMPOSE_DIRECT},
+        {svga_render_text_40, COMPOSE_PALETTE},
+        {svga_render_text_80, COMPOSE_PALETTE},
+        {svga_render_2bpp_lowres, COMPOSE_PALETTE},
+        {svga_render_2bpp_highres, COMPOSE_PALETTE},
+        {svga_render_4bpp_lowres, COMPOSE_PALETTE},
+        {svga_render_4bpp_highres, COMPOSE_PALETTE},
+        {svga_render_8bpp_lowres, COMPOSE_PALETTE},
+        {svga_render_8bpp_highres, COMPOSE_PALETTE},
+        {svga_render_15bpp_lowres, COMPOSE_DIRECT},
+        {svga_render_15bpp_highres, COMPOSE_DIRECT},
+        {svga_render_16bpp_lowres, COMPOSE_DIRECT},
+        {svga_render_16bpp_highres, COMPOSE_DIRECT},
+        {svga_render_24bpp_lowres, COMPOSE_DIRECT},
+        {svga_render_24bpp_highres, COMPOSE_DIRECT},
+        {svga_render_32bpp_lowres, COMPOSE_DIRECT},
+        {svga_render_32bpp_highres, COMPOSE_DIRECT},
+        {svga_render_ABGR8888_highres, COMPOSE_DIRECT},
+        {svga_render_RGBA8888_highres, COMPOSE_DIRECT},
+};
+
+static int svga_compose_type(svga_compose_t *compose, void (*render)(svga_t *svga)) {
+        int c;
+
+        if (render == compose->last_render)
+                return compose->last_type;
+
+        compose->last_render = render;
+        compose->last_type = COMPOSE_INLINE;
+        for (c = 0; c < sizeof(svga_compose_renderers) / sizeof(svga_compose_renderers[0]); c++) {
+                if (svga_compose_renderers[c].render == render) {
+                        compose->last_type = svga_compose_renderers[c].type;
+                        break;
+                }
+        }
+
+        return compose->last_type;
+}
+
+static void svga_compose_render(svga_compose_t *compose, svga_t *svga, int start, int end) {
+        int palette = -1;
+        int c;
+
+        svga->firstline_draw = 2000;
+        svga->lastline_draw = 0;
+
+        for (c = start; c < end; c++) {
+                svga_compose_line_t *line = &compose->lines[c];
+
+                if (line->palette != -1 && line->palette != palette) {
+                        palette = line->palette;
+                        memcpy(svga->pallook, compose->palettes[palette].pallook, sizeof(compose->palettes[palette].pallook));
+                        memcpy(svga->egapal, compose->palettes[palette].egapal, sizeof(svga->egapal));
+                }
+
+                svga->ma = line->ma;
+                svga->ca = line->ca;
+                svga->displine = line->displine;
+                svga->sc = line->sc;
+                svga->con = line->con;
+                svga->cursoron = line->cursoron;
+                svga->blink = line->blink;
+                svga->scrollcache = line->scrollcache;
+                svga->hdisp = line->hdisp;
+                svga->fullchange = line->fullchange;
+
+                line->render(svga);
+        }
+}
+
+static void svga_compose_thread(void *param) {
+        svga_compose_worker_t *worker = (svga_compose_worker_t *)param;
+
+        while (1) {
+                while (!__atomic_load_n(&worker->busy, __ATOMIC_ACQUIRE))
+                        thread_wait_event(worker->wake_event, 1);
+                thread_reset_event(worker->wake_event);
+
+                svga_compose_render(worker->compose, worker->svga, worker->start, worker->end);
+
+                __atomic_store_n(&worker->busy, 0, __ATOMIC_RELEASE);
+                thread_set_event(worker->done_event);
+        }
+}
+
+int svga_compose_line(svga_compose_t *compose) {
+        svga_t *svga = compose->svga;
+        svga_compose_line_t *line;
+        int type = svga_compose_type(compose, svga->render);
+        int palette = -1;
+
+        if (type == COMPOSE_INLINE)
+                return 0;
+
+        if (compose->nr_lines == SVGA_COMPOSE_MAX_LINES)
+                svga_compose_flush(compose);
+
+        if (type == COMPOSE_PALETTE) {
+                svga_compose_palette_t *last = compose->nr_palettes ? &compose->palettes[compose->nr_palettes - 1] : NULL;
+
+                if (!last || memcmp(last->pallook, svga->pallook, sizeof(last->pallook)) ||
+                    memcmp(last->egapal, svga->egapal, sizeof(last->egapal))) {
+                        if (compose->nr_palettes == SVGA_COMPOSE_MAX_PALETTES)
+                                svga_compose_flush(compose);
+
+                        last = &compose->palettes[compose->nr_palettes++];
+                        memcpy(last->pallook, svga->pallook, sizeof(last->pallook));
+                        memcpy(last->egapal, svga->egapal, sizeof(last->egapal));
+                }
+                palette = compose->nr_palettes - 1;
+        }
+
+        line = &compose->lines[compose->nr_lines++];
+        line->render = svga->render;
+        line->ma = svga->ma;
+        line->ca = svga->ca;
+        line->displine = svga->displine;
+        line->sc = svga->sc;
+        line->con = svga->con;
+        line->cursoron = svga->cursoron;
+        line->blink = svga->blink;
+        line->scrollcache = svga->scrollcache;
+        line->hdisp = svga->hdisp;
+        line->fullchange = svga->fullchange;
+        line->palette = palette;
+
+        return 1;
+}
+
+void svga_compose_flush(svga_compose_t *compose) {
+        svga_t *svga = compose->svga;
+        int nr_workers = compose->nr_threads + 1;
+        int c;
+
+        if (!compose->nr_lines)
+                return;
+
+        if (compose->nr_lines < SVGA_COMPOSE_MIN_SPLIT)
+                nr_workers = 1;
+
+        for (c = 0; c < nr_workers; c++) {
+                svga_compose_worker_t *worker = &compose->workers[c];
+
+                memcpy(worker->svga, svga, sizeof(svga_t));
+                worker->start = (compose->nr_lines * c) / nr_workers;
+                worker->end = (compose->nr_lines * (c + 1)) / nr_workers;
+                if (c) {
+                        thread_reset_event(worker->done_event);
+                        __atomic_store_n(&worker->busy, 1, __ATOMIC_RELEASE);
+                        thread_set_event(worker->wake_event);
+                }
+        }
+
+        svga_compose_render(compose, compose->workers[0].svga, compose->workers[0].start, compose->workers[0].end);
+
+        for (c = 0; c < nr_workers; c++) {
+                svga_compose_worker_t *worker = &compose->workers[c];
+
+                if (c) {
+                        while (__atomic_load_n(&worker->busy, __ATOMIC_ACQUIRE))
+                                thread_wait_event(worker->done_event, 1);
+                }
+
+                if (worker->svga->firstline_draw != 2000) {
+                        if (svga->firstline_draw > worker->svga->firstline_draw)
+                                svga->firstline_draw = worker->svga->firstline_draw;
+                        if (svga->lastline_draw < worker->svga->lastline_draw)
+                                svga->lastline_draw = worker->svga->lastline_draw;
+                }
+        }
+
+        compose->nr_lines = 0;
+        compose->nr_palettes = 0;
+}
+
+svga_compose_t *svga_compose_init(svga_t *svga, int nr_threads) {
+        svga_compose_t *compose;
+        int c;
+
+        if (!nr_threads)
+                return NULL;
+        if (nr_threads > SVGA_COMPOSE_MAX_THREADS)
+                nr_threads = SVGA_COMPOSE_MAX_THREADS;
+
+        compose = malloc(sizeof(svga_compose_t));
+        memset(compose, 0, sizeof(svga_compose_t));
+        compose->svga = svga;
+        compose->nr_threads = nr_threads;
+
+        for (c = 0; c < nr_threads + 1; c++) {
+                svga_compose_worker_t *worker = &compose->workers[c];
+
+                worker->compose = compose;
+                worker->svga = malloc(sizeof(svga_t));
+                if (c) {
+                        worker->wake_event = thread_create_event();
+                        worker->done_event = thread_create_event();
+                        worker->thread = thread_create(svga_compose_thread, worker);
+                }
+        }
+
+        return compose;
+}
+
+void svga_compose_close(svga_compose_t *compose) {
+        int c;
+
+        for (c = 0; c < compose->nr_threads + 1; c++) {
+                svga_compose_worker_t *worker = &compose->workers[c];
+
+                if (c) {
+                        thread_kill(worker->thread);
+                        thread_destroy_event(worker->wake_event);
+                        thread_destroy_event(worker->done_event);
+                }
+                free(worker->svga);
+        }
+
+        free(compose);
+}
@@ -5,6 +5,7 @@
 #include "device.h"
 #include "mem.h"
 #include "pci.h"
+#include "telemetry.h"
 #include "thread.h"
 #include "timer.h"
 #include "video.h"
@@ -19,7 +20,9 @@
 #include "vid_voodoo_reg.h"
 #include "vid_voodoo_regs.h"
 #include "vid_voodoo_render.h"
+#include "vid_voodoo_scanout.h"
 #include "vid_voodoo_texture.h"
+#include "vid_voodoo_trace.h"
 #include "viewer.h"
 
 rgba8_t rgb332[0x100], ai44[0x100], rgb565[0x10000], argb1555[0x10000], argb4444[0x10000], ai88[0x10000];
@@ -123,6 +126,7 @@ static uint16_t voodoo_readw(uint32_t addr, void *p) {
                                 voodoo = set->voodoos[0];
                 }
 
+                voodoo_lfb_span_commit(voodoo);
                 voodoo->flush = 1;
                 while (!FIFO_EMPTY) {
                         voodoo_wake_fifo_thread_now(voodoo);
@@ -160,6 +164,7 @@ static uint32_t voodoo_readl(uint32_t addr, void *p) {
                                 voodoo = set->voodoos[0];
                 }
 
+                voodoo_lfb_span_commit(voodoo);
                 voodoo->flush = 1;
                 while (!FIFO_EMPTY) {
                         voodoo_wake_fifo_thread_now(voodoo);
@@ -348,6 +353,8 @@ static uint32_t voodoo_readl(uint32_t addr, void *p) {
 static void voodoo_writew(uint32_t addr, uint16_t val, void *p) {
         voodoo_t *voodoo = (voodoo_t *)p;
         voodoo->wr_count++;
+        if (voodoo->set->trace)
+                voodoo_trace_writew(voodoo, addr, val);
         addr &= 0xffffff;
 
         cycles -= voodoo->write_time;
@@ -360,6 +367,8 @@ static void voodoo_writel(uint32_t addr, uint32_t val, void *p) {
         voodoo_t *voodoo = (voodoo_t *)p;
 
         voodoo->wr_count++;
+        if (voodoo->set->trace)
+                voodoo_trace_writel(voodoo, addr, val);
 
         addr &= 0xffffff;
 
@@ -369,13 +378,17 @@ static void voodoo_writel(uint32_t addr, uint32_t val, void *p) {
                 cycles -= voodoo->write_time;
         voodoo->last_write_addr = addr;
 
+        /*Register writes not queued still come after any combined LFB writes*/
+        if ((addr & 0xc00000) != 0x400000)
+                voodoo_lfb_span_commit(voodoo);
+
         if (addr & 0x800000) /*Texture*/
         {
                 voodoo->tex_count++;
                 voodoo_queue_command(voodoo, addr | FIFO_WRITEL_TEX, val);
         } else if (addr & 0x400000) /*Framebuffer*/
         {
-                voodoo_queue_command(voodoo, addr | FIFO_WRITEL_FB, val);
+                voodoo_queue_lfb_writel(voodoo, addr, val);
         } else if ((addr & 0x200000) && (voodoo->fbiInit7 & FBIINIT7_CMDFIFO_ENABLE)) {
                 //                pclog("Write CMDFIFO %08x(%08x) %08x  %08x\n", addr, voodoo->cmdfifo_base + (addr & 0x3fffc),
                 //                val, (voodoo->cmdfifo_base + (addr & 0x3fffc)) & voodoo->fb_mask);
@@ -454,6 +467,8 @@ static void voodoo_writel(uint32_t addr, uint32_t val, void *p) {
                         break;
                 case SST_fbiInit0:
                         if (voodoo->initEnable & 0x01) {
+                                /*Lines still queued are drawn as if in 3D mode*/
+                                voodoo_scanout_sync(voodoo);
                                 voodoo->fbiInit0 = val;
                                 if (voodoo->set->nr_cards == 2)
                                         svga_set_override(
@@ -779,6 +794,9 @@ void voodoo_pci_write(int func, int addr, uint8_t val, void *p) {
                 voodoo_recalcmapping(voodoo->set);
                 break;
         }
+
+        if (addr >= 0x40 && addr <= 0x43 && voodoo->set->trace)
+                voodoo_trace_init_enable(voodoo);
 }
 
 static void voodoo_add_status_info(char *s, int max_len, void *p) {
@@ -818,14 +836,14 @@ static void voodoo_add_status_info(char *s, int max_len, void *p) {
                             (voodoo->texel_count_old[0] + voodoo->texel_count_old[1] + voodoo->texel_count_old[2] +
                              voodoo->texel_count_old[3]);
         sprintf(temps,
-                "%f Mpixels/sec (%f)\n%f Mtexels/sec (%f)\n%f ktris/sec\n%f%% CPU (%f%% real)\n%d frames/sec (%i)\n%f%% CPU "
+                "%f Mpixels/sec (%f)\n%f Mtexels/sec (%f)\n%f ktris/sec\n%f%% CPU (%f%% real)\n%d frames/sec\n%f%% CPU "
                 "(%f%% real)\n" /*%d reads/sec\n%d write/sec\n%d tex/sec\n*/,
                 (double)pixel_count_total / 1000000.0,
                 ((double)pixel_count_total / 1000000.0) / ((double)render_time[0] / status_diff),
                 (double)texel_count_total / 1000000.0,
                 ((double)texel_count_total / 1000000.0) / ((double)render_time[0] / status_diff),
                 (double)voodoo->tri_count / 1000.0, ((double)voodoo->time * 100.0) / timer_freq,
-                ((double)voodoo->time * 100.0) / status_diff, voodoo->frame_count, voodoo_recomp,
+                ((double)voodoo->time * 100.0) / status_diff, voodoo->frame_count,
                 ((double)voodoo->render_time[0] * 100.0) / timer_freq, ((double)voodoo->render_time[0] * 100.0) / status_diff);
         if (voodoo->render_threads >= 2) {
                 sprintf(temps2, "%f%% CPU (%f%% real)\n", ((double)voodoo->render_time[1] * 100.0) / timer_freq,
@@ -859,6 +877,17 @@ static void voodoo_add_status_info(char *s, int max_len, void *p) {
                         strncat(temps, temps2, sizeof(temps) - 1);
                 }
         }
+        if (voodoo->use_recompiler) {
+                int hits = voodoo->codegen_hits;
+                int misses = voodoo->codegen_misses;
+
+                if (voodoo_set->nr_cards == 2) {
+                        hits += voodoo_slave->codegen_hits;
+                        misses += voodoo_slave->codegen_misses;
+                }
+                sprintf(temps2, "Pipeline cache: %i hits, %i misses\n", hits, misses);
+                strncat(temps, temps2, sizeof(temps) - strlen(temps) - 1);
+        }
         strncat(s, temps, max_len);
 
         for (c = 0; c < 4; c++) {
@@ -869,6 +898,7 @@ static void voodoo_add_status_info(char *s, int max_len, void *p) {
         voodoo->tri_count = voodoo->frame_count = 0;
         voodoo->rd_count = voodoo->wr_count = voodoo->tex_count = 0;
         voodoo->time = 0;
+        voodoo->codegen_hits = voodoo->codegen_misses = 0;
         if (voodoo_set->nr_cards == 2) {
                 for (c = 0; c < 4; c++) {
                         voodoo_slave->pixel_count_old[c] = pixel_count_current[c];
@@ -878,8 +908,8 @@ static void voodoo_add_status_info(char *s, int max_len, void *p) {
                 voodoo_slave->tri_count = voodoo_slave->frame_count = 0;
                 voodoo_slave->rd_count = voodoo_slave->wr_count = voodoo_slave->tex_count = 0;
                 voodoo_slave->time = 0;
+                voodoo_slave->codegen_hits = voodoo_slave->codegen_misses = 0;
         }
-        voodoo_recomp = 0;
 }
 
 static void voodoo_speed_changed(void *p) {
@@ -902,6 +932,25 @@ static void voodoo_speed_changed(void *p) {
         //        voodoo->burst_time, voodoo->fbiInit1, voodoo->fbiInit4);
 }
 
+static double voodoo_telemetry_fifo(void *p) {
+        voodoo_t *voodoo = (voodoo_t *)p;
+
+        return (double)FIFO_ENTRIES;
+}
+static double voodoo_telemetry_cmdfifo(void *p) {
+        voodoo_t *voodoo = (voodoo_t *)p;
+
+        return (double)(voodoo->cmdfifo_depth_wr - voodoo->cmdfifo_depth_rd);
+}
+static void voodoo_telemetry_add(voodoo_t *voodoo, const char *prefix) {
+        char name[64];
+
+        sprintf(name, "%s_fifo", prefix);
+        telemetry_add_gauge_func(name, voodoo_telemetry_fifo, voodoo);
+        sprintf(name, "%s_cmdfifo", prefix);
+        telemetry_add_gauge_func(name, voodoo_telemetry_cmdfifo, voodoo);
+}
+
 void *voodoo_card_init() {
         int c;
         voodoo_t *voodoo = malloc(sizeof(voodoo_t));
@@ -918,6 +967,7 @@ void *voodoo_card_init() {
         voodoo->odd_even_mask = voodoo->render_threads - 1;
 #ifndef NO_CODEGEN
         voodoo->use_recompiler = device_get_config_int("recompiler");
+        voodoo->codegen_cache_size = device_get_config_int("recompiler_cache");
 #endif
         voodoo->type = device_get_config_int("type");
         switch (voodoo->type) {
@@ -978,6 +1028,7 @@ void *voodoo_card_init() {
         voodoo->render_not_full_event[1] = thread_create_event();
         voodoo->render_not_full_event[2] = thread_create_event();
         voodoo->render_not_full_event[3] = thread_create_event();
+        voodoo->lfb_spans = malloc(sizeof(voodoo_lfb_span_t) * LFB_SPAN_SIZE);
         voodoo->fifo_thread = thread_create(voodoo_fifo_thread, voodoo);
         voodoo->render_thread[0] = thread_create(voodoo_render_thread_1, voodoo);
         if (voodoo->render_threads >= 2)
@@ -987,6 +1038,7 @@ void *voodoo_card_init() {
                 voodoo->render_thread[3] = thread_create(voodoo_render_thread_4, voodoo);
         }
         voodoo->swap_mutex = thread_create_mutex();
+        voodoo->scanout = voodoo_scanout_init(voodoo);
         timer_add(&voodoo->wake_timer, voodoo_wake_timer, (void *)voodoo, 0);
 
         for (c = 0; c < 0x100; c++) {
@@ -1058,6 +1110,7 @@ void *voodoo_2d3d_card_init(int type) {
         voodoo->odd_even_mask = voodoo->render_threads - 1;
 #ifndef NO_CODEGEN
         voodoo->use_recompiler = device_get_config_int("recompiler");
+        voodoo->codegen_cache_size = device_get_config_int("recompiler_cache");
 #endif
         voodoo->type = type;
         voodoo->dual_tmus = (type == VOODOO_3) ? 1 : 0;
@@ -1093,6 +1146,7 @@ void *voodoo_2d3d_card_init(int type) {
         voodoo->render_not_full_event[1] = thread_create_event();
         voodoo->render_not_full_event[2] = thread_create_event();
         voodoo->render_not_full_event[3] = thread_create_event();
+        voodoo->lfb_spans = malloc(sizeof(voodoo_lfb_span_t) * LFB_SPAN_SIZE);
         voodoo->fifo_thread = thread_create(voodoo_fifo_thread, voodoo);
         voodoo->render_thread[0] = thread_create(voodoo_render_thread_1, voodoo);
         if (voodoo->render_threads >= 2)
@@ -1159,6 +1213,8 @@ void *voodoo_2d3d_card_init(int type) {
 
         viewer_add("3DFX Voodoo render", &viewer_voodoo, voodoo);
 
+        voodoo_telemetry_add(voodoo, "voodoo");
+
         return voodoo;
 }
 
@@ -1173,10 +1229,12 @@ void *voodoo_init() {
         voodoo_set->nr_cards = device_get_config_int("sli") ? 2 : 1;
         voodoo_set->voodoos[0] = voodoo_card_init();
         voodoo_set->voodoos[0]->set = voodoo_set;
+        voodoo_telemetry_add(voodoo_set->voodoos[0], "voodoo");
         if (voodoo_set->nr_cards == 2) {
                 voodoo_set->voodoos[1] = voodoo_card_init();
 
                 voodoo_set->voodoos[1]->set = voodoo_set;
+                voodoo_telemetry_add(voodoo_set->voodoos[1], "voodoo_sli");
 
                 if (type == VOODOO_2) {
                         voodoo_set->voodoos[0]->fbiInit5 |= FBIINIT5_MULTI_CVG;
@@ -1214,6 +1272,8 @@ void *voodoo_init() {
 
         viewer_add("3DFX Voodoo render", &viewer_voodoo, voodoo_set->voodoos[0]);
 
+        voodoo_set->trace = voodoo_trace_open(voodoo_set);
+
         return voodoo_set;
 }
 
@@ -1226,16 +1286,24 @@ void voodoo_card_close(voodoo_t *voodoo) {
 #ifndef RELEASE_BUILD
         if (voodoo->tex_mem[0]) {
                 f = romfopen("texram.dmp", "wb");
-                fwrite(voodoo->tex_mem[0], voodoo->texture_size * 1024 * 1024, 1, f);
-                fclose(f);
+                if (f) {
+                        fwrite(voodoo->tex_mem[0], voodoo->texture_size * 1024 * 1024, 1, f);
+                        fclose(f);
+                }
                 if (voodoo->dual_tmus) {
                         f = romfopen("texram2.dmp", "wb");
-                        fwrite(voodoo->tex_mem[1], voodoo->texture_size * 1024 * 1024, 1, f);
-                        fclose(f);
+                        if (f) {
+                                fwrite(voodoo->tex_mem[1], voodoo->texture_size * 1024 * 1024, 1, f);
+                                fclose(f);
+                        }
                 }
         }
 #endif
 
+        telemetry_remove(voodoo);
+
+        if (voodoo->scanout)
+                voodoo_scanout_close(voodoo->scanout);
         thread_kill(voodoo->fifo_thread);
         thread_kill(voodoo->render_thread[0]);
         if (voodoo->render_threads >= 2)
@@ -1251,6 +1319,7 @@ void voodoo_card_close(voodoo_t *voodoo) {
         thread_destroy_event(voodoo->wake_render_thread[1]);
         thread_destroy_event(voodoo->render_not_full_event[0]);
         thread_destroy_event(voodoo->render_not_full_event[1]);
+        free(voodoo->lfb_spans);
 
         for (c = 0; c < TEX_CACHE_MAX; c++) {
                 if (voodoo->dual_tmus)
@@ -1272,6 +1341,8 @@ void voodoo_card_close(voodoo_t *voodoo) {
 void voodoo_close(void *p) {
         voodoo_set_t *voodoo_set = (voodoo_set_t *)p;
 
+        if (voodoo_set->trace)
+                voodoo_trace_close(voodoo_set->trace);
         if (voodoo_set->nr_cards == 2)
                 voodoo_card_close(voodoo_set->voodoos[1]);
         voodoo_card_close(voodoo_set->voodoos[0]);
@@ -1312,6 +1383,14 @@ static device_config_t voodoo_config[] = {
         {.name = "sli", .description = "SLI", .type = CONFIG_BINARY, .default_int = 0},
 #ifndef NO_CODEGEN
         {.name = "recompiler", .description = "Recompiler", .type = CONFIG_BINARY, .default_int = 1},
+        {.name = "recompiler_cache",
+         .description = "Recompiler cache size",
+         .type = CONFIG_SELECTION,
+         .selection = {{.description = "16 pipelines", .value = 16},
+                       {.description = "64 pipelines", .value = 64},
+                       {.description = "256 pipelines", .value = 256},
+                       {.description = ""}},
+         .default_int = 64},
 #endif
         {.type = -1}};
 
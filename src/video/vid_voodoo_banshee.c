@@ -1373,7 +1373,7 @@ static void banshee_reg_writel(uint32_t addr, uint32_t val, void *p) {
         case 0x1d00000:
         case 0x1e00000:
         case 0x1f00000:
-                voodoo_queue_command(voodoo, (addr & 0xfffffc) | FIFO_WRITEL_FB, val);
+                voodoo_queue_lfb_writel(voodoo, addr & 0xfffffc, val);
                 break;
         }
 }
@@ -2516,6 +2516,14 @@ static device_config_t banshee_sgram_config[] = {
          .default_int = 2},
 #ifndef NO_CODEGEN
         {.name = "recompiler", .description = "Recompiler", .type = CONFIG_BINARY, .default_int = 1},
+        {.name = "recompiler_cache",
+         .description = "Recompiler cache size",
+         .type = CONFIG_SELECTION,
+         .selection = {{.description = "16 pipelines", .value = 16},
+                       {.description = "64 pipelines", .value = 64},
+                       {.description = "256 pipelines", .value = 256},
+                       {.description = ""}},
+         .default_int = 64},
 #endif
         {.type = -1}};
 
@@ -2533,6 +2541,14 @@ static device_config_t banshee_sdram_config[] = {
          .default_int = 2},
 #ifndef NO_CODEGEN
         {.name = "recompiler", .description = "Recompiler", .type = CONFIG_BINARY, .default_int = 1},
+        {.name = "recompiler_cache",
+         .description = "Recompiler cache size",
+         .type = CONFIG_SELECTION,
+         .selection = {{.description = "16 pipelines", .value = 16},
+                       {.description = "64 pipelines", .value = 64},
+                       {.description = "256 pipelines", .value = 256},
+                       {.description = ""}},
+         .default_int = 64},
 #endif
         {.type = -1}};
 
@@ -2689,14 +2705,14 @@ static void banshee_add_status_info(char *s, int max_len, void *p) {
                             (voodoo->texel_count_old[0] + voodoo->texel_count_old[1] + voodoo->texel_count_old[2] +
                              voodoo->texel_count_old[3]);
         sprintf(temps,
-                "%f Mpixels/sec (%f)\n%f Mtexels/sec (%f)\n%f ktris/sec\n%f%% CPU (%f%% real)\n%d frames/sec (%i)\n%f%% CPU "
+                "%f Mpixels/sec (%f)\n%f Mtexels/sec (%f)\n%f ktris/sec\n%f%% CPU (%f%% real)\n%d frames/sec\n%f%% CPU "
                 "(%f%% real)\n" /*%d reads/sec\n%d write/sec\n%d tex/sec\n*/,
                 (double)pixel_count_total / 1000000.0,
                 ((double)pixel_count_total / 1000000.0) / ((double)render_time[0] / status_diff),
                 (double)texel_count_total / 1000000.0,
                 ((double)texel_count_total / 1000000.0) / ((double)render_time[0] / status_diff),
                 (double)voodoo->tri_count / 1000.0, ((double)voodoo->time * 100.0) / timer_freq,
-                ((double)voodoo->time * 100.0) / status_diff, voodoo->frame_count, voodoo_recomp,
+                ((double)voodoo->time * 100.0) / status_diff, voodoo->frame_count,
                 ((double)voodoo->render_time[0] * 100.0) / timer_freq, ((double)voodoo->render_time[0] * 100.0) / status_diff);
         if (voodoo->render_threads >= 2) {
                 char temps2[512];
@@ -2713,6 +2729,11 @@ static void banshee_add_status_info(char *s, int max_len, void *p) {
                         ((double)voodoo->render_time[3] * 100.0) / status_diff);
                 strncat(temps, temps2, sizeof(temps) - 1);
         }
+        if (voodoo->use_recompiler) {
+                char temps2[512];
+                sprintf(temps2, "Pipeline cache: %i hits, %i misses\n", voodoo->codegen_hits, voodoo->codegen_misses);
+                strncat(temps, temps2, sizeof(temps) - strlen(temps) - 1);
+        }
 
         strncat(s, temps, max_len);
 
@@ -2744,9 +2765,9 @@ static void banshee_add_status_info(char *s, int max_len, void *p) {
         voodoo->rd_count = voodoo->wr_count = voodoo->tex_count = 0;
         voodoo->time = 0;
 
-        voodoo->read_time = pci_nonburst_time + pci_burst_time;
+        voodoo->codegen_hits = voodoo->codegen_misses = 0;
 
-        voodoo_recomp = 0;
+        voodoo->read_time = pci_nonburst_time + pci_burst_time;
 }
 
 device_t voodoo_banshee_device = {"Voodoo Banshee PCI (reference)",
@@ -11,6 +11,10 @@
 */
 #include <math.h>
 #include <stddef.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "ibm.h"
 #include "device.h"
 #include "mem.h"
@@ -111,18 +115,8 @@ static int colorkey(voodoo_t *voodoo, uint32_t src, int src_notdst, int color_fo
         }
 }
 
-static uint32_t MIX(voodoo_t *voodoo, uint32_t dest, uint32_t src, uint32_t pattern, int colour_format_src,
-                    int colour_format_dest) {
-        int rop_nr = 0;
+static uint32_t banshee_rop(uint8_t rop, uint32_t dest, uint32_t src, uint32_t pattern) {
         uint32_t result = 0;
-        uint32_t rop;
-
-        if (colorkey(voodoo, src, 1, colour_format_src))
-                rop_nr |= 2;
-        if (colorkey(voodoo, dest, 0, colour_format_dest))
-                rop_nr |= 1;
-
-        rop = voodoo->banshee_blt.rops[rop_nr];
 
         if (rop & 0x01)
                 result |= (~pattern & ~src & ~dest);
@@ -144,6 +138,18 @@ static uint32_t MIX(voodoo_t *voodoo, uint32_t dest, uint32_t src, uint32_t patt
         return result;
 }
 
+static uint32_t MIX(voodoo_t *voodoo, uint32_t dest, uint32_t src, uint32_t pattern, int colour_format_src,
+                    int colour_format_dest) {
+        int rop_nr = 0;
+
+        if (colorkey(voodoo, src, 1, colour_format_src))
+                rop_nr |= 2;
+        if (colorkey(voodoo, dest, 0, colour_format_dest))
+                rop_nr |= 1;
+
+        return banshee_rop(voodoo->banshee_blt.rops[rop_nr], dest, src, pattern);
+}
+
 static uint32_t get_addr(voodoo_t *voodoo, int x, int y, int src_notdst, uint32_t src_stride) {
         uint32_t stride = src_notdst ? src_stride : voodoo->banshee_blt.dst_stride;
         uint32_t base_addr = src_notdst ? voodoo->banshee_blt.srcBaseAddr : voodoo->banshee_blt.dstBaseAddr;
@@ -345,6 +351,425 @@ static void end_command(voodoo_t *voodoo) {
         }
 }
 
+/*Fast paths for the common 2D operations - solid and pattern fills, SRCCOPY
+  blits, source colour keyed blits and mono expansion (text). None of these read
+  the destination (other than to leave colour keyed pixels alone), so a whole
+  row can be drawn a run of contiguous VRAM at a time instead of going through
+  PLOT() and MIX() per pixel. The fast path is chosen when a command starts
+  drawing a row, and anything it can't handle - 24 bpp destinations, ROPs that
+  read the destination, destination colour keys, transparent mono patterns,
+  source and destination overlapping in the wrong direction - falls back to the
+  per-pixel code*/
+enum {
+        FAST_PATH_NONE = 0,
+        FAST_PATH_FILL,          /*Rectangle fill with a ROP that doesn't read the destination*/
+        FAST_PATH_COPY,          /*SRCCOPY, source and destination in the same format*/
+        FAST_PATH_COPY_COLORKEY, /*As FAST_PATH_COPY, source colour keyed pixels not drawn*/
+        FAST_PATH_MONO           /*SRCCOPY from a 1 bpp source*/
+};
+
+#define ROP_USES_DEST(rop) ((((rop) >> 1) ^ (rop)) & 0x55)
+
+#define ROP_DSTCOPY 0xaa
+#define ROP_SRCCOPY 0xcc
+
+typedef struct banshee_span_t {
+        int op;
+        int bpp;
+        int solid;
+        uint32_t fill[8]; /*Result for each pattern column, for FAST_PATH_FILL*/
+        int pat_x;
+        uint8_t *src; /*First source pixel, or for FAST_PATH_MONO the source row*/
+        int src_x;    /*First source pixel, for FAST_PATH_MONO*/
+        int src_tiled;
+} banshee_span_t;
+
+/*Destination bytes per pixel, 0 for formats the fast paths don't handle*/
+static int banshee_fast_bpp(voodoo_t *voodoo) {
+        switch (voodoo->banshee_blt.dstFormat & DST_FORMAT_COL_MASK) {
+        case DST_FORMAT_COL_8_BPP:
+                return 1;
+        case DST_FORMAT_COL_16_BPP:
+                return 2;
+        case DST_FORMAT_COL_32_BPP:
+                return 4;
+        default:
+                return 0;
+        }
+}
+
+static int banshee_get_fast_path(voodoo_t *voodoo, int rectfill) {
+        uint32_t command = voodoo->banshee_blt.command;
+        uint32_t commandExtra = voodoo->banshee_blt.commandExtra;
+        uint32_t src_format = voodoo->banshee_blt.srcFormat & SRC_FORMAT_COL_MASK;
+
+        if (!banshee_fast_bpp(voodoo) || (commandExtra & CMDEXTRA_DST_COLORKEY))
+                return FAST_PATH_NONE;
+        if ((command & (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO)) == (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO))
+                return FAST_PATH_NONE;
+
+        if (rectfill) {
+                if ((commandExtra & CMDEXTRA_SRC_COLORKEY) || ROP_USES_DEST(voodoo->banshee_blt.rops[0]))
+                        return FAST_PATH_NONE;
+                return FAST_PATH_FILL;
+        }
+
+        if (voodoo->banshee_blt.rops[0] != ROP_SRCCOPY)
+                return FAST_PATH_NONE;
+        if (src_format == SRC_FORMAT_COL_1_BPP)
+                return (commandExtra & CMDEXTRA_SRC_COLORKEY) ? FAST_PATH_NONE : FAST_PATH_MONO;
+        if (src_format != (voodoo->banshee_blt.dstFormat & DST_FORMAT_COL_MASK))
+                return FAST_PATH_NONE;
+        if (!(commandExtra & CMDEXTRA_SRC_COLORKEY))
+                return FAST_PATH_COPY;
+        if (voodoo->banshee_blt.rops[2] == ROP_DSTCOPY)
+                return FAST_PATH_COPY_COLORKEY;
+        return FAST_PATH_NONE;
+}
+
+static void banshee_fill_run(uint8_t *p, banshee_span_t *span, int pat_x, int count) {
+        int c;
+
+        switch (span->bpp) {
+        case 1:
+                if (span->solid)
+                        memset(p, span->fill[0], count);
+                else {
+                        for (c = 0; c < count; c++)
+                                p[c] = span->fill[(pat_x + c) & 7];
+                }
+                break;
+        case 2: {
+                uint16_t *p16 = (uint16_t *)p;
+
+                if (span->solid) {
+                        uint16_t fill = span->fill[0];
+
+                        for (c = 0; c < count; c++)
+                                p16[c] = fill;
+                } else {
+                        for (c = 0; c < count; c++)
+                                p16[c] = span->fill[(pat_x + c) & 7];
+                }
+                break;
+        }
+        case 4: {
+                uint32_t *p32 = (uint32_t *)p;
+
+                if (span->solid) {
+                        uint32_t fill = span->fill[0];
+
+                        for (c = 0; c < count; c++)
+                                p32[c] = fill;
+                } else {
+                        for (c = 0; c < count; c++)
+                                p32[c] = span->fill[(pat_x + c) & 7];
+                }
+                break;
+        }
+        }
+}
+
+/*Copy src to dst, leaving pixels where src matches the source colour key*/
+static void banshee_colorkey_run(voodoo_t *voodoo, uint8_t *dst, const uint8_t *src, int bpp, int count) {
+        int bytes = count * bpp;
+        int c = 0;
+#if defined(__SSE2__)
+        uint32_t min = voodoo->banshee_blt.srcColorkeyMin;
+        uint32_t max = voodoo->banshee_blt.srcColorkeyMax;
+
+        switch (bpp) {
+        case 1:
+        case 4: {
+                __m128i key_min = (bpp == 1) ? _mm_set1_epi8(min) : _mm_set1_epi32(min);
+                __m128i key_max = (bpp == 1) ? _mm_set1_epi8(max) : _mm_set1_epi32(max);
+                __m128i rgb_mask = _mm_set1_epi32(0xffffff);
+
+                for (; c + 16 <= bytes; c += 16) {
+                        __m128i s = _mm_loadu_si128((const __m128i *)&src[c]);
+                        __m128i d = _mm_loadu_si128((const __m128i *)&dst[c]);
+                        __m128i keyed = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(s, key_min), s),
+                                                      _mm_cmpeq_epi8(_mm_min_epu8(s, key_max), s));
+
+                        /*Every colour channel of a 32 bpp pixel has to be in range*/
+                        if (bpp == 4)
+                                keyed = _mm_cmpeq_epi32(_mm_and_si128(keyed, rgb_mask), rgb_mask);
+                        _mm_storeu_si128((__m128i *)&dst[c], _mm_or_si128(_mm_andnot_si128(keyed, s), _mm_and_si128(keyed, d)));
+                }
+                break;
+        }
+        case 2: {
+                __m128i r_min = _mm_set1_epi16((min >> 11) & 0x1f), r_max = _mm_set1_epi16((max >> 11) & 0x1f);
+                __m128i g_min = _mm_set1_epi16((min >> 5) & 0x3f), g_max = _mm_set1_epi16((max >> 5) & 0x3f);
+                __m128i b_min = _mm_set1_epi16(min & 0x1f), b_max = _mm_set1_epi16(max & 0x1f);
+
+                for (; c + 16 <= bytes; c += 16) {
+                        __m128i s = _mm_loadu_si128((const __m128i *)&src[c]);
+                        __m128i d = _mm_loadu_si128((const __m128i *)&dst[c]);
+                        __m128i r = _mm_srli_epi16(s, 11);
+                        __m128i g = _mm_and_si128(_mm_srli_epi16(s, 5), _mm_set1_epi16(0x3f));
+                        __m128i b = _mm_and_si128(s, _mm_set1_epi16(0x1f));
+                        __m128i unkeyed = _mm_or_si128(_mm_cmpgt_epi16(r_min, r), _mm_cmpgt_epi16(r, r_max));
+
+                        unkeyed = _mm_or_si128(unkeyed, _mm_or_si128(_mm_cmpgt_epi16(g_min, g), _mm_cmpgt_epi16(g, g_max)));
+                        unkeyed = _mm_or_si128(unkeyed, _mm_or_si128(_mm_cmpgt_epi16(b_min, b), _mm_cmpgt_epi16(b, b_max)));
+                        _mm_storeu_si128((__m128i *)&dst[c], _mm_or_si128(_mm_and_si128(unkeyed, s), _mm_andnot_si128(unkeyed, d)));
+                }
+                break;
+        }
+        }
+#endif
+
+        switch (bpp) {
+        case 1:
+                for (; c < bytes; c++) {
+                        if (!colorkey(voodoo, src[c], 1, COLORKEY_8))
+                                dst[c] = src[c];
+                }
+                break;
+        case 2:
+                for (; c < bytes; c += 2) {
+                        uint16_t src_data = *(uint16_t *)&src[c];
+
+                        if (!colorkey(voodoo, src_data, 1, COLORKEY_16))
+                                *(uint16_t *)&dst[c] = src_data;
+                }
+                break;
+        case 4:
+                for (; c < bytes; c += 4) {
+                        uint32_t src_data = *(uint32_t *)&src[c];
+
+                        if (!colorkey(voodoo, src_data, 1, COLORKEY_32))
+                                *(uint32_t *)&dst[c] = src_data;
+                }
+                break;
+        }
+}
+
+/*Expand pixels i to i+count of a 1 bpp source span to colorFore/colorBack*/
+static void banshee_mono_run(voodoo_t *voodoo, uint8_t *dst, banshee_span_t *span, int i, int count) {
+        uint32_t fore = voodoo->banshee_blt.colorFore;
+        uint32_t back = voodoo->banshee_blt.colorBack;
+        int trans = voodoo->banshee_blt.command & COMMAND_TRANS_MONO;
+        int c;
+
+        for (c = 0; c < count; c++) {
+                int src_x = span->src_x + i + c;
+                int src_x_real = src_x >> 3;
+                int bit;
+
+                if (span->src_tiled)
+                        src_x_real = (src_x_real & 127) + ((src_x_real >> 7) * 128 * 32);
+                bit = span->src[src_x_real] & (0x80 >> (src_x & 7));
+
+                if (!bit && trans)
+                        continue;
+                switch (span->bpp) {
+                case 1:
+                        dst[c] = bit ? fore : back;
+                        break;
+                case 2:
+                        ((uint16_t *)dst)[c] = bit ? fore : back;
+                        break;
+                case 4:
+                        ((uint32_t *)dst)[c] = bit ? fore : back;
+                        break;
+                }
+        }
+}
+
+/*Draw count pixels of row y starting at x, one contiguous run of VRAM at a time.
+  With a tiled destination a run ends at each 128 byte tile boundary*/
+static void banshee_fast_span(voodoo_t *voodoo, banshee_span_t *span, int x, int y, int count) {
+        int bpp = span->bpp;
+        int i = 0;
+
+        while (i < count) {
+                uint32_t addr = get_addr(voodoo, (x + i) * bpp, y, 0, 0);
+                uint8_t *p = &voodoo->vram[addr];
+                int run = count - i;
+                uint32_t page;
+
+                if (voodoo->banshee_blt.dstBaseAddr_tiled)
+                        run = MIN(run, (128 - (((x + i) * bpp) & 127)) / bpp);
+
+                switch (span->op) {
+                case FAST_PATH_FILL:
+                        banshee_fill_run(p, span, span->pat_x + i, run);
+                        break;
+                case FAST_PATH_COPY:
+                        memmove(p, &span->src[i * bpp], run * bpp);
+                        break;
+                case FAST_PATH_COPY_COLORKEY:
+                        banshee_colorkey_run(voodoo, p, &span->src[i * bpp], bpp, run);
+                        break;
+                case FAST_PATH_MONO:
+                        banshee_mono_run(voodoo, p, span, i, run);
+                        break;
+                }
+
+                for (page = addr >> 12; page <= (addr + run * bpp - 1) >> 12; page++)
+                        voodoo->changedvram[page] = changeframecount;
+                i += run;
+        }
+}
+
+/*The span from x0 to x1 of row y must not wrap around the end of VRAM*/
+static int banshee_fast_dst_valid(voodoo_t *voodoo, int x0, int x1, int y, int bpp) {
+        uint32_t first = get_addr(voodoo, x0 * bpp, y, 0, 0);
+        uint32_t last = get_addr(voodoo, (x1 - 1) * bpp, y, 0, 0);
+
+        return first <= last && (last + bpp) <= (voodoo->fb_mask + 1);
+}
+
+static int banshee_fast_src_offset(int x, int bpp, int tiled) {
+        int offset = (x * bpp) >> 3;
+
+        if (tiled)
+                offset = (offset & 127) + ((offset >> 7) * 128 * 32);
+        return offset;
+}
+
+/*Copy a row of source pixels out of a possibly tiled surface*/
+static void banshee_fast_gather(uint8_t *dst, uint8_t *src_p, int offset, int bytes, int tiled) {
+        while (bytes) {
+                int run = tiled ? MIN(bytes, 128 - (offset & 127)) : bytes;
+
+                memcpy(dst, &src_p[tiled ? ((offset & 127) + ((offset >> 7) * 128 * 32)) : offset], run);
+                dst += run;
+                offset += run;
+                bytes -= run;
+        }
+}
+
+/*Fill the current rectfill row. Returns 0 if the row has to be drawn per pixel*/
+static int banshee_fast_fill_line(voodoo_t *voodoo, clip_t *clip, int dst_y, int pat_y) {
+        uint8_t *pattern_mono = (uint8_t *)voodoo->banshee_blt.colorPattern;
+        uint8_t pattern_mask = pattern_mono[pat_y & 7];
+        int bpp = banshee_fast_bpp(voodoo);
+        uint32_t bpp_mask = (bpp == 4) ? 0xffffffff : ((1 << (bpp * 8)) - 1);
+        uint32_t *colorPattern = (bpp == 1)   ? voodoo->banshee_blt.colorPattern8
+                                 : (bpp == 2) ? voodoo->banshee_blt.colorPattern16
+                                              : voodoo->banshee_blt.colorPattern;
+        int x0 = voodoo->banshee_blt.dstX;
+        int x1;
+        int c;
+
+        if (voodoo->banshee_blt.command & COMMAND_DX)
+                x0 -= voodoo->banshee_blt.dstSizeX - 1;
+        x1 = x0 + voodoo->banshee_blt.dstSizeX;
+        x0 = MAX(x0, clip->x_min);
+        x1 = MIN(x1, clip->x_max);
+
+        if (x1 > x0) {
+                banshee_span_t span;
+
+                if (!banshee_fast_dst_valid(voodoo, x0, x1, dst_y, bpp))
+                        return 0;
+
+                span.op = FAST_PATH_FILL;
+                span.bpp = bpp;
+                span.solid = 1;
+                span.pat_x = voodoo->banshee_blt.patoff_x + x0;
+                for (c = 0; c < 8; c++) {
+                        uint32_t pattern = (voodoo->banshee_blt.command & COMMAND_PATTERN_MONO)
+                                                   ? ((pattern_mask & (1 << (7 - c))) ? voodoo->banshee_blt.colorFore
+                                                                                      : voodoo->banshee_blt.colorBack)
+                                                   : colorPattern[c + (pat_y & 7) * 8];
+
+                        span.fill[c] = banshee_rop(voodoo->banshee_blt.rops[0], 0, voodoo->banshee_blt.colorFore, pattern) &
+                                       bpp_mask;
+                        if (span.fill[c] != span.fill[0])
+                                span.solid = 0;
+                }
+
+                banshee_fast_span(voodoo, &span, x0, dst_y, x1 - x0);
+        }
+
+        voodoo->banshee_blt.cur_x = voodoo->banshee_blt.dstSizeX;
+        return 1;
+}
+
+/*Copy the current row from src_p, as do_screen_to_screen_line() would. Returns 0
+  if the row has to be drawn per pixel*/
+static int banshee_fast_copy_line(voodoo_t *voodoo, int fast_path, clip_t *clip, uint8_t *src_p, int use_x_dir, int src_x,
+                                  int src_tiled) {
+        int bpp = banshee_fast_bpp(voodoo);
+        int x_dir = use_x_dir && (voodoo->banshee_blt.command & COMMAND_DX);
+        int dst_y = voodoo->banshee_blt.dstY;
+        int x0 = voodoo->banshee_blt.dstX;
+        int x1;
+
+        if (fast_path == FAST_PATH_NONE)
+                return 0;
+
+        if (x_dir) {
+                x0 -= voodoo->banshee_blt.dstSizeX - 1;
+                src_x -= voodoo->banshee_blt.dstSizeX - 1;
+        }
+        x1 = x0 + voodoo->banshee_blt.dstSizeX;
+        if (x0 < clip->x_min) {
+                src_x += clip->x_min - x0;
+                x0 = clip->x_min;
+        }
+        x1 = MIN(x1, clip->x_max);
+
+        if (x1 > x0) {
+                banshee_span_t span;
+                int count = x1 - x0;
+                int src_bpp = (fast_path == FAST_PATH_MONO) ? 1 : bpp * 8;
+                uint8_t *src_start, *src_end;
+                uint8_t *host_data = voodoo->banshee_blt.host_data;
+                int src_in_vram, overlap = 0;
+
+                if (src_x < 0 || !banshee_fast_dst_valid(voodoo, x0, x1, dst_y, bpp))
+                        return 0;
+
+                src_start = &src_p[banshee_fast_src_offset(src_x, src_bpp, src_tiled)];
+                src_end = &src_p[banshee_fast_src_offset(src_x + count - 1, src_bpp, src_tiled) + ((src_bpp + 7) >> 3)];
+                src_in_vram = (src_start >= voodoo->vram && src_end <= &voodoo->vram[voodoo->fb_mask + 1]);
+                if (!src_in_vram && !(src_start >= host_data && src_end <= &host_data[sizeof(voodoo->banshee_blt.host_data)]))
+                        return 0;
+
+                if (src_in_vram) {
+                        uint8_t *dst_start = &voodoo->vram[get_addr(voodoo, x0 * bpp, dst_y, 0, 0)];
+                        uint8_t *dst_end = &voodoo->vram[get_addr(voodoo, (x1 - 1) * bpp, dst_y, 0, 0) + bpp];
+
+                        overlap = (src_start < dst_end && dst_start < src_end);
+                }
+                if (overlap) {
+                        /*Only a copy within one row, in the direction that reads
+                          each source pixel before it is overwritten, gives the
+                          same result as reading the whole row first*/
+                        if (fast_path == FAST_PATH_MONO)
+                                return 0;
+                        if (src_p != &voodoo->vram[get_addr(voodoo, 0, dst_y, 0, 0)] ||
+                            !src_tiled != !voodoo->banshee_blt.dstBaseAddr_tiled)
+                                return 0;
+                        if (x_dir ? (x0 < src_x) : (x0 > src_x))
+                                return 0;
+                }
+
+                span.op = fast_path;
+                span.bpp = bpp;
+                if (fast_path == FAST_PATH_MONO) {
+                        span.src = src_p;
+                        span.src_x = src_x;
+                        span.src_tiled = src_tiled;
+                } else if (src_tiled ||
+                           (overlap && (fast_path == FAST_PATH_COPY_COLORKEY || voodoo->banshee_blt.dstBaseAddr_tiled))) {
+                        banshee_fast_gather(voodoo->banshee_blt.row_data, src_p, src_x * bpp, count * bpp, src_tiled);
+                        span.src = voodoo->banshee_blt.row_data;
+                } else
+                        span.src = &src_p[src_x * bpp];
+
+                banshee_fast_span(voodoo, &span, x0, dst_y, count);
+        }
+
+        voodoo->banshee_blt.cur_x = voodoo->banshee_blt.dstSizeX;
+        return 1;
+}
+
 static void banshee_do_rectfill(voodoo_t *voodoo) {
         clip_t *clip = &voodoo->banshee_blt.clip[(voodoo->banshee_blt.command & COMMAND_CLIP_SEL) ? 1 : 0];
         int dst_y = voodoo->banshee_blt.dstY;
@@ -355,6 +780,7 @@ static void banshee_do_rectfill(voodoo_t *voodoo) {
         int use_pattern_trans = (voodoo->banshee_blt.command & (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO)) ==
                                 (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO);
         uint8_t rop = voodoo->banshee_blt.command >> 24;
+        int fast_path = banshee_get_fast_path(voodoo, 1);
 
         //        pclog("banshee_do_rectfill: size=%i,%i  dst=%i,%i\n", voodoo->banshee_blt.dstSizeX,
         //        voodoo->banshee_blt.dstSizeY, voodoo->banshee_blt.dstX, voodoo->banshee_blt.dstY); pclog("clipping: %i,%i ->
@@ -364,7 +790,8 @@ static void banshee_do_rectfill(voodoo_t *voodoo) {
              voodoo->banshee_blt.cur_y++) {
                 int dst_x = voodoo->banshee_blt.dstX;
 
-                if (dst_y >= clip->y_min && dst_y < clip->y_max) {
+                if (dst_y >= clip->y_min && dst_y < clip->y_max &&
+                    !(fast_path && banshee_fast_fill_line(voodoo, clip, dst_y, pat_y))) {
                         int pat_x = voodoo->banshee_blt.patoff_x + voodoo->banshee_blt.dstX;
                         uint8_t pattern_mask = pattern_mono[pat_y & 7];
 
@@ -398,6 +825,7 @@ static void do_screen_to_screen_line(voodoo_t *voodoo, uint8_t *src_p, int use_x
         int use_pattern_trans = (voodoo->banshee_blt.command & (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO)) ==
                                 (COMMAND_PATTERN_MONO | COMMAND_TRANS_MONO);
         uint8_t rop = voodoo->banshee_blt.command >> 24;
+        int fast_path = banshee_get_fast_path(voodoo, 0);
         int src_colorkey;
 
         switch (voodoo->banshee_blt.srcFormat & SRC_FORMAT_COL_MASK) {
@@ -415,7 +843,8 @@ static void do_screen_to_screen_line(voodoo_t *voodoo, uint8_t *src_p, int use_x
         //        voodoo->banshee_blt.dstFormat);
         if ((voodoo->banshee_blt.srcFormat & SRC_FORMAT_COL_MASK) == (voodoo->banshee_blt.dstFormat & DST_FORMAT_COL_MASK)) {
                 /*No conversion required*/
-                if (dst_y >= clip->y_min && dst_y < clip->y_max) {
+                if (dst_y >= clip->y_min && dst_y < clip->y_max &&
+                    !banshee_fast_copy_line(voodoo, fast_path, clip, src_p, use_x_dir, src_x, src_tiled)) {
                         int dst_x = voodoo->banshee_blt.dstX;
                         int pat_x = voodoo->banshee_blt.patoff_x + voodoo->banshee_blt.dstX;
                         uint8_t pattern_mask = pattern_mono[pat_y & 7];
@@ -526,7 +955,8 @@ static void do_screen_to_screen_line(voodoo_t *voodoo, uint8_t *src_p, int use_x
                 voodoo->banshee_blt.dstY += (voodoo->banshee_blt.command & COMMAND_DY) ? -1 : 1;
         } else {
                 /*Conversion required*/
-                if (dst_y >= clip->y_min && dst_y < clip->y_max) {
+                if (dst_y >= clip->y_min && dst_y < clip->y_max &&
+                    !banshee_fast_copy_line(voodoo, fast_path, clip, src_p, use_x_dir, src_x, src_tiled)) {
                         //                        int src_x = voodoo->banshee_blt.srcX;
                         int dst_x = voodoo->banshee_blt.dstX;
                         int pat_x = voodoo->banshee_blt.patoff_x + voodoo->banshee_blt.dstX;
@@ -1,4 +1,3 @@
-#include <assert.h>
 #include "ibm.h"
 #include "device.h"
 #include "mem.h"
@@ -10,6 +9,7 @@
 #include "vid_voodoo_display.h"
 #include "vid_voodoo_regs.h"
 #include "vid_voodoo_render.h"
+#include "vid_voodoo_scanout.h"
 
 void voodoo_update_ncc(voodoo_t *voodoo, int tmu) {
         int tbl;
@@ -85,6 +85,14 @@ static void voodoo_calc_clutData(voodoo_t *voodoo) {
                         (voodoo->clutData[c >> 3].b * (8 - (c & 7)) + voodoo->clutData[(c >> 3) + 1].b * (c & 7)) >> 3;
         }
 
+        voodoo->clut_linear = 1;
+        for (c = 0; c < 256; c++) {
+                if (voodoo->clutData256[c].r != c || voodoo->clutData256[c].g != c || voodoo->clutData256[c].b != c) {
+                        voodoo->clut_linear = 0;
+                        break;
+                }
+        }
+
         for (c = 0; c < 65536; c++) {
                 int r = (c >> 8) & 0xf8;
                 int g = (c >> 3) & 0xfc;
@@ -302,6 +310,8 @@ void voodoo_threshold_check(voodoo_t *voodoo) {
 
                 pclog("Voodoo Filter Threshold Check: %06x - RED %i GREEN %i BLUE %i\n", voodoo->scrfilterThreshold, r, g, b);
 
+                /*The scanout worker reads the tables and the threshold*/
+                voodoo_scanout_sync(voodoo);
                 voodoo->scrfilterThresholdOld = voodoo->scrfilterThreshold;
 
                 if (voodoo->type == VOODOO_2)
@@ -314,126 +324,6 @@ void voodoo_threshold_check(voodoo_t *voodoo) {
         }
 }
 
-static void voodoo_filterline_v1(voodoo_t *voodoo, uint8_t *fil, int column, uint16_t *src, int line) {
-        int x;
-
-        // Scratchpad for avoiding feedback streaks
-        uint8_t fil3[4096 * 3];
-
-        assert(voodoo->h_disp <= 4096);
-
-        /* 16 to 32-bit */
-        for (x = 0; x < column; x++) {
-                fil[x * 3] = ((src[x] & 31) << 3);
-                fil[x * 3 + 1] = (((src[x] >> 5) & 63) << 2);
-                fil[x * 3 + 2] = (((src[x] >> 11) & 31) << 3);
-
-                // Copy to our scratchpads
-                fil3[x * 3 + 0] = fil[x * 3 + 0];
-                fil3[x * 3 + 1] = fil[x * 3 + 1];
-                fil3[x * 3 + 2] = fil[x * 3 + 2];
-        }
-
-        /* lines */
-
-        if (line & 1) {
-                for (x = 0; x < column; x++) {
-                        fil[x * 3] = voodoo->purpleline[fil[x * 3]][0];
-                        fil[x * 3 + 1] = voodoo->purpleline[fil[x * 3 + 1]][1];
-                        fil[x * 3 + 2] = voodoo->purpleline[fil[x * 3 + 2]][2];
-                }
-        }
-
-        /* filtering time */
-
-        for (x = 1; x < column; x++) {
-                fil3[(x)*3] = voodoo->thefilterb[fil[x * 3]][fil[(x - 1) * 3]];
-                fil3[(x)*3 + 1] = voodoo->thefilterg[fil[x * 3 + 1]][fil[(x - 1) * 3 + 1]];
-                fil3[(x)*3 + 2] = voodoo->thefilter[fil[x * 3 + 2]][fil[(x - 1) * 3 + 2]];
-        }
-
-        for (x = 1; x < column; x++) {
-                fil[(x)*3] = voodoo->thefilterb[fil3[x * 3]][fil3[(x - 1) * 3]];
-                fil[(x)*3 + 1] = voodoo->thefilterg[fil3[x * 3 + 1]][fil3[(x - 1) * 3 + 1]];
-                fil[(x)*3 + 2] = voodoo->thefilter[fil3[x * 3 + 2]][fil3[(x - 1) * 3 + 2]];
-        }
-
-        for (x = 1; x < column; x++) {
-                fil3[(x)*3] = voodoo->thefilterb[fil[x * 3]][fil[(x - 1) * 3]];
-                fil3[(x)*3 + 1] = voodoo->thefilterg[fil[x * 3 + 1]][fil[(x - 1) * 3 + 1]];
-                fil3[(x)*3 + 2] = voodoo->thefilter[fil[x * 3 + 2]][fil[(x - 1) * 3 + 2]];
-        }
-
-        for (x = 0; x < column - 1; x++) {
-                fil[(x)*3] = voodoo->thefilterb[fil3[x * 3]][fil3[(x + 1) * 3]];
-                fil[(x)*3 + 1] = voodoo->thefilterg[fil3[x * 3 + 1]][fil3[(x + 1) * 3 + 1]];
-                fil[(x)*3 + 2] = voodoo->thefilter[fil3[x * 3 + 2]][fil3[(x + 1) * 3 + 2]];
-        }
-}
-
-static void voodoo_filterline_v2(voodoo_t *voodoo, uint8_t *fil, int column, uint16_t *src, int line) {
-        int x;
-
-        // Scratchpad for blending filter
-        uint8_t fil3[4096 * 3];
-
-        assert(voodoo->h_disp <= 4096);
-
-        /* 16 to 32-bit */
-        for (x = 0; x < column; x++) {
-                // Blank scratchpads
-                fil3[x * 3 + 0] = fil[x * 3 + 0] = ((src[x] & 31) << 3);
-                fil3[x * 3 + 1] = fil[x * 3 + 1] = (((src[x] >> 5) & 63) << 2);
-                fil3[x * 3 + 2] = fil[x * 3 + 2] = (((src[x] >> 11) & 31) << 3);
-        }
-
-        /* filtering time */
-
-        for (x = 1; x < column - 3; x++) {
-                fil3[(x + 3) * 3] = voodoo->thefilterb[((src[x + 3] & 31) << 3)][((src[x] & 31) << 3)];
-                fil3[(x + 3) * 3 + 1] = voodoo->thefilterg[(((src[x + 3] >> 5) & 63) << 2)][(((src[x] >> 5) & 63) << 2)];
-                fil3[(x + 3) * 3 + 2] = voodoo->thefilter[(((src[x + 3] >> 11) & 31) << 3)][(((src[x] >> 11) & 31) << 3)];
-
-                fil[(x + 2) * 3] = voodoo->thefilterb[fil3[(x + 2) * 3]][((src[x] & 31) << 3)];
-                fil[(x + 2) * 3 + 1] = voodoo->thefilterg[fil3[(x + 2) * 3 + 1]][(((src[x] >> 5) & 63) << 2)];
-                fil[(x + 2) * 3 + 2] = voodoo->thefilter[fil3[(x + 2) * 3 + 2]][(((src[x] >> 11) & 31) << 3)];
-
-                fil3[(x + 1) * 3] = voodoo->thefilterb[fil[(x + 1) * 3]][((src[x] & 31) << 3)];
-                fil3[(x + 1) * 3 + 1] = voodoo->thefilterg[fil[(x + 1) * 3 + 1]][(((src[x] >> 5) & 63) << 2)];
-                fil3[(x + 1) * 3 + 2] = voodoo->thefilter[fil[(x + 1) * 3 + 2]][(((src[x] >> 11) & 31) << 3)];
-
-                fil[(x - 1) * 3] = voodoo->thefilterb[fil3[(x - 1) * 3]][((src[x] & 31) << 3)];
-                fil[(x - 1) * 3 + 1] = voodoo->thefilterg[fil3[(x - 1) * 3 + 1]][(((src[x] >> 5) & 63) << 2)];
-                fil[(x - 1) * 3 + 2] = voodoo->thefilter[fil3[(x - 1) * 3 + 2]][(((src[x] >> 11) & 31) << 3)];
-        }
-
-        // unroll for edge cases
-
-        fil3[(column - 3) * 3] = voodoo->thefilterb[((src[column - 3] & 31) << 3)][((src[column] & 31) << 3)];
-        fil3[(column - 3) * 3 + 1] = voodoo->thefilterg[(((src[column - 3] >> 5) & 63) << 2)][(((src[column] >> 5) & 63) << 2)];
-        fil3[(column - 3) * 3 + 2] = voodoo->thefilter[(((src[column - 3] >> 11) & 31) << 3)][(((src[column] >> 11) & 31) << 3)];
-
-        fil3[(column - 2) * 3] = voodoo->thefilterb[((src[column - 2] & 31) << 3)][((src[column] & 31) << 3)];
-        fil3[(column - 2) * 3 + 1] = voodoo->thefilterg[(((src[column - 2] >> 5) & 63) << 2)][(((src[column] >> 5) & 63) << 2)];
-        fil3[(column - 2) * 3 + 2] = voodoo->thefilter[(((src[column - 2] >> 11) & 31) << 3)][(((src[column] >> 11) & 31) << 3)];
-
-        fil3[(column - 1) * 3] = voodoo->thefilterb[((src[column - 1] & 31) << 3)][((src[column] & 31) << 3)];
-        fil3[(column - 1) * 3 + 1] = voodoo->thefilterg[(((src[column - 1] >> 5) & 63) << 2)][(((src[column] >> 5) & 63) << 2)];
-        fil3[(column - 1) * 3 + 2] = voodoo->thefilter[(((src[column - 1] >> 11) & 31) << 3)][(((src[column] >> 11) & 31) << 3)];
-
-        fil[(column - 2) * 3] = voodoo->thefilterb[fil3[(column - 2) * 3]][((src[column] & 31) << 3)];
-        fil[(column - 2) * 3 + 1] = voodoo->thefilterg[fil3[(column - 2) * 3 + 1]][(((src[column] >> 5) & 63) << 2)];
-        fil[(column - 2) * 3 + 2] = voodoo->thefilter[fil3[(column - 2) * 3 + 2]][(((src[column] >> 11) & 31) << 3)];
-
-        fil[(column - 1) * 3] = voodoo->thefilterb[fil3[(column - 1) * 3]][((src[column] & 31) << 3)];
-        fil[(column - 1) * 3 + 1] = voodoo->thefilterg[fil3[(column - 1) * 3 + 1]][(((src[column] >> 5) & 63) << 2)];
-        fil[(column - 1) * 3 + 2] = voodoo->thefilter[fil3[(column - 1) * 3 + 2]][(((src[column] >> 11) & 31) << 3)];
-
-        fil3[(column - 1) * 3] = voodoo->thefilterb[fil[(column - 1) * 3]][((src[column] & 31) << 3)];
-        fil3[(column - 1) * 3 + 1] = voodoo->thefilterg[fil[(column - 1) * 3 + 1]][(((src[column] >> 5) & 63) << 2)];
-        fil3[(column - 1) * 3 + 2] = voodoo->thefilter[fil[(column - 1) * 3 + 2]][(((src[column] >> 11) & 31) << 3)];
-}
-
 void voodoo_callback(void *p) {
         voodoo_t *voodoo = (voodoo_t *)p;
 
@@ -442,6 +332,10 @@ void voodoo_callback(void *p) {
                         voodoo_t *draw_voodoo;
                         int draw_line;
 
+                        /*Lines stay dirty until a frame that isn't skipped*/
+                        if (voodoo->frameskip)
+                                goto skip_draw;
+
                         if (SLI_ENABLED) {
                                 if (voodoo == voodoo->set->voodoos[1])
                                         goto skip_draw;
@@ -459,11 +353,6 @@ void voodoo_callback(void *p) {
                         }
 
                         if (draw_voodoo->dirty_line[draw_line]) {
-                                uint32_t *p = &((uint32_t *)buffer32->line[voodoo->line])[32];
-                                uint16_t *src = (uint16_t *)&draw_voodoo
-                                                        ->fb_mem[draw_voodoo->front_offset + draw_line * draw_voodoo->row_width];
-                                int x;
-
                                 draw_voodoo->dirty_line[draw_line] = 0;
 
                                 if (voodoo->line < voodoo->dirty_line_low) {
@@ -473,26 +362,7 @@ void voodoo_callback(void *p) {
                                 if (voodoo->line > voodoo->dirty_line_high)
                                         voodoo->dirty_line_high = voodoo->line;
 
-                                if (voodoo->scrfilter && voodoo->scrfilterEnabled) {
-                                        uint8_t fil[4096 * 3]; /* interleaved 24-bit RGB */
-
-                                        assert(voodoo->h_disp <= 4096);
-
-                                        if (voodoo->type == VOODOO_2)
-                                                voodoo_filterline_v2(voodoo, fil, voodoo->h_disp, src, voodoo->line);
-                                        else
-                                                voodoo_filterline_v1(voodoo, fil, voodoo->h_disp, src, voodoo->line);
-
-                                        for (x = 0; x < voodoo->h_disp; x++) {
-                                                p[x] = (voodoo->clutData256[fil[x * 3]].b << 0 |
-                                                        voodoo->clutData256[fil[x * 3 + 1]].g << 8 |
-                                                        voodoo->clutData256[fil[x * 3 + 2]].r << 16);
-                                        }
-                                } else {
-                                        for (x = 0; x < voodoo->h_disp; x++) {
-                                                p[x] = draw_voodoo->video_16to32[src[x]];
-                                        }
-                                }
+                                voodoo_scanout_line(voodoo, draw_voodoo, draw_line, voodoo->line);
                         }
                 }
         }
@@ -554,6 +424,10 @@ skip_draw:
 
         if (voodoo->fbiInit0 & FBIINIT0_VGA_PASS) {
                 if (voodoo->line == voodoo->v_disp) {
+                        /*Lines may have been queued by either card of an SLI
+                          pair, and may use either card's lookup tables*/
+                        voodoo_scanout_sync_set(voodoo);
+
                         if (voodoo->dirty_line_high > voodoo->dirty_line_low)
                                 svga_doblit(0, voodoo->v_disp, voodoo->h_disp, voodoo->v_disp - 1, voodoo->svga);
                         if (voodoo->clutData_dirty) {
@@ -562,6 +436,8 @@ skip_draw:
                         }
                         voodoo->dirty_line_high = -1;
                         voodoo->dirty_line_low = 2000;
+                        if (!SLI_ENABLED || voodoo != voodoo->set->voodoos[1])
+                                voodoo->frameskip = video_frameskip(&voodoo->frameskip_count);
                 }
         }
 
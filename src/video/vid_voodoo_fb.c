@@ -409,3 +409,94 @@ void voodoo_fb_writel(uint32_t addr, uint32_t val, void *p) {
                 }
         }
 }
+
+/*Combined LFB writes, all within one row. With the pixel pipeline bypassed the
+  format, position and dirty line are worked out once per span rather than per
+  word; otherwise, or for tiled buffers, each word goes through
+  voodoo_fb_writel()*/
+void voodoo_fb_writel_span(voodoo_t *voodoo, uint32_t addr, uint32_t *data, int count) {
+        uint16_t *fb_mem = (uint16_t *)voodoo->fb_mem;
+        uint32_t fb_mask = voodoo->fb_mask >> 1;
+        uint32_t write_addr;
+        int format = voodoo->lfbMode & LFB_FORMAT_MASK;
+        int x, y;
+        int c;
+
+        if ((voodoo->lfbMode & 0x100) || voodoo->col_tiled || voodoo->aux_tiled ||
+            (format != LFB_FORMAT_RGB565 && format != LFB_FORMAT_RGB555 && format != LFB_FORMAT_ARGB1555 &&
+             format != LFB_FORMAT_ARGB8888 && format != LFB_FORMAT_DEPTH)) {
+                for (c = 0; c < count; c++)
+                        voodoo_fb_writel(addr + c * 4, data[c], voodoo);
+                return;
+        }
+
+        if (format == LFB_FORMAT_ARGB8888)
+                addr >>= 1;
+
+        if (voodoo->type >= VOODOO_BANSHEE) {
+                x = addr & 0xffe;
+                y = (addr >> 12) & 0x3ff;
+        } else {
+                x = addr & 0x7fe;
+                y = (addr >> 11) & 0x3ff;
+        }
+
+        if (SLI_ENABLED) {
+                if ((!(voodoo->initEnable & INITENABLE_SLI_MASTER_SLAVE) && (y & 1)) ||
+                    ((voodoo->initEnable & INITENABLE_SLI_MASTER_SLAVE) && !(y & 1)))
+                        return;
+                y >>= 1;
+        }
+
+        if (voodoo->fb_write_offset == voodoo->params.front_offset && y < 2048)
+                voodoo->dirty_line[y] = 1;
+
+        if (format == LFB_FORMAT_DEPTH) {
+                write_addr = (voodoo->params.aux_offset + x + (y * voodoo->row_width)) >> 1;
+
+                for (c = 0; c < count; c++) {
+                        fb_mem[write_addr & fb_mask] = data[c];
+                        fb_mem[(write_addr + 1) & fb_mask] = data[c] >> 16;
+                        write_addr += 2;
+                }
+                return;
+        }
+
+        write_addr = (voodoo->fb_write_offset + x + (y * voodoo->row_width)) >> 1;
+        x >>= 1;
+
+        switch (format) {
+        case LFB_FORMAT_RGB565:
+                for (c = 0; c < count; c++) {
+                        fb_mem[write_addr & fb_mask] = do_dither(&voodoo->params, rgb565[data[c] & 0xffff], x, y);
+                        fb_mem[(write_addr + 1) & fb_mask] = do_dither(&voodoo->params, rgb565[data[c] >> 16], x + 1, y);
+                        write_addr += 2;
+                        x += 2;
+                }
+                break;
+
+        case LFB_FORMAT_RGB555:
+        case LFB_FORMAT_ARGB1555:
+                for (c = 0; c < count; c++) {
+                        fb_mem[write_addr & fb_mask] = do_dither(&voodoo->params, argb1555[data[c] & 0xffff], x, y);
+                        fb_mem[(write_addr + 1) & fb_mask] = do_dither(&voodoo->params, argb1555[data[c] >> 16], x + 1, y);
+                        write_addr += 2;
+                        x += 2;
+                }
+                break;
+
+        case LFB_FORMAT_ARGB8888:
+                for (c = 0; c < count; c++) {
+                        rgba8_t colour;
+
+                        colour.b = data[c] & 0xff;
+                        colour.g = (data[c] >> 8) & 0xff;
+                        colour.r = (data[c] >> 16) & 0xff;
+                        colour.a = 0;
+                        fb_mem[write_addr & fb_mask] = do_dither(&voodoo->params, colour, x, y);
+                        write_addr++;
+                        x++;
+                }
+                break;
+        }
+}
@@ -14,6 +14,7 @@
 #include "vid_voodoo_reg.h"
 #include "vid_voodoo_regs.h"
 #include "vid_voodoo_render.h"
+#include "vid_voodoo_scanout.h"
 #include "vid_voodoo_texture.h"
 
 #define WAKE_DELAY (TIMER_USEC * 100)
@@ -34,10 +35,11 @@ void voodoo_wake_fifo_thread_now(voodoo_t *voodoo) {
 void voodoo_wake_timer(void *p) {
         voodoo_t *voodoo = (voodoo_t *)p;
 
+        voodoo_lfb_span_commit(voodoo);
         thread_set_event(voodoo->wake_fifo_thread); /*Wake up FIFO thread if moving from idle*/
 }
 
-void voodoo_queue_command(voodoo_t *voodoo, uint32_t addr_type, uint32_t val) {
+static void voodoo_queue_entry(voodoo_t *voodoo, uint32_t addr_type, uint32_t val) {
         fifo_entry_t *fifo = &voodoo->fifo[voodoo->fifo_write_idx & FIFO_MASK];
 
         while (FIFO_FULL) {
@@ -58,7 +60,56 @@ void voodoo_queue_command(voodoo_t *voodoo, uint32_t addr_type, uint32_t val) {
                 voodoo_wake_fifo_thread(voodoo);
 }
 
+void voodoo_queue_command(voodoo_t *voodoo, uint32_t addr_type, uint32_t val) {
+        /*Anything else queued is a barrier for combined LFB writes*/
+        if (voodoo->lfb_span_open)
+                voodoo_lfb_span_commit(voodoo);
+
+        voodoo_queue_entry(voodoo, addr_type, val);
+}
+
+void voodoo_lfb_span_commit(voodoo_t *voodoo) {
+        if (!voodoo->lfb_span_open)
+                return;
+
+        voodoo->lfb_span_open = 0;
+        voodoo_queue_entry(voodoo, FIFO_WRITEL_FB_SPAN, voodoo->lfb_span_write_idx & LFB_SPAN_MASK);
+        voodoo->lfb_span_write_idx++;
+}
+
+/*Consecutive LFB writes are gathered into a span, which is queued as a single
+  FIFO entry when a write doesn't follow on from it or it reaches the end of its
+  2kB block. It is also queued before any other command, before anything waits
+  for the FIFO to drain and when the wake timer fires, so the FIFO thread sees
+  every write in the order it was made*/
+void voodoo_queue_lfb_writel(voodoo_t *voodoo, uint32_t addr, uint32_t val) {
+        voodoo_lfb_span_t *span = &voodoo->lfb_spans[voodoo->lfb_span_write_idx & LFB_SPAN_MASK];
+
+        if (voodoo->lfb_span_open && addr != span->addr + span->count * 4)
+                voodoo_lfb_span_commit(voodoo);
+
+        if (!voodoo->lfb_span_open) {
+                while (LFB_SPAN_FULL) {
+                        thread_reset_event(voodoo->fifo_not_full_event);
+                        if (LFB_SPAN_FULL) {
+                                voodoo_wake_fifo_thread_now(voodoo);
+                                thread_wait_event(voodoo->fifo_not_full_event, 1);
+                        }
+                }
+                span = &voodoo->lfb_spans[voodoo->lfb_span_write_idx & LFB_SPAN_MASK];
+                span->addr = addr;
+                span->count = 0;
+                voodoo->lfb_span_open = 1;
+                voodoo_wake_fifo_thread(voodoo);
+        }
+
+        span->data[span->count++] = val;
+        if ((addr & 0x7fc) == 0x7fc)
+                voodoo_lfb_span_commit(voodoo);
+}
+
 void voodoo_flush(voodoo_t *voodoo) {
+        voodoo_lfb_span_commit(voodoo);
         voodoo->flush = 1;
         while (!FIFO_EMPTY) {
                 voodoo_wake_fifo_thread_now(voodoo);
@@ -82,6 +133,7 @@ void voodoo_wait_for_swap_complete(voodoo_t *voodoo) {
                 thread_lock_mutex(voodoo->swap_mutex);
                 if ((voodoo->swap_pending && voodoo->flush) || FIFO_FULL) {
                         /*Main thread is waiting for FIFO to empty, so skip vsync wait and just swap*/
+                        voodoo_scanout_sync_set(voodoo);
                         memset(voodoo->dirty_line, 1, sizeof(voodoo->dirty_line));
                         voodoo->front_offset = voodoo->params.front_offset;
                         if (voodoo->swap_count > 0)
@@ -183,6 +235,22 @@ void voodoo_fifo_thread(void *param) {
                                         fifo = &voodoo->fifo[voodoo->fifo_read_idx & FIFO_MASK];
                                 }
                                 break;
+                        case FIFO_WRITEL_FB_SPAN:
+                                voodoo_wait_for_render_thread_idle(voodoo);
+                                while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEL_FB_SPAN) {
+                                        voodoo_lfb_span_t *span = &voodoo->lfb_spans[fifo->val];
+
+                                        voodoo_fb_writel_span(voodoo, span->addr, span->data, span->count);
+                                        __atomic_store_n(&voodoo->lfb_span_read_idx, voodoo->lfb_span_read_idx + 1,
+                                                         __ATOMIC_RELEASE);
+                                        fifo->addr_type = FIFO_INVALID;
+                                        voodoo->fifo_read_idx++;
+                                        if (FIFO_EMPTY)
+                                                break;
+                                        fifo = &voodoo->fifo[voodoo->fifo_read_idx & FIFO_MASK];
+                                }
+                                thread_set_event(voodoo->fifo_not_full_event); /*Span slots freed*/
+                                break;
                         case FIFO_WRITEL_TEX:
                                 while ((fifo->addr_type & FIFO_TYPE) == FIFO_WRITEL_TEX) {
                                         if (!(fifo->addr_type & 0x400000))
@@ -15,6 +15,7 @@
 #include "vid_voodoo_reg.h"
 #include "vid_voodoo_regs.h"
 #include "vid_voodoo_render.h"
+#include "vid_voodoo_scanout.h"
 #include "vid_voodoo_setup.h"
 #include "vid_voodoo_texture.h"
 #include "viewer.h"
@@ -89,6 +90,9 @@ void voodoo_reg_writel(uint32_t addr, uint32_t val, void *p) {
                 if (voodoo->viewer_active)
                         viewer_call(&viewer_voodoo, voodoo, voodoo_viewer_swap_buffer, NULL);
                 if (!(val & 1)) {
+                        /*Queued lines still point into the old front buffer,
+                          which is about to be drawn over*/
+                        voodoo_scanout_sync_set(voodoo);
                         memset(voodoo->dirty_line, 1, sizeof(voodoo->dirty_line));
                         voodoo->front_offset = voodoo->params.front_offset;
                         thread_lock_mutex(voodoo->swap_mutex);
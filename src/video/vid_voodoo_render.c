@@ -149,6 +149,24 @@ static inline int voodoo_fls(uint16_t val) {
         return num;
 }
 
+static inline int32_t voodoo_w_depth(int64_t w) {
+        int32_t w_depth;
+
+        if (w & 0xffff00000000)
+                w_depth = 0;
+        else if (!(w & 0xffff0000))
+                w_depth = 0xf001;
+        else {
+                int exp = voodoo_fls((uint16_t)((uint32_t)w >> 16));
+                int mant = ((~(uint32_t)w >> (19 - exp))) & 0xfff;
+                w_depth = (exp << 12) + mant + 1;
+                if (w_depth > 0xffff)
+                        w_depth = 0xffff;
+        }
+
+        return w_depth;
+}
+
 typedef struct voodoo_texture_state_t {
         int s, t;
         int w_mask, h_mask;
@@ -565,9 +583,8 @@ static inline void voodoo_tmu_fetch_and_blend(voodoo_t *voodoo, voodoo_params_t
 #include "vid_voodoo_codegen_x86.h"
 #elif (defined __amd64__)
 #include "vid_voodoo_codegen_x86-64.h"
-#else
-int voodoo_recomp = 0;
 #endif
+#include "vid_voodoo_render_vec.h"
 
 static void voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int ystart, int yend,
                                  int odd_even) {
@@ -599,6 +616,9 @@ static void voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, vood
         int c;
 #ifndef NO_CODEGEN
         uint8_t (*voodoo_draw)(voodoo_state_t * state, voodoo_params_t * params, int x, int real_y);
+#endif
+#ifdef VOODOO_RENDER_VEC
+        voodoo_vec_span_t vec_span = NULL;
 #endif
         int y_diff = SLI_ENABLED ? 2 : 1;
         int y_origin = (voodoo->type >= VOODOO_BANSHEE) ? voodoo->y_origin_swap : (voodoo->v_disp - 1);
@@ -694,6 +714,12 @@ static void voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, vood
         else
                 voodoo_draw = NULL;
 #endif
+#ifdef VOODOO_RENDER_VEC
+#ifndef NO_CODEGEN
+        if (!voodoo->use_recompiler)
+#endif
+                vec_span = voodoo_vec_get_span(voodoo, params);
+#endif
 
         if (voodoo_output)
                 pclog("dxAB=%08x dxBC=%08x dxAC=%08x\n", state->dxAB, state->dxBC, state->dxAC);
@@ -859,6 +885,16 @@ static void voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, vood
                 if (voodoo->use_recompiler) {
                         voodoo_draw(state, params, x, real_y);
                 } else
+#endif
+#ifdef VOODOO_RENDER_VEC
+                if (vec_span) {
+                        int count = (x2 - x) * state->xdir + 1;
+
+                        vec_span(voodoo, params, state, x, x2, real_y, fb_mem, aux_mem);
+                        voodoo->pixel_count[odd_even] += count;
+                        voodoo->texel_count[odd_even] += count * texels;
+                        voodoo->fbiPixelsIn += count;
+                } else
 #endif
                         do {
                                 int x_tiled = (x & 63) | ((x >> 6) * 128 * 32 / 2);
@@ -882,17 +918,7 @@ static void voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, vood
                                         int sel;
                                         int32_t new_depth, w_depth;
 
-                                        if (state->w & 0xffff00000000)
-                                                w_depth = 0;
-                                        else if (!(state->w & 0xffff0000))
-                                                w_depth = 0xf001;
-                                        else {
-                                                int exp = voodoo_fls((uint16_t)((uint32_t)state->w >> 16));
-                                                int mant = ((~(uint32_t)state->w >> (19 - exp))) & 0xfff;
-                                                w_depth = (exp << 12) + mant + 1;
-                                                if (w_depth > 0xffff)
-                                                        w_depth = 0xffff;
-                                        }
+                                        w_depth = voodoo_w_depth(state->w);
 
                                         //                                w_depth = CLAMP16(w_depth);
 
@@ -1291,6 +1317,11 @@ static void voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, vood
                 state->xend += state->dx2;
         }
 
+#ifndef NO_CODEGEN
+        if (voodoo_draw)
+                voodoo_put_block(voodoo, voodoo_draw);
+#endif
+
         voodoo->texture_cache[0][params->tex_entry[0]].refcount_r[odd_even]++;
         voodoo->texture_cache[1][params->tex_entry[1]].refcount_r[odd_even]++;
 }
@@ -0,0 +1,414 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "ibm.h"
+#include "device.h"
+#include "mem.h"
+#include "thread.h"
+#include "video.h"
+#include "vid_svga.h"
+#include "vid_voodoo.h"
+#include "vid_voodoo_common.h"
+#include "vid_voodoo_scanout.h"
+
+#define SCANOUT_ENTRIES(scanout) ((scanout)->write_idx - (scanout)->read_idx)
+#define SCANOUT_FULL(scanout) (SCANOUT_ENTRIES(scanout) >= VOODOO_SCANOUT_SIZE)
+#define SCANOUT_EMPTY(scanout) ((scanout)->read_idx == (scanout)->write_idx)
+
+/*16-bit lane vector operations for the filter kernels*/
+#if defined(__AVX2__)
+#define SCANOUT_SIMD
+#define VEC_LANES 16
+typedef __m256i vec_t;
+#define vec_load(p) _mm256_loadu_si256((const __m256i *)(p))
+#define vec_store(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+#define vec_set1(v) _mm256_set1_epi16(v)
+#define vec_add(a, b) _mm256_add_epi16(a, b)
+#define vec_sub(a, b) _mm256_sub_epi16(a, b)
+#define vec_min(a, b) _mm256_min_epi16(a, b)
+#define vec_max(a, b) _mm256_max_epi16(a, b)
+#define vec_cmpgt(a, b) _mm256_cmpgt_epi16(a, b)
+#define vec_and(a, b) _mm256_and_si256(a, b)
+#define vec_andnot(a, b) _mm256_andnot_si256(a, b)
+#define vec_or(a, b) _mm256_or_si256(a, b)
+#define vec_slli(a, n) _mm256_slli_epi16(a, n)
+#define vec_srli(a, n) _mm256_srli_epi16(a, n)
+#define vec_srai(a, n) _mm256_srai_epi16(a, n)
+#define vec_mulhi_epu16(a, b) _mm256_mulhi_epu16(a, b)
+#elif defined(__SSE2__)
+#define SCANOUT_SIMD
+#define VEC_LANES 8
+typedef __m128i vec_t;
+#define vec_load(p) _mm_loadu_si128((const __m128i *)(p))
+#define vec_store(p, v) _mm_storeu_si128((__m128i *)(p), v)
+#define vec_set1(v) _mm_set1_epi16(v)
+#define vec_add(a, b) _mm_add_epi16(a, b)
+#define vec_sub(a, b) _mm_sub_epi16(a, b)
+#define vec_min(a, b) _mm_min_epi16(a, b)
+#define vec_max(a, b) _mm_max_epi16(a, b)
+#define vec_cmpgt(a, b) _mm_cmpgt_epi16(a, b)
+#define vec_and(a, b) _mm_and_si128(a, b)
+#define vec_andnot(a, b) _mm_andnot_si128(a, b)
+#define vec_or(a, b) _mm_or_si128(a, b)
+#define vec_slli(a, n) _mm_slli_epi16(a, n)
+#define vec_srli(a, n) _mm_srli_epi16(a, n)
+#define vec_srai(a, n) _mm_srai_epi16(a, n)
+#define vec_mulhi_epu16(a, b) _mm_mulhi_epu16(a, b)
+#endif
+
+/*16bpp to 32bpp through a linear CLUT. Gives the same result as video_16to32[]
+  when clut_linear is set*/
+static void voodoo_scanout_convert_linear(uint32_t *dest, const uint16_t *src, int width) {
+        int x = 0;
+
+#if defined(__AVX2__)
+        const __m256i mask_r = _mm256_set1_epi32(0xf80000);
+        const __m256i mask_g = _mm256_set1_epi32(0xfc00);
+        const __m256i mask_b = _mm256_set1_epi32(0xf8);
+
+        for (; x + 8 <= width; x += 8) {
+                __m256i p = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)&src[x]));
+                __m256i r = _mm256_and_si256(_mm256_slli_epi32(p, 8), mask_r);
+                __m256i g = _mm256_and_si256(_mm256_slli_epi32(p, 5), mask_g);
+                __m256i b = _mm256_and_si256(_mm256_slli_epi32(p, 3), mask_b);
+
+                _mm256_storeu_si256((__m256i *)&dest[x], _mm256_or_si256(_mm256_or_si256(r, g), b));
+        }
+#elif defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mask_r = _mm_set1_epi32(0xf80000);
+        const __m128i mask_g = _mm_set1_epi32(0xfc00);
+        const __m128i mask_b = _mm_set1_epi32(0xf8);
+
+        for (; x + 8 <= width; x += 8) {
+                __m128i s = _mm_loadu_si128((const __m128i *)&src[x]);
+                __m128i p[2];
+                int c;
+
+                p[0] = _mm_unpacklo_epi16(s, zero);
+                p[1] = _mm_unpackhi_epi16(s, zero);
+                for (c = 0; c < 2; c++) {
+                        __m128i r = _mm_and_si128(_mm_slli_epi32(p[c], 8), mask_r);
+                        __m128i g = _mm_and_si128(_mm_slli_epi32(p[c], 5), mask_g);
+                        __m128i b = _mm_and_si128(_mm_slli_epi32(p[c], 3), mask_b);
+
+                        _mm_storeu_si128((__m128i *)&dest[x + c * 4], _mm_or_si128(_mm_or_si128(r, g), b));
+                }
+        }
+#endif
+        for (; x < width; x++) {
+                uint16_t p = src[x];
+
+                dest[x] = ((p << 8) & 0xf80000) | ((p << 5) & 0xfc00) | ((p << 3) & 0xf8);
+        }
+}
+
+/*RGB565 to one 8-bit plane per channel, as the filters work on*/
+static void voodoo_scanout_unpack(uint16_t *b, uint16_t *g, uint16_t *r, const uint16_t *src, int width) {
+        int x = 0;
+
+#ifdef SCANOUT_SIMD
+        const vec_t mask_b = vec_set1(0xf8);
+        const vec_t mask_g = vec_set1(0xfc);
+
+        for (; x + VEC_LANES <= width; x += VEC_LANES) {
+                vec_t s = vec_load(&src[x]);
+
+                vec_store(&b[x], vec_and(vec_slli(s, 3), mask_b));
+                vec_store(&g[x], vec_and(vec_srli(s, 3), mask_g));
+                vec_store(&r[x], vec_slli(vec_srli(s, 11), 3));
+        }
+#endif
+        for (; x < width; x++) {
+                b[x] = (src[x] & 31) << 3;
+                g[x] = ((src[x] >> 5) & 63) << 2;
+                r[x] = ((src[x] >> 11) & 31) << 3;
+        }
+}
+
+#ifdef SCANOUT_SIMD
+/*thefilter[g][h] as generated by voodoo_generate_filter_v1() : move g halfway
+  towards h, by at most cap*/
+static inline vec_t voodoo_filter_v1_vec(vec_t g, vec_t h, vec_t cap, vec_t neg_cap) {
+        vec_t d = vec_min(vec_max(vec_sub(h, g), neg_cap), cap);
+
+        return vec_srai(vec_add(vec_add(g, g), d), 1);
+}
+
+/*thefilter[g][h] as generated by voodoo_generate_filter_v2() : only lighten,
+  by the difference between the 4:1 and 1:4 averages of g and h, at most
+  min(cap, 32), and only when g and h are within cap of each other*/
+static inline vec_t voodoo_filter_v2_vec(vec_t g, vec_t h, vec_t cap, vec_t clamp_cap) {
+        const vec_t div5 = vec_set1((short)52429);
+        vec_t diff = vec_max(vec_sub(g, h), vec_sub(h, g));
+        vec_t sum_g = vec_add(vec_slli(g, 2), h);
+        vec_t sum_h = vec_add(vec_slli(h, 2), g);
+        vec_t avg_g = vec_srli(vec_mulhi_epu16(sum_g, div5), 2);
+        vec_t avg_h = vec_srli(vec_mulhi_epu16(sum_h, div5), 2);
+        vec_t avgdiff = vec_max(vec_sub(avg_g, avg_h), vec_sub(avg_h, avg_g));
+        vec_t col = vec_min(vec_add(g, vec_min(avgdiff, clamp_cap)), vec_set1(255));
+        vec_t lighten = vec_andnot(vec_cmpgt(diff, cap), vec_cmpgt(h, g));
+
+        return vec_or(vec_and(lighten, col), vec_andnot(lighten, g));
+}
+#endif
+
+/*out[x] = table[in[x]][nb[x]] for start <= x < end*/
+static void voodoo_filter_pass(uint16_t *out, const uint16_t *in, const uint16_t *nb, int start, int end, int filter, int cap,
+                               uint8_t (*table)[256]) {
+        int x = start;
+
+#ifdef SCANOUT_SIMD
+        const vec_t vcap = vec_set1(cap);
+
+        if (filter == VOODOO_SCANOUT_FILTER_V1) {
+                const vec_t neg_cap = vec_set1(-cap);
+
+                for (; x + VEC_LANES <= end; x += VEC_LANES)
+                        vec_store(&out[x], voodoo_filter_v1_vec(vec_load(&in[x]), vec_load(&nb[x]), vcap, neg_cap));
+        } else {
+                const vec_t clamp_cap = vec_set1((cap > 32) ? 32 : cap);
+
+                for (; x + VEC_LANES <= end; x += VEC_LANES)
+                        vec_store(&out[x], voodoo_filter_v2_vec(vec_load(&in[x]), vec_load(&nb[x]), vcap, clamp_cap));
+        }
+#endif
+        for (; x < end; x++)
+                out[x] = table[in[x]][nb[x]];
+}
+
+static uint8_t (*voodoo_filter_table(voodoo_t *voodoo, int c))[256] {
+        if (c == 0)
+                return voodoo->thefilterb;
+        if (c == 1)
+                return voodoo->thefilterg;
+        return voodoo->thefilter;
+}
+
+/*Threshold the filter tables were last generated for, per channel in blue,
+  green, red order*/
+static int voodoo_filter_cap(voodoo_t *voodoo, int c) { return (voodoo->scrfilterThresholdOld >> (c * 8)) & 0xff; }
+
+/*Voodoo Graphics filter. The scanline is filtered against its left neighbour
+  three times and its right neighbour once, with odd lines brightened first.
+  The left edge of the scratch pass keeps the unbrightened pixel*/
+static void voodoo_filterline_v1(voodoo_scanout_t *scanout, voodoo_t *voodoo, int width, uint16_t *src, int line) {
+        int c, x;
+
+        voodoo_scanout_unpack(scanout->fil3[0], scanout->fil3[1], scanout->fil3[2], src, width);
+
+        for (c = 0; c < 3; c++) {
+                uint16_t *fil = scanout->fil[c];
+                uint16_t *fil3 = scanout->fil3[c];
+                uint8_t(*table)[256] = voodoo_filter_table(voodoo, c);
+                int cap = voodoo_filter_cap(voodoo, c);
+
+                if ((line & 1) && c != 1) {
+                        for (x = 0; x < width; x++)
+                                fil[x] = voodoo->purpleline[fil3[x]][c];
+                } else
+                        memcpy(fil, fil3, width * sizeof(uint16_t));
+
+                voodoo_filter_pass(fil3, fil, fil - 1, 1, width, VOODOO_SCANOUT_FILTER_V1, cap, table);
+                voodoo_filter_pass(fil, fil3, fil3 - 1, 1, width, VOODOO_SCANOUT_FILTER_V1, cap, table);
+                voodoo_filter_pass(fil3, fil, fil - 1, 1, width, VOODOO_SCANOUT_FILTER_V1, cap, table);
+                voodoo_filter_pass(fil, fil3, fil3 + 1, 0, width - 1, VOODOO_SCANOUT_FILTER_V1, cap, table);
+        }
+}
+
+/*Voodoo 2 filter. Each pixel is filtered against the pixels 3, 2 and 1 to its
+  left then 1 to its right of the unfiltered line; the pixels near either edge
+  see fewer passes. The pixel one past the end of the line is read, as on the
+  original implementation*/
+static void voodoo_filterline_v2(voodoo_scanout_t *scanout, voodoo_t *voodoo, int width, uint16_t *src, int line) {
+        int c;
+
+        voodoo_scanout_unpack(scanout->fil3[0], scanout->fil3[1], scanout->fil3[2], src, width + 1);
+
+        for (c = 0; c < 3; c++) {
+                uint16_t *s = scanout->fil3[c];
+                uint16_t *fil = scanout->fil[c];
+                uint8_t(*table)[256] = voodoo_filter_table(voodoo, c);
+                int cap = voodoo_filter_cap(voodoo, c);
+                int w = width;
+
+                /*Middle of the line. Passes run in place in fil, but only ever
+                  read unfiltered pixels from s. The last two pixels before the
+                  right edge only get the first two passes*/
+                voodoo_filter_pass(fil, s, s - 3, 4, w - 2, VOODOO_SCANOUT_FILTER_V2, cap, table);
+                voodoo_filter_pass(fil, fil, s - 2, 4, w - 2, VOODOO_SCANOUT_FILTER_V2, cap, table);
+                voodoo_filter_pass(fil, fil, s - 1, 4, w - 4, VOODOO_SCANOUT_FILTER_V2, cap, table);
+                voodoo_filter_pass(fil, fil, s + 1, 4, w - 4, VOODOO_SCANOUT_FILTER_V2, cap, table);
+
+                /*Edges*/
+                fil[0] = table[s[0]][s[1]];
+                fil[1] = table[s[1]][s[2]];
+                fil[2] = table[table[s[2]][s[1]]][s[3]];
+                fil[3] = table[table[table[s[3]][s[1]]][s[2]]][s[4]];
+                fil[w - 2] = table[table[s[w - 2]][s[w]]][s[w]];
+                fil[w - 1] = table[table[s[w - 1]][s[w]]][s[w]];
+        }
+}
+
+static void voodoo_scanout_pack(uint32_t *dest, voodoo_scanout_t *scanout, voodoo_t *voodoo, int width) {
+        uint16_t *b = scanout->fil[0];
+        uint16_t *g = scanout->fil[1];
+        uint16_t *r = scanout->fil[2];
+        int x = 0;
+
+        if (voodoo->clut_linear) {
+#if defined(__AVX2__)
+                for (; x + 8 <= width; x += 8) {
+                        __m256i vb = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)&b[x]));
+                        __m256i vg = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)&g[x]));
+                        __m256i vr = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)&r[x]));
+
+                        _mm256_storeu_si256((__m256i *)&dest[x], _mm256_or_si256(_mm256_or_si256(vb, _mm256_slli_epi32(vg, 8)),
+                                                                                 _mm256_slli_epi32(vr, 16)));
+                }
+#elif defined(__SSE2__)
+                for (; x + 8 <= width; x += 8) {
+                        __m128i bg = _mm_or_si128(_mm_loadu_si128((const __m128i *)&b[x]),
+                                                  _mm_slli_epi16(_mm_loadu_si128((const __m128i *)&g[x]), 8));
+                        __m128i vr = _mm_loadu_si128((const __m128i *)&r[x]);
+
+                        _mm_storeu_si128((__m128i *)&dest[x], _mm_unpacklo_epi16(bg, vr));
+                        _mm_storeu_si128((__m128i *)&dest[x + 4], _mm_unpackhi_epi16(bg, vr));
+                }
+#endif
+                for (; x < width; x++)
+                        dest[x] = b[x] | (g[x] << 8) | (r[x] << 16);
+        } else {
+                for (; x < width; x++)
+                        dest[x] = voodoo->clutData256[b[x]].b | (voodoo->clutData256[g[x]].g << 8) |
+                                  (voodoo->clutData256[r[x]].r << 16);
+        }
+}
+
+static void voodoo_scanout_do_line(voodoo_scanout_t *scanout, voodoo_scanout_line_t *line) {
+        voodoo_t *voodoo = scanout->voodoo;
+        int x;
+
+        switch (line->filter) {
+        case VOODOO_SCANOUT_FILTER_V1:
+                voodoo_filterline_v1(scanout, voodoo, line->width, line->src, line->line);
+                voodoo_scanout_pack(line->dest, scanout, voodoo, line->width);
+                break;
+
+        case VOODOO_SCANOUT_FILTER_V2:
+                voodoo_filterline_v2(scanout, voodoo, line->width, line->src, line->line);
+                voodoo_scanout_pack(line->dest, scanout, voodoo, line->width);
+                break;
+
+        default:
+                if (voodoo->clut_linear)
+                        voodoo_scanout_convert_linear(line->dest, line->src, line->width);
+                else {
+                        for (x = 0; x < line->width; x++)
+                                line->dest[x] = line->video_16to32[line->src[x]];
+                }
+                break;
+        }
+}
+
+static void voodoo_scanout_thread(void *param) {
+        voodoo_scanout_t *scanout = (voodoo_scanout_t *)param;
+
+        while (1) {
+                thread_set_event(scanout->done_event);
+                thread_wait_event(scanout->wake_event, -1);
+                thread_reset_event(scanout->wake_event);
+
+                while (!SCANOUT_EMPTY(scanout)) {
+                        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+                        voodoo_scanout_do_line(scanout, &scanout->queue[scanout->read_idx & VOODOO_SCANOUT_MASK]);
+
+                        __atomic_store_n(&scanout->read_idx, scanout->read_idx + 1, __ATOMIC_RELEASE);
+                }
+        }
+}
+
+void voodoo_scanout_line(voodoo_t *voodoo, voodoo_t *draw_voodoo, int draw_line, int line) {
+        voodoo_scanout_t *scanout = voodoo->scanout;
+        voodoo_scanout_line_t *entry;
+
+        while (SCANOUT_FULL(scanout)) {
+                thread_set_event(scanout->wake_event);
+                thread_wait_event(scanout->done_event, 1);
+        }
+
+        entry = &scanout->queue[scanout->write_idx & VOODOO_SCANOUT_MASK];
+        entry->dest = &((uint32_t *)buffer32->line[line])[32];
+        entry->src = (uint16_t *)&draw_voodoo->fb_mem[draw_voodoo->front_offset + draw_line * draw_voodoo->row_width];
+        entry->video_16to32 = draw_voodoo->video_16to32;
+        entry->width = voodoo->h_disp;
+        entry->line = line;
+        entry->filter = VOODOO_SCANOUT_FILTER_NONE;
+        if (voodoo->scrfilter && voodoo->scrfilterEnabled) {
+                assert(voodoo->h_disp <= VOODOO_SCANOUT_MAX_WIDTH);
+
+                /*The filters need a few pixels either side to work with*/
+                if (voodoo->h_disp >= 16)
+                        entry->filter = (voodoo->type == VOODOO_2) ? VOODOO_SCANOUT_FILTER_V2 : VOODOO_SCANOUT_FILTER_V1;
+        }
+
+        __atomic_store_n(&scanout->write_idx, scanout->write_idx + 1, __ATOMIC_RELEASE);
+
+        if (++scanout->batch >= VOODOO_SCANOUT_BATCH) {
+                scanout->batch = 0;
+                thread_set_event(scanout->wake_event);
+        }
+}
+
+void voodoo_scanout_sync(voodoo_t *voodoo) {
+        voodoo_scanout_t *scanout = voodoo->scanout;
+
+        if (!scanout)
+                return;
+
+        scanout->batch = 0;
+        while (!SCANOUT_EMPTY(scanout)) {
+                thread_set_event(scanout->wake_event);
+                thread_wait_event(scanout->done_event, 1);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+void voodoo_scanout_sync_set(voodoo_t *voodoo) {
+        int c;
+
+        if (!voodoo->set) {
+                voodoo_scanout_sync(voodoo);
+                return;
+        }
+
+        for (c = 0; c < voodoo->set->nr_cards; c++)
+                voodoo_scanout_sync(voodoo->set->voodoos[c]);
+}
+
+voodoo_scanout_t *voodoo_scanout_init(voodoo_t *voodoo) {
+        voodoo_scanout_t *scanout = malloc(sizeof(voodoo_scanout_t));
+        memset(scanout, 0, sizeof(voodoo_scanout_t));
+
+        scanout->voodoo = voodoo;
+
+        scanout->wake_event = thread_create_event();
+        scanout->done_event = thread_create_event();
+        scanout->thread = thread_create(voodoo_scanout_thread, scanout);
+
+        return scanout;
+}
+
+void voodoo_scanout_close(voodoo_scanout_t *scanout) {
+        thread_kill(scanout->thread);
+        thread_destroy_event(scanout->wake_event);
+        thread_destroy_event(scanout->done_event);
+
+        free(scanout);
+}
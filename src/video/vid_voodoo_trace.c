@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "device.h"
+#include "mem.h"
+#include "thread.h"
+#include "video.h"
+#include "vid_svga.h"
+#include "vid_voodoo.h"
+#include "vid_voodoo_common.h"
+#include "vid_voodoo_fifo.h"
+#include "vid_voodoo_regs.h"
+#include "vid_voodoo_render.h"
+#include "vid_voodoo_trace.h"
+
+int voodoo_trace_enabled = 0;
+char voodoo_trace_fn[512] = "pcem_voodoo.trc";
+int voodoo_trace_checksum_interval = 60;
+
+struct voodoo_trace_t {
+        FILE *f;
+        voodoo_set_t *set;
+        uint32_t frame;
+
+        /*Consecutive writel()s not yet written out*/
+        uint32_t burst_tag;
+        uint32_t burst_addr;
+        int burst_count;
+        uint32_t burst[VOODOO_TRACE_BURST_MAX];
+};
+
+static uint32_t voodoo_trace_tag(voodoo_t *voodoo, int type, uint32_t addr) {
+        uint32_t tag = (type << VOODOO_TRACE_TYPE_SHIFT) | (addr & VOODOO_TRACE_ADDR_MASK);
+
+        if (voodoo->set->nr_cards == 2 && voodoo == voodoo->set->voodoos[1])
+                tag |= VOODOO_TRACE_CARD;
+
+        return tag;
+}
+
+static void voodoo_trace_record(voodoo_trace_t *trace, uint32_t tag, uint32_t val) {
+        uint32_t record[2] = {tag, val};
+
+        fwrite(record, sizeof(record), 1, trace->f);
+}
+
+static void voodoo_trace_flush_burst(voodoo_trace_t *trace) {
+        if (trace->burst_count == 1)
+                voodoo_trace_record(trace, trace->burst_tag, trace->burst[0]);
+        else if (trace->burst_count) {
+                uint32_t tag = (trace->burst_tag & ~(0xf << VOODOO_TRACE_TYPE_SHIFT)) |
+                               (VOODOO_TRACE_WRITEL_BURST << VOODOO_TRACE_TYPE_SHIFT);
+
+                voodoo_trace_record(trace, tag, trace->burst_count);
+                fwrite(trace->burst, trace->burst_count * 4, 1, trace->f);
+        }
+        trace->burst_count = 0;
+}
+
+voodoo_trace_t *voodoo_trace_open(voodoo_set_t *set) {
+        voodoo_trace_header_t header;
+        voodoo_trace_t *trace;
+        voodoo_t *voodoo = set->voodoos[0];
+        FILE *f;
+
+        if (!voodoo_trace_enabled)
+                return NULL;
+
+        f = fopen(voodoo_trace_fn, "wb");
+        if (!f) {
+                pclog("voodoo_trace_open : can't open %s\n", voodoo_trace_fn);
+                return NULL;
+        }
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, VOODOO_TRACE_MAGIC, sizeof(header.magic));
+        header.version = VOODOO_TRACE_VERSION;
+        header.type = voodoo->type;
+        header.nr_cards = set->nr_cards;
+        header.fb_size = voodoo->fb_size;
+        header.texture_size = voodoo->texture_size;
+        if (voodoo->bilinear_enabled)
+                header.flags |= VOODOO_TRACE_BILINEAR;
+        if (voodoo->dithersub_enabled)
+                header.flags |= VOODOO_TRACE_DITHERSUB;
+        fwrite(&header, sizeof(header), 1, f);
+
+        trace = malloc(sizeof(voodoo_trace_t));
+        memset(trace, 0, sizeof(voodoo_trace_t));
+        trace->f = f;
+        trace->set = set;
+
+        return trace;
+}
+
+void voodoo_trace_close(voodoo_trace_t *trace) {
+        voodoo_trace_flush_burst(trace);
+        fclose(trace->f);
+        free(trace);
+}
+
+static void voodoo_trace_frame(voodoo_trace_t *trace, voodoo_t *voodoo) {
+        voodoo_set_t *set = trace->set;
+        int c;
+
+        voodoo_trace_record(trace, voodoo_trace_tag(voodoo, VOODOO_TRACE_FRAME, 0), trace->frame);
+
+        if (voodoo_trace_checksum_interval > 0 && !(trace->frame % voodoo_trace_checksum_interval)) {
+                for (c = 0; c < set->nr_cards; c++) {
+                        voodoo_trace_sync(set->voodoos[c]);
+                        voodoo_trace_record(trace, voodoo_trace_tag(set->voodoos[c], VOODOO_TRACE_CHECKSUM, 0),
+                                            voodoo_trace_checksum(set->voodoos[c]));
+                }
+        }
+
+        trace->frame++;
+}
+
+void voodoo_trace_writel(voodoo_t *voodoo, uint32_t addr, uint32_t val) {
+        voodoo_trace_t *trace = voodoo->set->trace;
+        uint32_t tag = voodoo_trace_tag(voodoo, VOODOO_TRACE_WRITEL, addr);
+
+        addr &= VOODOO_TRACE_ADDR_MASK;
+
+        if (trace->burst_count && (tag & VOODOO_TRACE_CARD) == (trace->burst_tag & VOODOO_TRACE_CARD) &&
+            addr == trace->burst_addr + trace->burst_count * 4 && trace->burst_count < VOODOO_TRACE_BURST_MAX) {
+                trace->burst[trace->burst_count++] = val;
+        } else {
+                voodoo_trace_flush_burst(trace);
+                trace->burst_tag = tag;
+                trace->burst_addr = addr;
+                trace->burst[0] = val;
+                trace->burst_count = 1;
+        }
+
+        /*A swap on the last card of an SLI pair ends the frame for both*/
+        if (!(addr & 0xc00000) && !((addr & 0x200000) && (voodoo->fbiInit7 & FBIINIT7_CMDFIFO_ENABLE)) &&
+            (addr & 0x3fc) == SST_swapbufferCMD && voodoo == voodoo->set->voodoos[voodoo->set->nr_cards - 1]) {
+                voodoo_trace_flush_burst(trace);
+                voodoo_trace_frame(trace, voodoo);
+        }
+}
+
+void voodoo_trace_writew(voodoo_t *voodoo, uint32_t addr, uint16_t val) {
+        voodoo_trace_t *trace = voodoo->set->trace;
+
+        voodoo_trace_flush_burst(trace);
+        voodoo_trace_record(trace, voodoo_trace_tag(voodoo, VOODOO_TRACE_WRITEW, addr), val);
+}
+
+void voodoo_trace_init_enable(voodoo_t *voodoo) {
+        voodoo_trace_t *trace = voodoo->set->trace;
+
+        voodoo_trace_flush_burst(trace);
+        voodoo_trace_record(trace, voodoo_trace_tag(voodoo, VOODOO_TRACE_INIT_ENABLE, 0), voodoo->initEnable);
+}
+
+/*With the CMDFIFO enabled the FIFO thread may be waiting part way through a
+  packet for words that haven't been written yet, so it is treated as idle once
+  it has read everything written so far*/
+static int voodoo_trace_idle(voodoo_t *voodoo) {
+        if (!FIFO_EMPTY || voodoo->swap_pending)
+                return 0;
+        if (voodoo->cmdfifo_enabled)
+                return voodoo->cmdfifo_depth_rd == voodoo->cmdfifo_depth_wr;
+        return !voodoo->voodoo_busy;
+}
+
+void voodoo_trace_sync(voodoo_t *voodoo) {
+        voodoo_lfb_span_commit(voodoo);
+        voodoo->flush = 1;
+        while (!voodoo_trace_idle(voodoo)) {
+                voodoo_wake_fifo_thread_now(voodoo);
+                thread_wait_event(voodoo->fifo_not_full_event, 1);
+        }
+        voodoo_wait_for_render_thread_idle(voodoo);
+        voodoo->flush = 0;
+}
+
+/*FNV-1a over 32-bit words*/
+uint32_t voodoo_trace_checksum(voodoo_t *voodoo) {
+        uint32_t *p = (uint32_t *)voodoo->fb_mem;
+        uint32_t hash = 0x811c9dc5;
+        int c;
+
+        for (c = 0; c < (voodoo->fb_size << 20) / 4; c++)
+                hash = (hash ^ p[c]) * 0x01000193;
+
+        return hash;
+}
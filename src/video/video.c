@@ -5,6 +5,7 @@
 #include "device.h"
 #include "mem.h"
 #include "video.h"
+#include "video_capture.h"
 #include "vid_svga.h"
 #include "io.h"
 #include "cpu.h"
@@ -546,6 +547,17 @@ int frames = 0;
 int video_frames = 0;
 int video_refresh_rate = 0;
 
+int video_frameskip_max = 0;
+volatile int video_frames_skipped = 0;
+
+/*Start skipping once the average lag is over one 10 ms emulation slice, and
+  stop once it drops back under a fifth of that*/
+#define FRAMESKIP_LAG_ON 10
+#define FRAMESKIP_LAG_OFF 2
+
+static int frameskip_lag; /*Average lag, in 1/16 ms*/
+static int frameskip_active;
+
 int fullchange;
 
 uint8_t edatlookup[4][4];
@@ -1036,6 +1048,7 @@ void loadfont(char *s, fontformat_t format) {
 
 static struct {
         int x, y, y1, y2, w, h;
+        uint64_t capture_time;
         int busy;
         int buffer_in_use;
 
@@ -1108,7 +1121,15 @@ static void blit_thread(void *param) {
                 thread_wait_event(blit_data.wake_blit_thread, -1);
                 thread_reset_event(blit_data.wake_blit_thread);
 
-                video_blit_memtoscreen_func(blit_data.x, blit_data.y, blit_data.y1, blit_data.y2, blit_data.w, blit_data.h);
+                if (capture_active)
+                        capture_video_frame(blit_data.x, blit_data.y, blit_data.w, blit_data.h, blit_data.y1 != blit_data.y2,
+                                            blit_data.capture_time);
+
+                if (video_blit_memtoscreen_func)
+                        video_blit_memtoscreen_func(blit_data.x, blit_data.y, blit_data.y1, blit_data.y2, blit_data.w,
+                                                    blit_data.h);
+                else
+                        video_blit_complete(); /*No frontend*/
 
                 blit_data.busy = 0;
                 thread_set_event(blit_data.blit_complete);
@@ -1131,6 +1152,29 @@ void video_wait_for_buffer() {
         thread_reset_event(blit_data.buffer_not_in_use);
 }
 
+void video_frameskip_update(int lag) {
+        if (lag < 0)
+                lag = 0;
+        frameskip_lag += lag - (frameskip_lag >> 4);
+
+        if (frameskip_lag > FRAMESKIP_LAG_ON * 16)
+                frameskip_active = 1;
+        else if (frameskip_lag < FRAMESKIP_LAG_OFF * 16)
+                frameskip_active = 0;
+}
+
+int video_frameskip(int *count) {
+        if (frameskip_active && *count < video_frameskip_max) {
+                (*count)++;
+                video_frames_skipped++;
+                video_frames++;
+                return 1;
+        }
+
+        *count = 0;
+        return 0;
+}
+
 void video_blit_memtoscreen(int x, int y, int y1, int y2, int w, int h) {
         video_frames++;
         if (h <= 0)
@@ -1144,6 +1188,8 @@ void video_blit_memtoscreen(int x, int y, int y1, int y2, int w, int h) {
         blit_data.y2 = y2;
         blit_data.w = w;
         blit_data.h = h;
+        if (capture_active)
+                blit_data.capture_time = capture_time();
         thread_set_event(blit_data.wake_blit_thread);
 }
 
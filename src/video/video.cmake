@@ -1,5 +1,6 @@
 set(PCEM_PRIVATE_API ${PCEM_PRIVATE_API}
         ${CMAKE_SOURCE_DIR}/includes/private/video/video.h
+        ${CMAKE_SOURCE_DIR}/includes/private/video/video_capture.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_et4000.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_et4000w32.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_genius.h
@@ -27,6 +28,7 @@ set(PCEM_PRIVATE_API ${PCEM_PRIVATE_API}
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_sigma.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_stg_ramdac.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_svga.h
+        ${CMAKE_SOURCE_DIR}/includes/private/video/vid_svga_compose.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_svga_render.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_svga_render_remap.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_t1000.h
@@ -42,6 +44,7 @@ set(PCEM_PRIVATE_API ${PCEM_PRIVATE_API}
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_banshee_blitter.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_banshee.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_blitter.h
+        ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_codegen_cache.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_codegen_x86-64.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_codegen_x86.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_common.h
@@ -53,8 +56,11 @@ set(PCEM_PRIVATE_API ${PCEM_PRIVATE_API}
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_reg.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_regs.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_render.h
+        ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_render_vec.h
+        ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_scanout.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_setup.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_texture.h
+        ${CMAKE_SOURCE_DIR}/includes/private/video/vid_voodoo_trace.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_wy700.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_ati18800.h
         ${CMAKE_SOURCE_DIR}/includes/private/video/vid_ati28800.h
@@ -112,6 +118,7 @@ set(PCEM_SRC ${PCEM_SRC}
         video/vid_sigma.c
         video/vid_stg_ramdac.c
         video/vid_svga.c
+        video/vid_svga_compose.c
         video/vid_svga_render.c
         video/vid_t1000.c
         video/vid_t3100e.c
@@ -132,8 +139,11 @@ set(PCEM_SRC ${PCEM_SRC}
         video/vid_voodoo_fifo.c
         video/vid_voodoo_reg.c
         video/vid_voodoo_render.c
+        video/vid_voodoo_scanout.c
         video/vid_voodoo_setup.c
         video/vid_voodoo_texture.c
+        video/vid_voodoo_trace.c
         video/vid_wy700.c
         video/video.c
+        video/video_capture.c
         )
\ No newline at end of file
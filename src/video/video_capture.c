@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ibm.h"
+#include "sound.h"
+#include "sound_out.h"
+#include "thread.h"
+#include "video.h"
+#include "video_capture.h"
+
+#define FREQ 48000
+
+/*Audio ring size in stereo frames. Must be a power of 2*/
+#define AUDIO_RING_SIZE 65536
+#define AUDIO_RING_MASK (AUDIO_RING_SIZE - 1)
+
+int capture_enabled = 0;
+int capture_format = CAPTURE_FORMAT_RAW;
+char capture_fn[512] = "pcem_capture";
+int capture_changed_only = 0;
+int capture_buffers = 8;
+int capture_fps = 60;
+
+volatile int capture_active;
+volatile int capture_dropped_frames, capture_dropped_audio;
+
+static int capture_open_failed;
+
+typedef struct capture_frame_t {
+        uint32_t *dat;
+        int size; /*Allocated pixels*/
+        int w, h;
+        uint64_t time;
+        int dropped; /*capture_dropped_frames when this frame was queued*/
+} capture_frame_t;
+
+/*Frame ring, filled by the blit thread*/
+static capture_frame_t frame_ring[CAPTURE_MAX_BUFFERS];
+static int nr_frames;
+static volatile uint32_t frame_read, frame_write;
+/*Set once a frame has been queued, so the first frame is always captured*/
+static int have_frame;
+
+/*Audio ring, filled by the emulation thread*/
+static int16_t audio_ring[AUDIO_RING_SIZE * 2];
+static volatile uint32_t audio_read, audio_write;
+/*Frames of mixer output since the capture started, whether queued or dropped*/
+static uint64_t audio_frames;
+
+static thread_t *encoder_thread;
+static event_t *encoder_event;
+static volatile int encoder_running, encoder_done;
+
+/*Encoder thread state*/
+static FILE *video_f, *index_f, *audio_f;
+static uint32_t audio_bytes;
+static int frame_nr;
+static int y4m_w, y4m_h, y4m_file_nr;
+static uint8_t *y4m_pending; /*Last frame converted to YUV, not yet written*/
+static int y4m_have_pending;
+static uint64_t y4m_out_frames;
+static uint8_t *png_buf;
+static int png_buf_size;
+static uint32_t png_crc_table[256];
+
+static FILE *capture_fopen(const char *suffix) {
+        char fn[600];
+        FILE *f;
+
+        snprintf(fn, sizeof(fn), "%s%s", capture_fn, suffix);
+        f = fopen(fn, "wb");
+        if (!f)
+                pclog("capture : can't open %s\n", fn);
+        return f;
+}
+
+/*Y4M output*/
+static void capture_y4m_open() {
+        char suffix[32];
+
+        if (y4m_file_nr)
+                snprintf(suffix, sizeof(suffix), "_%i.y4m", y4m_file_nr);
+        else
+                snprintf(suffix, sizeof(suffix), ".y4m");
+        y4m_file_nr++;
+
+        video_f = capture_fopen(suffix);
+        if (video_f)
+                fprintf(video_f, "YUV4MPEG2 W%i H%i F%i:1 Ip A1:1 C444\n", y4m_w, y4m_h, capture_fps);
+}
+
+static void capture_y4m_write_pending() {
+        if (video_f) {
+                fwrite("FRAME\n", 6, 1, video_f);
+                fwrite(y4m_pending, y4m_w * y4m_h * 3, 1, video_f);
+        }
+        y4m_out_frames++;
+}
+
+/*BT.601 studio range*/
+static void capture_y4m_convert(uint8_t *dest, capture_frame_t *frame) {
+        int size = frame->w * frame->h;
+        uint8_t *y = dest, *u = &dest[size], *v = &dest[size * 2];
+        int c;
+
+        for (c = 0; c < size; c++) {
+                int r = (frame->dat[c] >> 16) & 0xff;
+                int g = (frame->dat[c] >> 8) & 0xff;
+                int b = frame->dat[c] & 0xff;
+
+                y[c] = 16 + ((66 * r + 129 * g + 25 * b + 128) >> 8);
+                u[c] = 128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8);
+                v[c] = 128 + ((112 * r - 94 * g - 18 * b + 128) >> 8);
+        }
+}
+
+/*Output runs at a constant capture_fps. Each frame is held until the next one
+  arrives, then written once for every output frame period it covered*/
+static void capture_y4m_frame(capture_frame_t *frame) {
+        uint64_t out_frame = (frame->time * capture_fps) / 1000000;
+
+        if (frame->w != y4m_w || frame->h != y4m_h) {
+                if (y4m_have_pending)
+                        capture_y4m_write_pending();
+                if (video_f)
+                        fclose(video_f);
+
+                y4m_w = frame->w;
+                y4m_h = frame->h;
+                y4m_pending = realloc(y4m_pending, y4m_w * y4m_h * 3);
+                y4m_have_pending = 0;
+                capture_y4m_open();
+        } else if (y4m_have_pending) {
+                while (y4m_out_frames < out_frame)
+                        capture_y4m_write_pending();
+        }
+
+        if (!y4m_have_pending)
+                y4m_out_frames = out_frame;
+        capture_y4m_convert(y4m_pending, frame);
+        y4m_have_pending = 1;
+}
+
+/*PNG output. Image data is zlib wrapped but stored uncompressed, which is
+  quick enough that the encoder keeps up with full frame rate capture*/
+#define PNG_STORED_BLOCK 65535
+
+static uint32_t capture_png_crc(uint32_t crc, const uint8_t *p, int len) {
+        int c;
+
+        crc = ~crc;
+        for (c = 0; c < len; c++)
+                crc = png_crc_table[(crc ^ p[c]) & 0xff] ^ (crc >> 8);
+        return ~crc;
+}
+
+static void capture_png_put32(uint8_t *p, uint32_t val) {
+        p[0] = val >> 24;
+        p[1] = val >> 16;
+        p[2] = val >> 8;
+        p[3] = val;
+}
+
+static void capture_png_chunk(FILE *f, const char *type, const uint8_t *data, int len) {
+        uint8_t header[8];
+        uint8_t crc_bytes[4];
+        uint32_t crc;
+
+        capture_png_put32(header, len);
+        memcpy(&header[4], type, 4);
+        crc = capture_png_crc(0, &header[4], 4);
+        crc = capture_png_crc(crc, data, len);
+        capture_png_put32(crc_bytes, crc);
+
+        fwrite(header, 8, 1, f);
+        fwrite(data, len, 1, f);
+        fwrite(crc_bytes, 4, 1, f);
+}
+
+static void capture_png_frame(capture_frame_t *frame) {
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        int stride = frame->w * 3 + 1;
+        int raw_len = stride * frame->h;
+        int nr_blocks = (raw_len + PNG_STORED_BLOCK - 1) / PNG_STORED_BLOCK;
+        int idat_len = 2 + nr_blocks * 5 + raw_len + 4;
+        uint32_t adler_a = 1, adler_b = 0;
+        uint8_t ihdr[13];
+        uint8_t *p, *raw;
+        char suffix[32];
+        FILE *f;
+        int x, y, c;
+
+        if (png_buf_size < idat_len) {
+                png_buf_size = idat_len;
+                png_buf = realloc(png_buf, png_buf_size);
+        }
+
+        /*Scanlines go at the end of the buffer, and are moved into stored
+          blocks in place*/
+        raw = &png_buf[idat_len - raw_len - 4];
+        for (y = 0; y < frame->h; y++) {
+                uint32_t *src = &frame->dat[y * frame->w];
+
+                p = &raw[y * stride];
+                *p++ = 0; /*No filter*/
+                for (x = 0; x < frame->w; x++) {
+                        *p++ = src[x] >> 16;
+                        *p++ = src[x] >> 8;
+                        *p++ = src[x];
+                }
+        }
+        for (c = 0; c < raw_len; c++) {
+                adler_a = (adler_a + raw[c]) % 65521;
+                adler_b = (adler_b + adler_a) % 65521;
+        }
+
+        p = png_buf;
+        *p++ = 0x78; /*Deflate, 32k window*/
+        *p++ = 0x01;
+        for (c = 0; c < nr_blocks; c++) {
+                int len = raw_len - c * PNG_STORED_BLOCK;
+
+                if (len > PNG_STORED_BLOCK)
+                        len = PNG_STORED_BLOCK;
+                *p++ = (c == nr_blocks - 1) ? 1 : 0;
+                *p++ = len;
+                *p++ = len >> 8;
+                *p++ = ~len;
+                *p++ = ~len >> 8;
+                memmove(p, &raw[c * PNG_STORED_BLOCK], len);
+                p += len;
+        }
+        capture_png_put32(p, (adler_b << 16) | adler_a);
+
+        capture_png_put32(&ihdr[0], frame->w);
+        capture_png_put32(&ihdr[4], frame->h);
+        ihdr[8] = 8; /*Bit depth*/
+        ihdr[9] = 2; /*RGB*/
+        ihdr[10] = ihdr[11] = ihdr[12] = 0;
+
+        snprintf(suffix, sizeof(suffix), "_%06i.png", frame_nr);
+        f = capture_fopen(suffix);
+        if (!f)
+                return;
+        fwrite(signature, 8, 1, f);
+        capture_png_chunk(f, "IHDR", ihdr, 13);
+        capture_png_chunk(f, "IDAT", png_buf, idat_len);
+        capture_png_chunk(f, "IEND", NULL, 0);
+        fclose(f);
+}
+
+static void capture_encode_frame(capture_frame_t *frame) {
+        switch (capture_format) {
+        case CAPTURE_FORMAT_RAW:
+                if (video_f)
+                        fwrite(frame->dat, frame->w * frame->h * 4, 1, video_f);
+                break;
+        case CAPTURE_FORMAT_Y4M:
+                capture_y4m_frame(frame);
+                break;
+        case CAPTURE_FORMAT_PNG:
+                capture_png_frame(frame);
+                break;
+        }
+
+        if (index_f)
+                fprintf(index_f, "%i,%llu,%i,%i,%i\n", frame_nr, (unsigned long long)frame->time, frame->w, frame->h,
+                        frame->dropped);
+        frame_nr++;
+}
+
+static void capture_encode_audio() {
+        uint32_t read = audio_read;
+        uint32_t write = __atomic_load_n(&audio_write, __ATOMIC_ACQUIRE);
+
+        while (read != write) {
+                int len = AUDIO_RING_SIZE - (read & AUDIO_RING_MASK);
+
+                if (len > (int)(write - read))
+                        len = write - read;
+                if (audio_f) {
+                        fwrite(&audio_ring[(read & AUDIO_RING_MASK) * 2], len * 4, 1, audio_f);
+                        audio_bytes += len * 4;
+                }
+                read += len;
+        }
+
+        __atomic_store_n(&audio_read, read, __ATOMIC_RELEASE);
+}
+
+static void capture_encode_frames() {
+        uint32_t read = frame_read;
+        uint32_t write = __atomic_load_n(&frame_write, __ATOMIC_ACQUIRE);
+
+        while (read != write) {
+                capture_encode_frame(&frame_ring[read % nr_frames]);
+                read++;
+                __atomic_store_n(&frame_read, read, __ATOMIC_RELEASE);
+        }
+}
+
+static void capture_encoder_thread(void *param) {
+        while (encoder_running) {
+                thread_wait_event(encoder_event, 100);
+                thread_reset_event(encoder_event);
+
+                capture_encode_audio();
+                capture_encode_frames();
+        }
+
+        /*Write out whatever is left*/
+        capture_encode_audio();
+        capture_encode_frames();
+
+        encoder_done = 1;
+}
+
+static void capture_start() {
+        int c, d;
+
+        for (c = 0; c < 256; c++) {
+                uint32_t crc = c;
+
+                for (d = 0; d < 8; d++)
+                        crc = (crc & 1) ? (0xedb88320 ^ (crc >> 1)) : (crc >> 1);
+                png_crc_table[c] = crc;
+        }
+
+        nr_frames = capture_buffers;
+        if (nr_frames < 2)
+                nr_frames = 2;
+        if (nr_frames > CAPTURE_MAX_BUFFERS)
+                nr_frames = CAPTURE_MAX_BUFFERS;
+        if (capture_fps < 1)
+                capture_fps = 1;
+
+        index_f = capture_fopen(".csv");
+        if (!index_f) {
+                capture_open_failed = 1;
+                return;
+        }
+        fprintf(index_f, "frame,time_us,width,height,dropped\n");
+
+        if (capture_format == CAPTURE_FORMAT_RAW)
+                video_f = capture_fopen(".raw");
+        audio_f = capture_fopen(".wav");
+        if (audio_f) {
+                audio_bytes = 0;
+                sound_out_wav_header(audio_f, audio_bytes);
+        }
+
+        frame_read = frame_write = 0;
+        have_frame = 0;
+        audio_read = audio_write = 0;
+        audio_frames = 0;
+        capture_dropped_frames = capture_dropped_audio = 0;
+        frame_nr = 0;
+        y4m_w = y4m_h = y4m_file_nr = 0;
+        y4m_have_pending = 0;
+        y4m_out_frames = 0;
+
+        encoder_event = thread_create_event();
+        encoder_running = 1;
+        encoder_done = 0;
+        encoder_thread = thread_create(capture_encoder_thread, NULL);
+
+        capture_active = 1;
+}
+
+void capture_audio(int32_t *buf, int len) {
+        uint32_t write, read;
+        int first;
+
+        if (!capture_active) {
+                if (!capture_enabled || capture_open_failed)
+                        return;
+                capture_start();
+                if (!capture_active)
+                        return;
+        }
+
+        audio_frames += len;
+
+        write = audio_write;
+        read = __atomic_load_n(&audio_read, __ATOMIC_ACQUIRE);
+        if (AUDIO_RING_SIZE - (int)(write - read) < len) {
+                capture_dropped_audio += len;
+                return;
+        }
+
+        first = AUDIO_RING_SIZE - (write & AUDIO_RING_MASK);
+        if (first > len)
+                first = len;
+        sound_out_convert(&audio_ring[(write & AUDIO_RING_MASK) * 2], buf, first * 2);
+        if (first < len)
+                sound_out_convert(audio_ring, &buf[first * 2], (len - first) * 2);
+
+        __atomic_store_n(&audio_write, write + len, __ATOMIC_RELEASE);
+        thread_set_event(encoder_event);
+}
+
+uint64_t capture_time() { return ((audio_frames + sound_pos_global) * 1000000) / FREQ; }
+
+void capture_video_frame(int x, int y, int w, int h, int changed, uint64_t time) {
+        uint32_t write = frame_write;
+        capture_frame_t *frame;
+        int yy;
+
+        if (!capture_active)
+                return;
+        if (capture_changed_only && !changed && have_frame)
+                return;
+        if ((int)(write - __atomic_load_n(&frame_read, __ATOMIC_ACQUIRE)) >= nr_frames) {
+                capture_dropped_frames++;
+                return;
+        }
+
+        frame = &frame_ring[write % nr_frames];
+        if (frame->size < w * h) {
+                frame->size = w * h;
+                frame->dat = realloc(frame->dat, frame->size * 4);
+        }
+        frame->w = w;
+        frame->h = h;
+        frame->time = time;
+        frame->dropped = capture_dropped_frames;
+        for (yy = 0; yy < h; yy++) {
+                if ((y + yy) >= 0 && (y + yy) < buffer32->h)
+                        memcpy(&frame->dat[yy * w], &((uint32_t *)buffer32->line[y + yy])[x], w * 4);
+                else
+                        memset(&frame->dat[yy * w], 0, w * 4);
+        }
+        have_frame = 1;
+
+        __atomic_store_n(&frame_write, write + 1, __ATOMIC_RELEASE);
+        thread_set_event(encoder_event);
+}
+
+void capture_close() {
+        int c;
+
+        capture_open_failed = 0;
+        if (!capture_active)
+                return;
+
+        /*Let any frame the blit thread is copying land in the ring first*/
+        capture_active = 0;
+        video_wait_for_blit();
+
+        encoder_running = 0;
+        thread_set_event(encoder_event);
+        while (!encoder_done)
+                thread_sleep(1);
+        thread_kill(encoder_thread);
+        thread_destroy_event(encoder_event);
+        encoder_thread = NULL;
+
+        if (y4m_have_pending)
+                capture_y4m_write_pending();
+        if (video_f) {
+                fclose(video_f);
+                video_f = NULL;
+        }
+        if (index_f) {
+                fclose(index_f);
+                index_f = NULL;
+        }
+        if (audio_f) {
+                sound_out_wav_header(audio_f, audio_bytes);
+                fclose(audio_f);
+                audio_f = NULL;
+        }
+
+        for (c = 0; c < CAPTURE_MAX_BUFFERS; c++) {
+                free(frame_ring[c].dat);
+                frame_ring[c].dat = NULL;
+                frame_ring[c].size = 0;
+        }
+        free(y4m_pending);
+        y4m_pending = NULL;
+        free(png_buf);
+        png_buf = NULL;
+        png_buf_size = 0;
+
+        pclog("capture_close : %i frames, %i frames dropped, %i audio frames dropped\n", frame_nr, capture_dropped_frames,
+              capture_dropped_audio);
+}
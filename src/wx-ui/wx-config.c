@@ -450,6 +450,7 @@ int config_dlgsave(void *hdlg) {
         int temp_cpu, temp_cpu_m, temp_model, temp_fpu;
         int temp_GAMEBLASTER, temp_GUS, temp_SSI2001, temp_voodoo, temp_sound_card_current;
         int temp_dynarec;
+        int temp_808x_fast;
         int temp_fda_type, temp_fdb_type;
         int temp_mouse_type;
         int temp_lpt1_device;
@@ -509,6 +510,9 @@ int config_dlgsave(void *hdlg) {
         h = wx_getdlgitem(hdlg, WX_ID("IDC_CHECKDYNAREC"));
         temp_dynarec = wx_sendmessage(h, WX_BM_GETCHECK, 0, 0);
 
+        h = wx_getdlgitem(hdlg, WX_ID("IDC_CHECK808XFAST"));
+        temp_808x_fast = wx_sendmessage(h, WX_BM_GETCHECK, 0, 0);
+
         h = wx_getdlgitem(hdlg, WX_ID("IDC_COMBODRA"));
         temp_fda_type = wx_sendmessage(h, WX_CB_GETCURSEL, 0, 0);
         h = wx_getdlgitem(hdlg, WX_ID("IDC_COMBODRB"));
@@ -535,8 +539,9 @@ int config_dlgsave(void *hdlg) {
 
         if (temp_model != model || gfx != gfxcard || mem != mem_size || temp_fpu != fpu_type || temp_GAMEBLASTER != GAMEBLASTER ||
             temp_GUS != GUS || temp_SSI2001 != SSI2001 || temp_sound_card_current != sound_card_current ||
-            temp_voodoo != voodoo_enabled || temp_dynarec != cpu_use_dynarec || temp_fda_type != fdd_get_type(0) ||
-            temp_fdb_type != fdd_get_type(1) || temp_mouse_type != mouse_type || hdd_changed || hd_changed ||
+            temp_voodoo != voodoo_enabled || temp_dynarec != cpu_use_dynarec || temp_808x_fast != cpu_808x_fast ||
+            temp_fda_type != fdd_get_type(0) || temp_fdb_type != fdd_get_type(1) || temp_mouse_type != mouse_type || hdd_changed ||
+            hd_changed ||
             cdrom_channel != new_cdrom_channel || zip_channel != new_zip_channel || lpt1_current != temp_lpt1_device
 #ifdef USE_NETWORKING
             || temp_network_card != network_card_current
@@ -558,6 +563,7 @@ int config_dlgsave(void *hdlg) {
                         lpt1_current = temp_lpt1_device;
                         voodoo_enabled = temp_voodoo;
                         cpu_use_dynarec = temp_dynarec;
+                        cpu_808x_fast = temp_808x_fast;
                         mouse_type = temp_mouse_type;
                         strcpy(lpt1_device_name, lpt_device_get_internal_name(temp_lpt1_device));
 #ifdef USE_NETWORKING
@@ -832,6 +838,13 @@ int config_dlgproc(void *hdlg, int message, INT_PARAM wParam, LONG_PARAM lParam)
                 else
                         wx_enablewindow(h, FALSE);
 
+                h = wx_getdlgitem(hdlg, WX_ID("IDC_CHECK808XFAST"));
+                wx_sendmessage(h, WX_BM_SETCHECK, cpu_808x_fast, 0);
+                if (cpu_type <= CPU_8086)
+                        wx_enablewindow(h, TRUE);
+                else
+                        wx_enablewindow(h, FALSE);
+
                 h = wx_getdlgitem(hdlg, WX_ID("IDC_COMBOMOUSE"));
                 c = d = 0;
                 while (1) {
@@ -1001,6 +1014,12 @@ int config_dlgproc(void *hdlg, int message, INT_PARAM wParam, LONG_PARAM lParam)
                         else
                                 wx_enablewindow(h, FALSE);
 
+                        h = wx_getdlgitem(hdlg, WX_ID("IDC_CHECK808XFAST"));
+                        if (cpu_type <= CPU_8086)
+                                wx_enablewindow(h, TRUE);
+                        else
+                                wx_enablewindow(h, FALSE);
+
                         h = wx_getdlgitem(hdlg, WX_ID("IDC_CONFIGUREMOD"));
                         if (model_getdevice(temp_model))
                                 wx_enablewindow(h, TRUE);
@@ -1095,6 +1114,12 @@ int config_dlgproc(void *hdlg, int message, INT_PARAM wParam, LONG_PARAM lParam)
                         else
                                 wx_enablewindow(h, FALSE);
 
+                        h = wx_getdlgitem(hdlg, WX_ID("IDC_CHECK808XFAST"));
+                        if (cpu_type <= CPU_8086)
+                                wx_enablewindow(h, TRUE);
+                        else
+                                wx_enablewindow(h, FALSE);
+
                 } else if (wParam == WX_ID("IDC_COMBO3")) {
                         h = wx_getdlgitem(hdlg, WX_ID("IDC_COMBO1"));
                         temp_model = listtomodel[wx_sendmessage(h, WX_CB_GETCURSEL, 0, 0)];
@@ -1127,6 +1152,12 @@ int config_dlgproc(void *hdlg, int message, INT_PARAM wParam, LONG_PARAM lParam)
                                 wx_enablewindow(h, TRUE);
                         else
                                 wx_enablewindow(h, FALSE);
+
+                        h = wx_getdlgitem(hdlg, WX_ID("IDC_CHECK808XFAST"));
+                        if (cpu_type <= CPU_8086)
+                                wx_enablewindow(h, TRUE);
+                        else
+                                wx_enablewindow(h, FALSE);
                 } else if (wParam == WX_ID("IDC_CONFIGUREMOD")) {
                         h = wx_getdlgitem(hdlg, WX_ID("IDC_COMBO1"));
                         temp_model = listtomodel[wx_sendmessage(h, WX_CB_GETCURSEL, 0, 0)];
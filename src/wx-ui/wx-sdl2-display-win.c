@@ -4,6 +4,7 @@
 #include "wx-sdl2-video.h"
 #include "wx-utils.h"
 #include "ibm.h"
+#include "io_profiler.h"
 #include "mouse.h"
 #include "wx-display.h"
 #include "plat-keyboard.h"
@@ -63,6 +64,7 @@ int trigger_fullscreen = 0;
 int trigger_screenshot = 0;
 int trigger_togglewindow = 0;
 int trigger_inputrelease = 0;
+int trigger_ioprofile = 0;
 
 extern void device_force_redraw();
 extern void mouse_wheel_update(int);
@@ -753,6 +755,13 @@ int render() {
         else if (trigger_screenshot) {
                 trigger_screenshot = 0;
                 take_screenshot = 1;
+        } else if ((rawinputkey[sdl_scancode(SDL_SCANCODE_HOME)] || rawinputkey[sdl_scancode(SDL_SCANCODE_KP_7)]) &&
+                   (rawinputkey[sdl_scancode(SDL_SCANCODE_LCTRL)] || rawinputkey[sdl_scancode(SDL_SCANCODE_RCTRL)]) &&
+                   (rawinputkey[sdl_scancode(SDL_SCANCODE_LALT)] || rawinputkey[sdl_scancode(SDL_SCANCODE_RALT)]))
+                trigger_ioprofile = 1;
+        else if (trigger_ioprofile) {
+                trigger_ioprofile = 0;
+                io_profiler_request_report();
         } else if ((rawinputkey[sdl_scancode(SDL_SCANCODE_END)] || rawinputkey[sdl_scancode(SDL_SCANCODE_KP_1)]) &&
                    (rawinputkey[sdl_scancode(SDL_SCANCODE_LCTRL)] || rawinputkey[sdl_scancode(SDL_SCANCODE_RCTRL)]))
                 trigger_inputrelease = 1;
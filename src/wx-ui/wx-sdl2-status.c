@@ -15,6 +15,7 @@
 #include "cdrom-image.h"
 #include "scsi_zip.h"
 #include "codegen_allocator.h"
+#include "sound_out.h"
 #include "wx-common.h"
 
 drive_info_t drive_info[10];
@@ -121,6 +122,8 @@ int get_status(char *machine, char *device) {
                 "Render time : %f%% (%f%%)\n"
                 "Renderer: %s\n"
                 "Render FPS: %d\n"
+                "Audio underruns : %i\n"
+                "Audio overruns : %i\n"
                 "\n"
 
                 "New blocks : %i\nOld blocks : %i\nRecompiled speed : %f MIPS\nAverage size : %f\n"
@@ -135,7 +138,7 @@ int get_status(char *machine, char *device) {
                 segareads, segawrites, cpu_get_speed() - scycles_lost, pit_timer0_freq(),
                 ((double)main_time * 100.0) / status_diff, ((double)main_time * 100.0) / timer_freq,
                 ((double)render_time * 100.0) / status_diff, ((double)render_time * 100.0) / timer_freq,
-                current_render_driver_name, render_fps, cpu_new_blocks_latched, cpu_recomp_blocks_latched,
+                current_render_driver_name, render_fps, sound_out_underruns, sound_out_overruns, cpu_new_blocks_latched, cpu_recomp_blocks_latched,
                 (double)cpu_recomp_ins_latched / 1000000.0, (double)cpu_recomp_ins_latched / cpu_recomp_blocks_latched,
                 cpu_recomp_flushes_latched, cpu_recomp_evicted_latched, cpu_recomp_reuse_latched, cpu_recomp_removed_latched,
 
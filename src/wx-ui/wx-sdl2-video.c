@@ -10,8 +10,6 @@
 #include "wx-sdl2-video-gl3.h"
 #include "wx-sdl2-video-renderer.h"
 
-void video_blit_complete();
-
 VIDEO_BITMAP *screen;
 static VIDEO_BITMAP *screen_copy = NULL;
 static SDL_Rect screen_rect;
@@ -20,6 +18,11 @@ static SDL_Rect updated_rect_copy;
 static SDL_Rect blit_rect;
 static SDL_Rect texture_rect;
 static int updated = 0;
+/*Source position of the last blit. Rows of screen are only compared against
+  buffer32 while this and the size stay the same, and the renderer hasn't been
+  recreated since (blit_full clear)*/
+static int blit_x, blit_y;
+static int blit_full = 1;
 
 static SDL_mutex *blitMutex = NULL;
 
@@ -158,10 +161,17 @@ void sdl_scale(int scale, SDL_Rect src, SDL_Rect *dst, int w, int h) {
 
 static void set_updated_size(int x, int y, int w, int h) {
         if (updated) {
+                int x2 = updated_rect.x + updated_rect.w;
+                int y2 = updated_rect.y + updated_rect.h;
+
+                if (x + w > x2)
+                        x2 = x + w;
+                if (y + h > y2)
+                        y2 = y + h;
                 updated_rect.x = x < updated_rect.x ? x : updated_rect.x;
                 updated_rect.y = y < updated_rect.y ? y : updated_rect.y;
-                updated_rect.w = w > updated_rect.w ? w : updated_rect.w;
-                updated_rect.h = h > updated_rect.h ? h : updated_rect.h;
+                updated_rect.w = x2 - updated_rect.x;
+                updated_rect.h = y2 - updated_rect.y;
         } else {
                 updated_rect.x = x;
                 updated_rect.y = y;
@@ -171,6 +181,34 @@ static void set_updated_size(int x, int y, int w, int h) {
         }
 }
 
+/*Pixels compared at a time when looking for the changed part of a row*/
+#define BLIT_COMPARE_BLOCK 16
+
+/*Copy the part of a row that differs from what screen already holds. Returns
+  the first changed pixel and sets *x2 to one past the last, or returns -1 if
+  the row is unchanged*/
+static int sdl_blit_line(uint32_t *dest, const uint32_t *src, int w, int *x2) {
+        int x1 = 0;
+        int x = w;
+
+        while (x1 + BLIT_COMPARE_BLOCK <= w && !memcmp(&dest[x1], &src[x1], BLIT_COMPARE_BLOCK * 4))
+                x1 += BLIT_COMPARE_BLOCK;
+        while (x1 < w && dest[x1] == src[x1])
+                x1++;
+        if (x1 == w)
+                return -1;
+
+        while (x - BLIT_COMPARE_BLOCK > x1 &&
+               !memcmp(&dest[x - BLIT_COMPARE_BLOCK], &src[x - BLIT_COMPARE_BLOCK], BLIT_COMPARE_BLOCK * 4))
+                x -= BLIT_COMPARE_BLOCK;
+        while (dest[x - 1] == src[x - 1])
+                x--;
+
+        memcpy(&dest[x1], &src[x1], (x - x1) * 4);
+        *x2 = x;
+        return x1;
+}
+
 static void sdl_blit_memtoscreen(int x, int y, int y1, int y2, int w, int h) {
         if (y1 == y2) {
                 video_blit_complete();
@@ -179,11 +217,42 @@ static void sdl_blit_memtoscreen(int x, int y, int y1, int y2, int w, int h) {
 
         int yy;
         SDL_LockMutex(blitMutex);
-        for (yy = y1; yy < y2; yy++) {
-                if ((y + yy) >= 0 && (y + yy) < buffer32->h)
-                        memcpy(screen->dat + (yy * screen->w * 4), &(((uint32_t *)buffer32->line[y + yy])[x]), w * 4);
+        if (blit_full || x != blit_x || y != blit_y || w != blit_rect.w || h != blit_rect.h) {
+                /*Layout changed, so screen can't be compared against*/
+                for (yy = y1; yy < y2; yy++) {
+                        if ((y + yy) >= 0 && (y + yy) < buffer32->h)
+                                memcpy(screen->dat + (yy * screen->w * 4), &(((uint32_t *)buffer32->line[y + yy])[x]), w * 4);
+                }
+                set_updated_size(0, y1, w, y2 - y1);
+        } else {
+                /*Only copy and upload the pixels that changed since the last blit*/
+                int dirty_x1 = w, dirty_x2 = 0;
+                int dirty_y1 = -1, dirty_y2 = 0;
+
+                for (yy = y1; yy < y2; yy++) {
+                        if ((y + yy) >= 0 && (y + yy) < buffer32->h) {
+                                int line_x1, line_x2;
+
+                                line_x1 = sdl_blit_line((uint32_t *)(screen->dat + (yy * screen->w * 4)),
+                                                        &(((uint32_t *)buffer32->line[y + yy])[x]), w, &line_x2);
+                                if (line_x1 == -1)
+                                        continue;
+
+                                if (dirty_y1 == -1)
+                                        dirty_y1 = yy;
+                                dirty_y2 = yy + 1;
+                                if (line_x1 < dirty_x1)
+                                        dirty_x1 = line_x1;
+                                if (line_x2 > dirty_x2)
+                                        dirty_x2 = line_x2;
+                        }
+                }
+                if (dirty_y1 != -1)
+                        set_updated_size(dirty_x1, dirty_y1, dirty_x2 - dirty_x1, dirty_y2 - dirty_y1);
         }
-        set_updated_size(0, y1, w, y2 - y1);
+        blit_x = x;
+        blit_y = y;
+        blit_full = 0;
         //        set_updated_size(0, 0, w, h);
         blit_rect.w = w;
         blit_rect.h = h;
@@ -224,6 +293,10 @@ int sdl_renderer_init(SDL_Window *window) {
         else
                 screen_copy = NULL;
 
+        SDL_LockMutex(blitMutex);
+        blit_full = 1;
+        SDL_UnlockMutex(blitMutex);
+
         renderer = requested_render_driver.renderer_create();
         return renderer->init(window, requested_render_driver, screen_rect);
 }
@@ -247,9 +320,12 @@ int sdl_renderer_update(SDL_Window *window) {
         if (updated) {
                 updated = 0;
                 if (screen_copy) {
+                        int yy;
+
                         memcpy(&updated_rect_copy, &updated_rect, sizeof(updated_rect));
-                        memcpy(screen_copy->dat + (updated_rect.y * screen_copy->w * 4),
-                               screen->dat + (updated_rect.y * screen->w * 4), updated_rect.h * screen->w * 4);
+                        for (yy = updated_rect.y; yy < updated_rect.y + updated_rect.h; yy++)
+                                memcpy(screen_copy->dat + ((yy * screen_copy->w + updated_rect.x) * 4),
+                                       screen->dat + ((yy * screen->w + updated_rect.x) * 4), updated_rect.w * 4);
                 } else
                         renderer->update(window, updated_rect, screen);
                 texture_rect.w = blit_rect.w;
@@ -173,6 +173,7 @@ int mainthread(void *param) {
                         uint64_t start_time = timer_read();
                         uint64_t end_time;
                         drawits -= 10;
+                        video_frameskip_update(drawits);
                         if (drawits > 50)
                                 drawits = 0;
                         runpc();